@@ -0,0 +1,11 @@
+# Writes OUTPUT, a header defining ZPP_BUILD_ID: a hash of the compiler's sources and headers
+# Run by a custom command that depends on those files, so the id changes whenever the compiler does.
+# Expects OUTPUT, VERSION and FILES (a list) to be set with -D.
+set(digests "${VERSION}")
+foreach(file IN LISTS FILES)
+    file(SHA256 "${file}" digest)
+    string(APPEND digests "\n${digest}")
+endforeach()
+string(SHA256 id "${digests}")
+string(SUBSTRING "${id}" 0 16 id)
+file(WRITE "${OUTPUT}" "// Generated by cmake/build_id.cmake; do not edit\n#define ZPP_BUILD_ID \"${id}\"\n")
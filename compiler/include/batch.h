@@ -0,0 +1,35 @@
+#ifndef BATCH_H
+#define BATCH_H
+
+#include <functional>
+#include <ostream>
+#include <string>
+#include <vector>
+
+// BatchResult: Outcome of one script in a batch run
+struct BatchResult {
+    std::string path;
+    int status;          // 0 when the script compiled and ran to the end
+    std::string output;  // Everything the script printed, followed by its error if it failed
+    double seconds;      // Wall time for compiling and running it
+};
+
+// ScriptRunner: Compile and run one script, writing its output to out; returns its status
+// Called from several threads at once, so it must not touch shared state. Exceptions count as failures.
+using ScriptRunner = std::function<int(const std::string& path, std::ostream& out)>;
+
+// findScripts(): Every .zpp file under a directory, recursively, in sorted order
+std::vector<std::string> findScripts(const std::string& directory);
+
+// runBatch(): Run scripts concurrently on a work-stealing thread pool
+// Each worker starts with an even share of the scripts and steals from the others once its own run
+// out, so a few slow scripts don't leave cores idle. Results come back in the order of scripts.
+// threads = 0 uses one thread per core.
+std::vector<BatchResult> runBatch(const std::vector<std::string>& scripts, const ScriptRunner& run,
+                                  unsigned threads = 0);
+
+// reportBatch(): One status line per script, the output of failures, then a summary
+// Returns the number of scripts that failed.
+size_t reportBatch(const std::vector<BatchResult>& results, std::ostream& out);
+
+#endif // BATCH_H
@@ -0,0 +1,35 @@
+#ifndef BUILTINS_H
+#define BUILTINS_H
+
+#include "ir.h"
+#include <string>
+#include <vector>
+
+// NativeId enum: Builtins the interpreter implements as host functions, dispatched by CALL_NATIVE
+// The values index the interpreter's native function table, so entries are only ever appended.
+enum NativeId {
+    NATIVE_QUIT,
+    NATIVE_IS_KEY_DOWN,
+    NATIVE_UPDATE_INPUT,
+    NATIVE_SNAPSHOT,
+    NATIVE_COUNT
+};
+
+// Builtin: A function provided by the runtime instead of declared in ZPP source
+// Calls are resolved against the registry when IR is generated: builtins with a dedicated
+// opcode lower to it, the rest lower to CALL_NATIVE carrying their NativeId.
+struct Builtin {
+    std::string name;
+    IROpCode opcode;                         // Dedicated opcode, or CALL_NATIVE
+    int native;                              // NativeId for CALL_NATIVE, -1 otherwise
+    std::string returnType;
+    std::vector<std::string> parameterTypes; // "array" accepts any array type
+};
+
+// findBuiltin(): Registry entry for a call name, or nullptr for user functions
+const Builtin* findBuiltin(const std::string& name);
+
+// nativeBuiltin(): Registry entry for a CALL_NATIVE id
+const Builtin& nativeBuiltin(int native);
+
+#endif // BUILTINS_H
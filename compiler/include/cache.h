@@ -0,0 +1,45 @@
+#ifndef CACHE_H
+#define CACHE_H
+
+#include "ir.h"
+#include <cstdint>
+#include <string>
+
+// serializeIR()/deserializeIR(): Compact binary encoding of an IRProgram
+// deserializeIR() throws if the data is truncated or was written by another format version.
+std::string serializeIR(const IRProgram& program);
+IRProgram deserializeIR(const char* data, size_t size);
+
+// CompileCache class: Optimized IR stored on disk, keyed by source, compiler build and flags
+// Entries are written to a temporary file and renamed into place, so concurrent compilers
+// (processes or threads sharing one CompileCache) never see a partial entry. Hits refresh the entry's modification time, and the oldest
+// entries are evicted once the directory grows past its size limit.
+class CompileCache {
+public:
+    static const uint64_t kDefaultLimit = 64ull << 20;
+
+    explicit CompileCache(const std::string& directory, uint64_t limit = kDefaultLimit);
+
+    // defaultDirectory(): $ZPP_CACHE_DIR, else $XDG_CACHE_HOME/zpp, else $HOME/.cache/zpp
+    static std::string defaultDirectory();
+
+    // key(): Cache key for a source file compiled with the given flags
+    static std::string key(const std::string& source, const std::string& flags);
+
+    // load(): Read an entry through mmap; false on a miss or an unreadable entry
+    bool load(const std::string& key, IRProgram& program);
+
+    // store(): Write an entry and evict old ones; failures leave the cache unchanged
+    void store(const std::string& key, const IRProgram& program);
+
+    const std::string& path() const { return directory; }
+
+private:
+    std::string directory;
+    uint64_t limit;
+
+    std::string entryPath(const std::string& key) const;
+    void evict();
+};
+
+#endif // CACHE_H
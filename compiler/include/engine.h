@@ -0,0 +1,238 @@
+#ifndef ENGINE_H
+#define ENGINE_H
+
+#include "builtins.h"
+#include "cache.h"
+#include "ir.h"
+#include "native.h"
+#include "profile.h"
+#include "value.h"
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <iostream>
+#include <list>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <stdexcept>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+class Graphics;
+struct Snapshot;
+
+// Embedding API: an Engine compiles scripts into Modules, and each run of a Module is an Instance.
+//
+//   double fastNoise(double x, double y) { ... }
+//
+//   Engine engine;
+//   engine.bind("fastNoise", &fastNoise);  // Callable from ZPP as fastNoise(x, y)
+//   ModulePtr module = engine.compileFile("game.zpp");
+//   Instance instance(module);
+//   instance.run();
+//
+// Modules are immutable, so any number of Instances, on any threads, can share one.
+
+// EngineConfig: Settings for everything an Engine compiles
+struct EngineConfig {
+    bool useCache = true;                                     // Reuse optimized IR from the on-disk cache
+    std::string cacheDir = CompileCache::defaultDirectory();
+    uint64_t cacheLimit = CompileCache::kDefaultLimit;
+    std::string profileUse;                                   // Recorded profile to optimize with, if any
+    size_t memoryCacheEntries = 0;                            // Compiled modules kept in memory; 0 keeps none
+};
+
+// Module class: A compiled and optimized program, ready to run
+// Everything the interpreter needs per function is resolved once here rather than on every run.
+class Module {
+public:
+    // Constructor: Takes over optimized IR; text identifies the program for profiles
+    // natives are the bound functions the IR was generated against; it must call no others.
+    // files are the source files it was compiled from, if any.
+    explicit Module(IRProgram program, std::string text = "",
+                    std::shared_ptr<const std::vector<NativeBinding>> natives = nullptr,
+                    std::vector<std::string> files = {});
+    Module(const Module&) = delete;
+    Module& operator=(const Module&) = delete;
+
+    const IRProgram& program() const { return ir; }
+    const std::string& text() const { return programText; }
+    const std::vector<std::string>& files() const { return sourceFiles; }
+    bool hasFunction(const std::string& name) const { return functions.count(name) != 0; }
+
+    // Function: An IR function with its label addresses and register count, as the interpreter uses it
+    struct Function {
+        const IRFunction* func;
+        std::unordered_map<std::string, size_t> labels;
+        size_t registerCount;                              // Temps are numbered 0..registerCount-1
+        const std::vector<NativeBinding>* natives;         // Bound natives of the module it came from
+    };
+
+private:
+    friend class Instance;
+
+    IRProgram ir;
+    std::string programText;
+    std::vector<std::string> sourceFiles;
+    std::map<std::string, Function> functions;
+    std::shared_ptr<const std::vector<NativeBinding>> natives;  // Indexed by CALL_NATIVE id - NATIVE_COUNT
+};
+
+using ModulePtr = std::shared_ptr<const Module>;
+
+// Engine class: Compiles scripts into Modules
+// compile() may be called from several threads at once; bind() functions before that.
+class Engine {
+public:
+    explicit Engine(EngineConfig config = EngineConfig());
+
+    // bind(): Make a C++ function callable from scripts compiled from now on
+    // Parameter and return types may be int, double, bool, std::string (or const std::string&),
+    // ArrayRef or Value; a leading Instance& parameter receives the caller.
+    // Throws if the name is taken by a builtin or an earlier binding.
+    template <typename Function>
+    void bind(const std::string& name, Function* function) {
+        addNative(makeNative(name, function));
+    }
+
+    // compile(): Compile a script and everything it imports
+    // Imports resolve against path's directory, or the working directory when path is empty.
+    ModulePtr compile(const std::string& source, const std::string& path = "") const;
+
+    // compileFile(): Read and compile a script; throws if it can't be read
+    ModulePtr compileFile(const std::string& path) const;
+
+    // compileProgram(): Lower and optimize an already parsed program, without imports or caching
+    // Calls to functions it doesn't define are resolved by the Instance when they run. Without
+    // inlining, calls to the ones it does define are too, so a later Instance::load() replaces them
+    // for these callers as well.
+    ModulePtr compileProgram(const ProgramPtr& ast, bool inlining = true) const;
+
+    const EngineConfig& config() const { return settings; }
+
+private:
+    EngineConfig settings;
+    std::shared_ptr<const std::vector<NativeBinding>> natives;  // Replaced, never changed, by bind()
+    std::vector<Builtin> nativeCalls;                          // The same functions as IR generation sees them
+
+    void addNative(NativeBinding binding);
+
+    // Compiled modules by cache key, most recently used first
+    mutable std::mutex memoryLock;
+    mutable std::list<std::pair<std::string, ModulePtr>> memoryEntries;
+    mutable std::unordered_map<std::string, std::list<std::pair<std::string, ModulePtr>>::iterator> memoryIndex;
+};
+
+// ScriptInterrupted: Thrown out of run() and call() when a script hits a limit or is interrupted
+class ScriptInterrupted : public std::runtime_error {
+public:
+    using std::runtime_error::runtime_error;
+};
+
+// Instance class: One run of a Module, with its own call stack, streams and window
+// An Instance is used by one thread at a time; create one per concurrent run.
+class Instance {
+public:
+    explicit Instance(ModulePtr module, std::istream& in = std::cin, std::ostream& out = std::cout,
+                      std::ostream& err = std::cerr);
+    ~Instance();
+    Instance(const Instance&) = delete;
+    Instance& operator=(const Instance&) = delete;
+
+    // run(): Run main until it returns or the program ends itself (quit() or closing the window)
+    void run();
+
+    // call(): Run one function with arguments and return its result; throws if it doesn't exist
+    Value call(const std::string& function, const std::vector<Value>& args = {});
+
+    // load(): Add a module's functions to this instance, replacing any of the same name
+    // Calls from every module loaded so far see the new definitions, unless their module inlined the old
+    // ones; the REPL compiles without inlining, see Engine::compileProgram().
+    void load(ModulePtr more);
+
+    // reload(): Switch to a new version of the program at the next display() call
+    // Safe to call from any thread, as a file watcher does. Running functions that changed continue
+    // in the new code from the same display() or call they had reached, keeping the locals the new
+    // code still uses; one whose code no longer has that point finishes in its old version.
+    // The window and everything else the instance holds stay as they are.
+    void reload(ModulePtr next);
+
+    // callInScope(): Call a function whose locals start as variables and are left there afterwards,
+    // whether it returns or fails; the REPL keeps its variables this way from one entry to the next
+    Value callInScope(const std::string& function, std::map<std::string, Value>& variables);
+
+    // Snapshots let a script skip its start-up work on later runs. When the script calls snapshot(), its
+    // call stack, variables, temps and arrays are saved, and snapshot() returns 0; an Instance of the
+    // same program that restores the file resumes right after that call, where it returns 1. Input
+    // already read and the window are not part of a snapshot, so it has to be taken before screen().
+    void setSnapshotFile(const std::string& path) { snapshotPath = path; }  // Where snapshot() saves; none by default
+
+    // restore(): Make the next run() resume from a snapshot
+    // false, changing nothing, if path doesn't hold a snapshot of this program as compiled now.
+    bool restore(const std::string& path);
+
+    // halted(): The program ended itself; later calls return immediately
+    bool halted() const { return stopped; }
+
+    // Limits for scripts that can't be trusted to finish; exceeding one throws ScriptInterrupted.
+    // Both apply to each run() or call() from the start and are off (0) by default.
+    void setInstructionLimit(uint64_t count) { instructionLimit = count; }  // Roughly, instructions executed
+    void setTimeLimit(std::chrono::milliseconds limit) { timeLimit = limit; }  // Wall-clock time
+
+    // interrupt(): Stop the script running now; safe to call from any thread
+    void interrupt() { stopRequest.store(kInterrupted, std::memory_order_relaxed); }
+
+    // memoryStats(): Arrays and strings this Instance has allocated so far
+    const MemoryStats& memoryStats() const { return heap->stats(); }
+
+    void setProfile(Profile* recorder) { profile = recorder; }  // Count executions for profile-guided optimization
+    void setHeadless(bool value) { headless = value; }          // screen() opens no window, so drawing does nothing
+
+    // Used by native functions
+    std::istream& input() { return in; }
+    std::ostream& output() { return out; }
+    Graphics* window() { return graphics; }
+    void closeWindow();
+
+private:
+    ModulePtr module;
+    std::vector<ModulePtr> loaded;                                     // Added by load(), oldest first
+    std::unordered_map<std::string, const Module::Function*> overrides;  // Their functions, by name
+    std::istream& in;
+    std::ostream& out;
+    std::ostream& err;
+    Profile* profile;
+    bool headless;
+    bool stopped;
+    Graphics* graphics;  // Window opened by screen(), if any
+    // Limits, checked at backward jumps and calls. Nothing else is counted, so a check costs a
+    // subtraction and a relaxed load: fuel stays huge when there is no instruction limit.
+    enum StopRequest { kRunning, kInterrupted, kTimedOut };
+    uint64_t instructionLimit;
+    std::chrono::milliseconds timeLimit;
+    std::atomic<int> stopRequest;  // Set by interrupt() and by the watchdog thread
+    std::mutex reloadLock;
+    ModulePtr pendingReload;             // Set by reload(), taken at the next display()
+    std::atomic<bool> reloadPending;
+    uint64_t fuel;                 // Instructions left before checkLimits() has to look
+    int depth;                     // Nested execute() calls, from natives that call back into the script
+
+    std::string snapshotPath;
+    std::unique_ptr<Snapshot> resumeFrom;  // Set by restore(), taken by the next run()
+
+    ArrayHeap* heap;     // Pool for the script's arrays; released rather than deleted, as arrays may outlive us
+    std::string scratch; // CONCAT builds here when its result register is its right operand or holds no string
+
+    void storeString(Value& slot, const std::string& text);
+    void charge(uint64_t cost);
+    size_t jump(size_t from, size_t to);
+    void checkLimits(uint64_t cost);
+    const Module::Function* findFunction(const std::string& name) const;  // nullptr if not defined
+    uint64_t fingerprint() const;  // Identifies the code snapshots point into
+    Value execute(const Module::Function& entry, const std::vector<Value>& args,
+                  std::map<std::string, Value>* variables = nullptr, const Snapshot* resume = nullptr);
+};
+
+#endif // ENGINE_H
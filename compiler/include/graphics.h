@@ -1,72 +1,60 @@
 #ifndef GRAPHICS_H
 #define GRAPHICS_H
-#include <SDL2/SDL.h>
-#include <SDL2/SDL_image.h>
 #include <string>
-#include <memory>
-#include <unordered_map>
 
-// Graphics class: SDL2-based graphics rendering engine
-// Provides 2D drawing primitives, image handling, and input management
+// Graphics class: Window, 2D drawing and input, as scripts use them through screen() and friends
+// The implementation lives in the graphics plugin (SdlGraphics), so console scripts never load SDL;
+// openGraphics() loads it the first time a window is opened.
 class Graphics {
 public:
-    // Constructor: Initialize graphics system with window
-    Graphics(int width, int height, const std::string& title);
-    ~Graphics();
-    
+    virtual ~Graphics() = default;
+
     // Window management
-    bool isOpen() const { return open; }              // Check if window is open
-    bool shouldClose() const { return !open; }       // Check if user closed window
-    void handleEvents();                             // Process SDL events (input, close button)
-    void clear(int r = 0, int g = 0, int b = 0);   // Clear screen to color
-    void present();                                  // Update display with drawn content
-    void close();                                    // Close the window
-    void setTitle(const std::string& title);         // Change window title
-    
+    virtual bool isOpen() const = 0;                       // Check if window is open
+    virtual bool shouldClose() const = 0;                  // Check if user closed window
+    virtual void handleEvents() = 0;                       // Process events (input, close button)
+    virtual void clear(int r = 0, int g = 0, int b = 0) = 0;  // Clear screen to color
+    virtual void present() = 0;                            // Update display with drawn content
+    virtual void close() = 0;                              // Close the window
+    virtual void setTitle(const std::string& title) = 0;   // Change window title
+
     // Drawing primitives - all use RGB(A) color format (0-255)
-    void drawPixel(int x, int y, int r, int g, int b, int a = 255);  // Draw single pixel
-    void drawRect(int x, int y, int w, int h, int r, int g, int b, int filled = 0);      // Draw rectangle (outline or filled)
-    void drawLine(int x1, int y1, int x2, int y2, int r, int g, int b);                 // Draw line
-    void drawCircle(int x, int y, int radius, int r, int g, int b, int filled = 0);    // Draw circle
-    void drawTriangle(int x1, int y1, int x2, int y2, int x3, int y3, int r, int g, int b, int filled = 0);  // Draw triangle
-    void fillTriangle(int x1, int y1, int x2, int y2, int x3, int y3, int r, int g, int b);  // Draw filled triangle
-    
-    // Filled shape helpers
-    void fillRect(int x, int y, int w, int h, int r, int g, int b);    // Draw filled rectangle
-    void fillCircle(int x, int y, int radius, int r, int g, int b);   // Draw filled circle
-    
+    virtual void drawPixel(int x, int y, int r, int g, int b, int a = 255) = 0;
+    virtual void drawRect(int x, int y, int w, int h, int r, int g, int b, int filled = 0) = 0;
+    virtual void drawLine(int x1, int y1, int x2, int y2, int r, int g, int b) = 0;
+    virtual void drawCircle(int x, int y, int radius, int r, int g, int b, int filled = 0) = 0;
+    virtual void drawTriangle(int x1, int y1, int x2, int y2, int x3, int y3, int r, int g, int b,
+                              int filled = 0) = 0;
+    virtual void fillTriangle(int x1, int y1, int x2, int y2, int x3, int y3, int r, int g, int b) = 0;
+    virtual void fillRect(int x, int y, int w, int h, int r, int g, int b) = 0;
+    virtual void fillCircle(int x, int y, int radius, int r, int g, int b) = 0;
+
     // Image/Texture support for sprite rendering
-    bool loadImage(const std::string& filename, const std::string& name);  // Load image file
-    void blitImage(const std::string& name, int x, int y);                 // Draw image at position
-    void blitImageScaled(const std::string& name, int x, int y, int w, int h);  // Draw scaled image
-    void freeImage(const std::string& name);                              // Free single image
-    void freeAllImages();                                                 // Free all loaded images
-    bool imageExists(const std::string& name) const;                      // Check if image is loaded
-    
+    virtual bool loadImage(const std::string& filename, const std::string& name) = 0;
+    virtual void blitImage(const std::string& name, int x, int y) = 0;
+    virtual void blitImageScaled(const std::string& name, int x, int y, int w, int h) = 0;
+    virtual void freeImage(const std::string& name) = 0;
+    virtual void freeAllImages() = 0;
+    virtual bool imageExists(const std::string& name) const = 0;
+
     // Text rendering (basic support)
-    void drawText(const std::string& text, int x, int y, int r, int g, int b);
-    
+    virtual void drawText(const std::string& text, int x, int y, int r, int g, int b) = 0;
+
     // Input handling
-    bool isKeyPressed(SDL_Keycode key);          // Check if key is currently pressed
-    bool getMousePos(int& x, int& y);            // Get current mouse position
-    bool isMouseButtonDown(int button = 1);      // Check if mouse button is pressed (1=left, 2=middle, 3=right)
-    
-    // Property accessors
-    int getWidth() const { return width; }
-    int getHeight() const { return height; }
-    SDL_Renderer* getRenderer() const { return renderer; }
-    SDL_Window* getWindow() const { return window; }
-    
-private:
-    SDL_Window* window;                                          // SDL window pointer
-    SDL_Renderer* renderer;                                      // SDL 2D renderer
-    std::unordered_map<std::string, SDL_Texture*> textures;     // Loaded image cache
-    int width, height;                                           // Window dimensions
-    bool open;                                                   // Whether window is open
-    const Uint8* keyState;                                       // Current keyboard state
-    
-    // Helper for midpoint circle algorithm
-    void midpointCircle(int x, int y, int radius, int r, int g, int b);
+    virtual bool isKeyPressed(const std::string& key) = 0;  // "a", "space", "left", "escape", ...
+    virtual bool getMousePos(int& x, int& y) = 0;
+    virtual bool isMouseButtonDown(int button = 1) = 0;     // 1=left, 2=middle, 3=right
+
+    virtual int getWidth() const = 0;
+    virtual int getHeight() const = 0;
 };
 
+// openGraphics(): Open a window, loading the graphics plugin first if this is the first one
+// The plugin is $ZPP_GRAPHICS_PLUGIN if set, else libzpp_graphics.so next to the executable or on
+// the library path. Throws if it can't be loaded or the window can't be created.
+Graphics* openGraphics(int width, int height, const std::string& title);
+
+// GraphicsFactory: What the plugin exports as zppOpenGraphics; sets error and returns nullptr on failure
+using GraphicsFactory = Graphics* (*)(int width, int height, const char* title, std::string* error);
+
 #endif // GRAPHICS_H
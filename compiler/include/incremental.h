@@ -0,0 +1,50 @@
+#ifndef INCREMENTAL_H
+#define INCREMENTAL_H
+
+#include "builtins.h"
+#include "cache.h"
+#include "lexer.h"
+#include "profile.h"
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// FunctionUnit: One top-level function located in the token stream
+struct FunctionUnit {
+    std::string name;
+    size_t begin;                      // First token of the declaration
+    size_t end;                        // One past the closing brace
+    uint64_t fingerprint;              // Hash of the token types and text, positions excluded
+    std::vector<std::string> callees;  // Names called from the body, builtins included
+};
+
+// splitFunctions(): Cut a token stream into top-level functions by brace matching
+// Returns false when the stream does not split cleanly; the parser then reports the error.
+bool splitFunctions(const std::vector<Token>& tokens, std::vector<FunctionUnit>& units);
+
+// IncrementalCompiler class: Compiles a script function by function through a CompileCache
+// A function's optimized IR is reused while its own tokens and those of every function it can
+// reach through calls are unchanged; callee bodies matter because the optimizer inlines them.
+// Only changed functions and their callers are parsed, lowered and optimized again.
+class IncrementalCompiler {
+public:
+    // flags must identify the profile and natives, which change the IR without changing the source
+    IncrementalCompiler(CompileCache& cache, const std::string& flags, const Profile* profile = nullptr,
+                        const std::vector<Builtin>* natives = nullptr);
+
+    IRProgram compile(const std::string& source);
+
+    // Functions taken from the cache and compiled from source by the last compile()
+    size_t reusedCount() const { return reused; }
+    size_t compiledCount() const { return compiled; }
+
+private:
+    CompileCache& cache;
+    std::string flags;
+    const Profile* profile;
+    const std::vector<Builtin>* natives;
+    size_t reused;
+    size_t compiled;
+};
+
+#endif // INCREMENTAL_H
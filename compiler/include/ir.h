@@ -5,6 +5,7 @@
 #include <vector>
 #include <memory>
 #include <string>
+#include <cstdint>
 #include <unordered_map>
 
 // IROpCode enum: Represents all intermediate representation operation codes
@@ -19,6 +20,18 @@ enum class IROpCode {
     NEG,
     CONCAT,  // String concatenation
 
+    // Integer-specialized arithmetic and comparison, selected from profiles;
+    // fall back to the generic opcode when an operand is not an int
+    ADD_INT,
+    SUB_INT,
+    MUL_INT,
+    EQ_INT,
+    NE_INT,
+    LT_INT,
+    GT_INT,
+    LE_INT,
+    GE_INT,
+
     // Logical
     AND,
     OR,
@@ -37,7 +50,11 @@ enum class IROpCode {
     JZ,      // Jump if zero
     JNZ,     // Jump if not zero
     CALL,
+    CALL_NATIVE, // Builtin implemented by the interpreter; native is its NativeId
     RET,
+    TAIL_CALL,  // Call that reuses the caller's frame; the callee returns to the caller's caller
+    JUMP_TABLE, // Indexed jump: cases cover consecutive values from the first one; label is the default
+    SWITCH,     // Binary search over sorted cases; label is the default
 
     // Memory
     LOAD,
@@ -46,6 +63,8 @@ enum class IROpCode {
     STORE_GLOBAL,
     LOAD_INDEX,
     STORE_INDEX,
+    LOAD_INDEX_UNCHECKED,   // Index proven in bounds by the optimizer
+    STORE_INDEX_UNCHECKED,
 
     // Literals
     LOAD_INT,
@@ -97,8 +116,11 @@ struct IRInstruction {
     IRValue result;
     std::string label;  // For LABEL instructions
     std::string prompt; // For INPUT instructions
+    std::vector<std::pair<int, std::string>> cases;  // For JUMP_TABLE/SWITCH: value -> label, sorted
+    uint64_t site;      // Stable key for profiling: source function and position, 0 if synthesized
+    int native;         // For CALL_NATIVE: index into the interpreter's native table
     
-    IRInstruction(IROpCode op) : opcode(op) {}
+    IRInstruction(IROpCode op) : opcode(op), site(0), native(-1) {}
     
     std::string toString() const;
 };
@@ -115,14 +137,18 @@ struct IRProgram {
     std::unordered_map<std::string, std::string> globalVariables;
 };
 
+struct Builtin;
+
 class IRGenerator {
 public:
-    explicit IRGenerator(const ProgramPtr& ast);
+    // Constructor: natives are host functions bound by an embedder, called like builtins
+    explicit IRGenerator(const ProgramPtr& ast, const std::vector<Builtin>* natives = nullptr);
     
     IRProgram generate();
     
 private:
     ProgramPtr ast;
+    const std::vector<Builtin>* natives;
     IRProgram program;
     IRFunction* currentFunction;
     int tempCounter;
@@ -136,6 +162,7 @@ private:
     void visitBlockStatement(const std::shared_ptr<BlockStatement>& block);
     void visitReturnStatement(const std::shared_ptr<ReturnStatement>& ret);
     void visitIfStatement(const std::shared_ptr<IfStatement>& ifStmt);
+    bool visitSwitchChain(const std::shared_ptr<IfStatement>& ifStmt);  // elif chain on one variable
     void visitWhileStatement(const std::shared_ptr<WhileStatement>& whileStmt);
     void visitForStatement(const std::shared_ptr<ForStatement>& forStmt);
     void visitVariableDecl(const std::shared_ptr<VariableDecl>& varDecl);
@@ -152,14 +179,21 @@ private:
     IRValue visitArrayLiteral(const std::shared_ptr<ArrayLiteral>& literal);
     IRValue visitArrayElementAssignment(const std::shared_ptr<ArrayElementAssignment>& assign);
     
+    // Lower a condition straight to branches: jumps to target when the
+    // condition's truth value equals jumpIfTrue, falls through otherwise.
+    // && and || only evaluate their right operand when it can change the result.
+    void visitCondition(const ExpressionPtr& expr, const std::string& target, bool jumpIfTrue);
+    
     // Helper methods
     IRValue createTemp();
     std::string createLabel();
+    void emitLabel(const std::string& label);
     void emitInstruction(const IRInstruction& instr);
     IROpCode tokenTypeToOpCode(TokenType type);
 };
 
 // Utility functions
 std::string opCodeToString(IROpCode opcode);
+IROpCode genericOpCode(IROpCode opcode);  // ADD_INT -> ADD etc.; other opcodes unchanged
 
 #endif // IR_H
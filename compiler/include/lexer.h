@@ -42,6 +42,7 @@ enum class TokenType {
     QUIT,
     IS_KEY_DOWN,
     UPDATE_INPUT,
+    IMPORT,
     
     // Operators
     PLUS,
@@ -0,0 +1,33 @@
+#ifndef MODULES_H
+#define MODULES_H
+
+#include "builtins.h"
+#include "cache.h"
+#include "ir.h"
+#include "profile.h"
+#include <string>
+#include <vector>
+
+// SourceModule: One source file of a program, as found by following imports
+struct SourceModule {
+    std::string path;             // Canonical path, or "<stdin>" for a script read from standard input
+    std::string source;
+    std::vector<size_t> imports;  // Indices of the modules this one imports
+};
+
+// loadModules(): The entry module followed by everything it imports, transitively
+// Import paths are relative to the importing file; each file is loaded once, so cycles are allowed.
+std::vector<SourceModule> loadModules(const std::string& entryPath, const std::string& entrySource);
+
+// programText(): Every module's path and source, the identity of the whole program for caches and profiles
+std::string programText(const std::vector<SourceModule>& modules);
+
+// compileModules(): Compile every module on a thread pool and link the functions into one program
+// Modules compile independently, through the cache when one is given; calls between modules are
+// linked by name and never inlined. natives are embedder-bound functions callable from every module.
+// threads = 0 uses one thread per core.
+IRProgram compileModules(const std::vector<SourceModule>& modules, CompileCache* cache, const std::string& flags,
+                         const Profile* profile = nullptr, const std::vector<Builtin>* natives = nullptr,
+                         unsigned threads = 0);
+
+#endif // MODULES_H
@@ -0,0 +1,181 @@
+#ifndef NATIVE_H
+#define NATIVE_H
+
+#include "value.h"
+#include <cstddef>
+#include <stdexcept>
+#include <string>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+class Instance;
+
+// Typed native bindings: C++ functions callable from ZPP like builtins
+// Engine::bind() deduces a function's signature and instantiates a thunk for it. At a call the thunk
+// reads each argument straight out of the caller's register, converting only when the register
+// holds a different type than the parameter, and calls the function directly.
+
+const size_t kMaxNativeArity = 16;
+
+// NativeThunk: Calls a bound function with its arguments; args point at the caller's registers
+using NativeThunk = Value (*)(Instance& instance, void (*function)(), const Value* const* args);
+
+// NativeBinding: One bound function
+struct NativeBinding {
+    std::string name;
+    std::string returnType;
+    std::vector<std::string> parameterTypes;
+    void (*function)();  // The bound function, type-erased; its thunk casts it back
+    NativeThunk thunk;
+};
+
+// NativeType<T>: How a C++ parameter or return type maps onto ZPP values
+template <typename T>
+struct NativeType {
+    static_assert(sizeof(T) == 0, "native functions take and return int, double, bool, std::string, "
+                                  "ArrayRef or Value");
+};
+
+template <>
+struct NativeType<int> {
+    static const char* name() { return "int"; }
+    static int from(const Value& v) {
+        if (const int* i = std::get_if<int>(&v)) return *i;
+        return valueToInt(v);
+    }
+};
+
+template <>
+struct NativeType<double> {
+    static const char* name() { return "float"; }
+    static double from(const Value& v) {
+        if (const double* d = std::get_if<double>(&v)) return *d;
+        if (const int* i = std::get_if<int>(&v)) return *i;
+        if (const std::string* s = std::get_if<std::string>(&v)) return std::stod(*s);
+        return valueToInt(v);
+    }
+};
+
+template <>
+struct NativeType<bool> {
+    static const char* name() { return "bool"; }
+    static bool from(const Value& v) {
+        if (const bool* b = std::get_if<bool>(&v)) return *b;
+        return valueToBool(v);
+    }
+};
+
+template <>
+struct NativeType<ArrayRef> {
+    static const char* name() { return "array"; }
+    static const ArrayRef& from(const Value& v) {
+        if (const auto* array = std::get_if<ArrayRef>(&v)) return *array;
+        throw std::runtime_error("Expected an array argument");
+    }
+};
+
+template <>
+struct NativeType<Value> {
+    static const char* name() { return "any"; }
+    static const Value& from(const Value& v) { return v; }
+};
+
+template <>
+struct NativeType<std::string> {
+    static const char* name() { return "string"; }
+};
+
+template <>
+struct NativeType<void> {
+    static const char* name() { return "void"; }
+};
+
+// NativeArg<T>: One converted argument, alive for the duration of the call
+template <typename T>
+class NativeArg {
+public:
+    explicit NativeArg(const Value& v) : value(NativeType<T>::from(v)) {}
+    T get() const { return value; }
+
+private:
+    T value;
+};
+
+// Strings are passed by reference to the register when it already holds one
+template <>
+class NativeArg<std::string> {
+public:
+    explicit NativeArg(const Value& v) : text(std::get_if<std::string>(&v)) {
+        if (!text) {
+            converted = valueToString(v);
+            text = &converted;
+        }
+    }
+    const std::string& get() const { return *text; }
+
+private:
+    const std::string* text;
+    std::string converted;
+};
+
+template <>
+class NativeArg<Value> {
+public:
+    explicit NativeArg(const Value& v) : value(v) {}
+    const Value& get() const { return value; }
+
+private:
+    const Value& value;
+};
+
+template <typename T>
+using NativeParam = NativeArg<std::remove_cv_t<std::remove_reference_t<T>>>;
+
+// invokeNative(): Convert the arguments, make the call and box only the result
+template <typename R, typename... Args, typename Call, size_t... I>
+Value invokeNative(const Call& call, const Value* const* args, std::index_sequence<I...>) {
+    if constexpr (std::is_void<R>::value) {
+        call(NativeParam<Args>(*args[I]).get()...);
+        return Value();
+    } else {
+        return Value(call(NativeParam<Args>(*args[I]).get()...));
+    }
+}
+
+template <typename R, typename... Args>
+Value nativeThunk(Instance&, void (*function)(), const Value* const* args) {
+    auto target = reinterpret_cast<R (*)(Args...)>(function);
+    return invokeNative<R, Args...>(target, args, std::index_sequence_for<Args...>());
+}
+
+// Functions whose first parameter is Instance& also receive the calling instance
+template <typename R, typename... Args>
+Value instanceThunk(Instance& instance, void (*function)(), const Value* const* args) {
+    auto target = reinterpret_cast<R (*)(Instance&, Args...)>(function);
+    auto call = [&](auto&&... converted) -> R { return target(instance, converted...); };
+    return invokeNative<R, Args...>(call, args, std::index_sequence_for<Args...>());
+}
+
+// makeNative(): Binding for a function pointer, with ZPP types deduced from its signature
+template <typename R, typename... Args>
+NativeBinding makeNative(const std::string& name, R (*function)(Args...)) {
+    static_assert(sizeof...(Args) <= kMaxNativeArity, "too many parameters for a native function");
+    return {name,
+            NativeType<std::remove_cv_t<R>>::name(),
+            {NativeType<std::remove_cv_t<std::remove_reference_t<Args>>>::name()...},
+            reinterpret_cast<void (*)()>(function),
+            &nativeThunk<R, Args...>};
+}
+
+template <typename R, typename... Args>
+NativeBinding makeNative(const std::string& name, R (*function)(Instance&, Args...)) {
+    static_assert(sizeof...(Args) <= kMaxNativeArity, "too many parameters for a native function");
+    return {name,
+            NativeType<std::remove_cv_t<R>>::name(),
+            {NativeType<std::remove_cv_t<std::remove_reference_t<Args>>>::name()...},
+            reinterpret_cast<void (*)()>(function),
+            &instanceThunk<R, Args...>};
+}
+
+#endif // NATIVE_H
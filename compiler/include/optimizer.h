@@ -0,0 +1,92 @@
+#ifndef OPTIMIZER_H
+#define OPTIMIZER_H
+
+#include "ir.h"
+#include "profile.h"
+#include <set>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+// LoopInfo: A natural loop found in a function's IR
+// Loops are contiguous instruction ranges closed by a backward jump to the header label.
+// Top-tested loops (as lowered from while/for) test at the header and jump back with JMP;
+// rotated loops test once before the header and once more at the latch with JNZ.
+struct LoopInfo {
+    size_t header;               // Index of the header LABEL
+    size_t latch;                // Index of the backward jump
+    size_t exitTest;             // Index of the conditional branch that decides the loop
+    std::string headerLabel;
+    std::string exitLabel;       // Label directly after the latch
+    bool rotated;                // Exit test sits at the bottom of the loop
+    bool singleEntry;            // Only the latch jumps to the header, nothing jumps in or out
+
+    // Induction variable: a local stepped by a constant exactly once per iteration
+    bool hasInduction;
+    IRValue inductionVar;
+    size_t incrementIndex;       // Index of the STORE that steps the induction variable
+    long step;
+    bool hasStart;               // Initial value known at compile time
+    long start;
+
+    // Exit test: inductionVar <compare> bound
+    IROpCode compare;
+    IRValue bound;
+    bool boundInvariant;         // Bound does not change inside the loop
+    bool hasConstantBound;
+    long boundValue;
+
+    long tripCount;              // Number of iterations, or -1 when unknown
+
+    LoopInfo()
+        : header(0), latch(0), exitTest(0), rotated(false), singleEntry(false),
+          hasInduction(false), incrementIndex(0), step(0), hasStart(false), start(0),
+          compare(IROpCode::NOP), boundInvariant(false), hasConstantBound(false),
+          boundValue(0), tripCount(-1) {}
+};
+
+// findLoops(): Locate loops and analyze their induction variables and trip counts
+// Loops are returned innermost-last in instruction order of their latch.
+std::vector<LoopInfo> findLoops(const IRFunction& func);
+
+// IROptimizer class: Rewrites the IR produced by IRGenerator into faster equivalent IR
+// Passes run per function, in the order listed in optimize()
+class IROptimizer {
+public:
+    // Constructor: The optimizer edits the given program in place
+    // A recorded profile, when given, steers inlining, block layout and opcode selection.
+    explicit IROptimizer(IRProgram& program, const Profile* profile = nullptr);
+
+    // optimize(): Run the full pass pipeline over every function
+    // Without inlining every call stays a CALL, so callers see a callee replaced after compiling.
+    void optimize(bool inlining = true);
+
+    // optimize(only): Run the pipeline over the named functions; the rest only serve as inlining sources
+    void optimize(const std::set<std::string>& only);
+
+    // Individual passes, usable on their own
+    void inlineCalls();                          // Copy small non-recursive callees into their callers
+    void unrollLoops(IRFunction& func);          // Full or partial unrolling of counted loops
+    void foldConstants(IRFunction& func);        // Evaluate integer operations on known constants
+    void optimizeLoops(IRFunction& func);        // Strength reduction and loop rotation
+    void eliminateBoundsChecks(IRFunction& func); // Unchecked indexing where the range is proven
+    void simplifyControlFlow(IRFunction& func);  // Jump threading, dead block removal, block layout
+    void eliminateTailCalls(IRFunction& func);   // Self tail calls become jumps, others TAIL_CALL
+    void allocateRegisters(IRFunction& func);    // Linear scan: temps share registers when not live together
+    void specializeTypes(IRFunction& func);      // Int-only opcodes where the profile saw only ints
+
+private:
+    IRProgram& program;
+    const Profile* profile;
+    int nameCounter;                             // Suffix for compiler-generated locals
+
+    void inlineInto(IRFunction& caller, const std::vector<bool>& recursive,
+                    const std::unordered_map<std::string, int>& callSites);
+    void optimizeFunction(IRFunction& func);                       // Every per-function pass, in order
+    bool unrollLoop(IRFunction& func, const LoopInfo& loop, std::set<std::string>& done);
+    bool placeColdBlocks(IRFunction& func);                        // Move rarely run branches out of line
+    bool strengthReduce(IRFunction& func, const LoopInfo& loop);   // i * c -> running sum
+    bool rotateLoop(IRFunction& func, const LoopInfo& loop);       // Single compare-and-branch per iteration
+};
+
+#endif // OPTIMIZER_H
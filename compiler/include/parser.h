@@ -199,6 +199,7 @@ struct FunctionDecl : public ASTNode {
 };
 
 struct Program : public ASTNode {
+    std::vector<std::string> imports;  // Paths from `import "file.zpp";`, as written
     std::vector<FunctionDeclPtr> functions;
 };
 
@@ -222,6 +223,7 @@ private:
     void consume(TokenType type, const std::string& message);
 
     // Parsing methods
+    std::string parseImport();
     FunctionDeclPtr parseFunction();
     StatementPtr parseStatement();
     StatementPtr parseBlockStatement();
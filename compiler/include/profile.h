@@ -0,0 +1,53 @@
+#ifndef PROFILE_H
+#define PROFILE_H
+
+#include <cstdint>
+#include <string>
+#include <unordered_map>
+
+// hashText(): 64-bit FNV-1a hash, used to tie profiles to the source they were recorded from
+uint64_t hashText(const std::string& text);
+
+// Operand type bits recorded per instruction
+enum ProfileType : uint32_t {
+    PROFILE_INT = 1,
+    PROFILE_DOUBLE = 2,
+    PROFILE_STRING = 4,
+    PROFILE_BOOL = 8,
+    PROFILE_ARRAY = 16
+};
+
+// ProfileCounts: Runtime observations for one instruction site
+struct ProfileCounts {
+    uint64_t executed;   // Times the instruction ran
+    uint64_t trueCount;  // Conditional branches: times the condition was true
+    uint32_t types;      // ProfileType bits seen in the operands
+
+    ProfileCounts() : executed(0), trueCount(0), types(0) {}
+};
+
+// Profile class: Per-site counters keyed by IRInstruction::site
+// Recorded by the interpreter and read back by the optimizer on a later compile.
+// File format, one record per line:
+//   zpp-profile 1
+//   source <source hash>
+//   <site> <executed> <trueCount> <types>
+class Profile {
+public:
+    void recordBranch(uint64_t site, bool condition);
+    void recordCall(uint64_t site);
+    void recordTypes(uint64_t site, uint32_t types);
+
+    // find(): Counters for a site, or nullptr if it never ran
+    const ProfileCounts* find(uint64_t site) const;
+    bool empty() const { return counts.empty(); }
+
+    // save()/load(): load() throws if the file is malformed or was recorded from other source
+    void save(const std::string& path, uint64_t sourceHash) const;
+    static Profile load(const std::string& path, uint64_t sourceHash);
+
+private:
+    std::unordered_map<uint64_t, ProfileCounts> counts;
+};
+
+#endif // PROFILE_H
@@ -0,0 +1,41 @@
+#ifndef REPL_H
+#define REPL_H
+
+#include "engine.h"
+#include <iostream>
+#include <map>
+#include <string>
+#include <unordered_map>
+
+// ReplSession class: An interactive session against one live Instance
+// Each entry is compiled on its own: function declarations are added to the instance, replacing
+// earlier ones of the same name, and statements run at once with the variables left by earlier
+// entries. Nothing entered before is compiled again, so an entry takes as long as its own text.
+class ReplSession {
+public:
+    ReplSession(const Engine& engine, std::istream& in = std::cin, std::ostream& out = std::cout,
+                std::ostream& err = std::cerr);
+
+    // submit(): Compile and run one complete entry; throws on compile and runtime errors
+    // When the entry ends in an expression with a value, the value is written to out on its own line.
+    void submit(const std::string& source);
+
+    // complete(): Whether text is a whole entry, as opposed to the start of a longer one
+    static bool complete(const std::string& text);
+
+    bool halted() const { return instance.halted(); }
+    const std::map<std::string, Value>& variables() const { return scope; }
+
+private:
+    const Engine& engine;
+    std::ostream& out;
+    Instance instance;
+    std::map<std::string, Value> scope;                        // Variables declared so far
+    std::unordered_map<std::string, std::string> returnTypes;  // Functions declared so far
+};
+
+// runRepl(): Read entries from in until end of input, ":quit" or quit(), printing errors to err
+void runRepl(const Engine& engine, std::istream& in = std::cin, std::ostream& out = std::cout,
+             std::ostream& err = std::cerr);
+
+#endif // REPL_H
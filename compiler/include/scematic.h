@@ -45,16 +45,16 @@ public:
     // analyze(): Main entry point - walk AST and check semantics
     void analyze();
     
-    // Error reporting (static for easy access)
-    static void reportError(const std::string& message);  // Report an error
-    static bool hasErrors();                              // Check if any errors occurred
+    // Error reporting, per analyzer so separate programs can be checked concurrently
+    void reportError(const std::string& message);         // Report an error
+    bool hasErrors() const;                               // Check if any errors occurred
     
 private:
     ProgramPtr ast;                           // Input: Abstract Syntax Tree
     Scope* currentScope;                      // Current scope being analyzed
     Scope* globalScope;                       // Global scope
     std::string currentFunctionReturnType;    // Return type of current function
-    static bool errors;                       // Flag: any errors occurred?
+    bool errors;                              // Flag: any errors occurred?
     
     // AST traversal methods - validate nodes
     void analyzeProgram(const ProgramPtr& program);
@@ -0,0 +1,36 @@
+#ifndef SERVER_H
+#define SERVER_H
+
+#include <functional>
+#include <string>
+#include <vector>
+
+// ServerRequest: One command line forwarded by a client
+struct ServerRequest {
+    std::string cwd;                // Client's working directory
+    std::vector<std::string> args;  // Arguments after the program name
+    int input;                      // Client's stdin, stdout and stderr, passed over the socket
+    int output;
+    int error;
+};
+
+// defaultSocketPath(): ZPP_SOCKET, else zpp.sock in XDG_RUNTIME_DIR, else /tmp/zpp-<uid>.sock
+std::string defaultSocketPath();
+
+// RequestHandler: Prepares a request inside the server and returns the work to run for it
+// Preparation runs in the resident process, so anything it caches stays warm for later requests.
+// The returned job runs in a forked child with the client's cwd and standard streams, and its
+// result is the client's exit status.
+using RequestHandler = std::function<std::function<int()>(const ServerRequest&)>;
+
+// serve(): Accept requests on a Unix domain socket until the process is killed
+// Jobs run concurrently; a job whose client hangs up is terminated. Requests are read as they arrive,
+// and a client that hasn't sent its whole request within 10 seconds is dropped. Throws if the socket
+// can't be bound or another server already listens on it.
+void serve(const std::string& socketPath, const RequestHandler& handler);
+
+// forward(): Client side; send argv, cwd and the standard streams to a server and wait for the status
+// Returns -1 when no server is listening.
+int forward(const std::string& socketPath, const std::vector<std::string>& args);
+
+#endif // SERVER_H
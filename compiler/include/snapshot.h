@@ -0,0 +1,34 @@
+#ifndef SNAPSHOT_H
+#define SNAPSHOT_H
+
+#include "ir.h"
+#include "value.h"
+#include <cstdint>
+#include <map>
+#include <string>
+#include <vector>
+
+// SnapshotFrame: One function on the call stack of a paused run
+struct SnapshotFrame {
+    std::string function;
+    uint64_t ip = 0;                       // Next instruction to run
+    std::vector<Value> registers;          // Temps, indexed by register number
+    std::map<std::string, Value> locals;   // Named variables
+    IRValue resultSlot;                    // Caller temp that receives the return value
+};
+
+// Snapshot: A run paused at snapshot(), as an Instance saves and resumes it
+struct Snapshot {
+    uint64_t program = 0;               // Fingerprint of the code the frames point into
+    std::vector<SnapshotFrame> frames;  // Outermost first
+};
+
+// saveSnapshot(): Write a snapshot to path, replacing any file there; throws if it can't be written
+// The file is written under a temporary name and renamed into place, so it is never seen half done.
+void saveSnapshot(const std::string& path, const Snapshot& snapshot);
+
+// loadSnapshot(): Read a snapshot through mmap, creating its arrays in heap
+// false if path is missing or damaged, or was saved from a program with another fingerprint.
+bool loadSnapshot(const std::string& path, uint64_t program, ArrayHeap& heap, Snapshot& snapshot);
+
+#endif // SNAPSHOT_H
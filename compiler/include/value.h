@@ -0,0 +1,117 @@
+#ifndef VALUE_H
+#define VALUE_H
+
+#include <cstddef>
+#include <cstdint>
+#include <ostream>
+#include <string>
+#include <utility>
+#include <variant>
+#include <vector>
+
+struct ArrayValue;
+class ArrayHeap;
+
+// ArrayRef: Counted handle to an ArrayValue; copies alias the same array
+// Counts are plain integers rather than atomics: an array belongs to the Instance that made it,
+// and an Instance is used by one thread at a time.
+class ArrayRef {
+public:
+    ArrayRef() : array(nullptr) {}
+    explicit ArrayRef(ArrayValue* array);  // Takes a new reference to array
+    ArrayRef(const ArrayRef& other) : ArrayRef(other.array) {}
+    ArrayRef(ArrayRef&& other) noexcept : array(other.array) { other.array = nullptr; }
+    ArrayRef& operator=(ArrayRef other) noexcept {
+        std::swap(array, other.array);
+        return *this;
+    }
+    ~ArrayRef();
+
+    ArrayValue* get() const { return array; }
+    ArrayValue* operator->() const { return array; }
+    ArrayValue& operator*() const { return *array; }
+    explicit operator bool() const { return array != nullptr; }
+    bool operator==(const ArrayRef& other) const { return array == other.array; }
+    bool operator!=(const ArrayRef& other) const { return array != other.array; }
+
+private:
+    ArrayValue* array;
+};
+
+// Value type: Variant that can hold int, double, string, bool, or arrays
+// Used for storing runtime values during IR interpretation
+using Value = std::variant<int, double, std::string, bool, ArrayRef>;
+
+// ArrayValue: Shared, mutable element storage; copies of a Value alias the same array
+struct ArrayValue {
+    std::vector<Value> elements;
+    size_t refs = 0;
+    ArrayHeap* heap = nullptr;  // Pool that takes the array back when the last reference goes, if any
+};
+
+// makeArray(): A new array outside any pool, for native functions and embedders
+ArrayRef makeArray(std::vector<Value> elements = {});
+
+// MemoryStats: Allocation counters for one Instance
+struct MemoryStats {
+    uint64_t arrays = 0;          // Arrays the script created
+    uint64_t arraysReused = 0;    // Of those, taken from the pool of freed arrays
+    uint64_t liveArrays = 0;      // Pooled arrays still referenced
+    uint64_t strings = 0;         // Strings built by CONCAT
+    uint64_t stringsReused = 0;   // Of those, built in a buffer that was already big enough
+    uint64_t allocations = 0;     // Requests that went to the system allocator
+    uint64_t allocatedBytes = 0;  // Bytes those requests asked for
+};
+
+// ArrayHeap class: Recycles an Instance's arrays, element storage included
+// Freed arrays go on a free list instead of back to the system allocator. Arrays can outlive their
+// Instance (a Value returned by call()), so the heap is released rather than deleted: it goes away
+// together with the last of its arrays.
+class ArrayHeap {
+public:
+    static const size_t kPoolSize = 256;        // Freed arrays kept for reuse
+    static const size_t kPooledCapacity = 4096; // Larger element buffers go back to the system
+
+    ArrayHeap() = default;
+    ArrayHeap(const ArrayHeap&) = delete;
+    ArrayHeap& operator=(const ArrayHeap&) = delete;
+
+    // allocate(): An empty array with room for size elements
+    ArrayRef allocate(size_t size);
+
+    // recycle(): Called by ArrayRef when the last reference to one of this heap's arrays goes
+    void recycle(ArrayValue* array);
+
+    // release(): The owner is done; deletes the heap now or once its last array is freed
+    void release();
+
+    MemoryStats& stats() { return counters; }
+    const MemoryStats& stats() const { return counters; }
+
+private:
+    ~ArrayHeap();
+
+    std::vector<ArrayValue*> pool;
+    MemoryStats counters;
+    bool released = false;
+};
+
+inline ArrayRef::ArrayRef(ArrayValue* array) : array(array) {
+    if (array) array->refs++;
+}
+
+inline ArrayRef::~ArrayRef() {
+    if (array && --array->refs == 0) {
+        if (array->heap) array->heap->recycle(array);
+        else delete array;
+    }
+}
+
+// Conversions between runtime values, as the interpreter applies them
+int valueToInt(const Value& v);             // Throws for arrays and non-numeric strings
+bool valueToBool(const Value& v);           // Truth value used by conditional jumps and logical operators
+std::string valueToString(const Value& v);  // Textual form used by CONCAT
+void appendValue(std::string& out, const Value& v);  // valueToString(v) added to out, without a temporary for strings
+void writeValue(std::ostream& out, const Value& v);  // As print() shows it
+
+#endif // VALUE_H
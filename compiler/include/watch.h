@@ -0,0 +1,41 @@
+#ifndef WATCH_H
+#define WATCH_H
+
+#include <functional>
+#include <map>
+#include <mutex>
+#include <set>
+#include <string>
+#include <thread>
+#include <vector>
+
+// FileWatcher class: Reports changes to a set of files from a background thread, using inotify
+// The files' directories are watched rather than the files, so editors that save by renaming a new
+// file into place are noticed too. A burst of changes is reported once, after it settles.
+class FileWatcher {
+public:
+    static const int kSettleMs = 50;  // Quiet time that ends a burst of changes
+
+    // Constructor: onChange runs on the watcher's thread; it may call watch()
+    explicit FileWatcher(std::function<void()> onChange);
+    ~FileWatcher();
+    FileWatcher(const FileWatcher&) = delete;
+    FileWatcher& operator=(const FileWatcher&) = delete;
+
+    // watch(): Replace the set of files watched; safe to call from any thread
+    void watch(const std::vector<std::string>& paths);
+
+private:
+    std::function<void()> onChange;
+    int inotifyFd;
+    int stopPipe[2];  // Written by the destructor to wake the thread
+    std::mutex lock;
+    std::set<std::string> files;              // Absolute paths
+    std::map<int, std::string> directories;   // By inotify watch descriptor
+    std::thread thread;
+
+    void loop();
+    bool readChanges();  // Drain pending events; true if any of them touched a watched file
+};
+
+#endif // WATCH_H
@@ -0,0 +1,121 @@
+#include "batch.h"
+#include <algorithm>
+#include <chrono>
+#include <deque>
+#include <filesystem>
+#include <iomanip>
+#include <memory>
+#include <mutex>
+#include <sstream>
+#include <stdexcept>
+#include <thread>
+
+namespace fs = std::filesystem;
+
+namespace {
+
+// WorkQueue: One worker's share of the scripts
+// The owner takes from the front; thieves take from the back, away from the owner.
+struct WorkQueue {
+    std::mutex lock;
+    std::deque<size_t> items;
+
+    bool popFront(size_t& item) {
+        std::lock_guard<std::mutex> guard(lock);
+        if (items.empty()) return false;
+        item = items.front();
+        items.pop_front();
+        return true;
+    }
+
+    bool popBack(size_t& item) {
+        std::lock_guard<std::mutex> guard(lock);
+        if (items.empty()) return false;
+        item = items.back();
+        items.pop_back();
+        return true;
+    }
+};
+
+BatchResult runOne(const std::string& path, const ScriptRunner& run) {
+    BatchResult result;
+    result.path = path;
+    std::ostringstream out;
+    auto start = std::chrono::steady_clock::now();
+    try {
+        result.status = run(path, out);
+    } catch (const std::exception& e) {
+        out << "Error: " << e.what() << "\n";
+        result.status = 1;
+    }
+    result.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    result.output = out.str();
+    return result;
+}
+
+} // namespace
+
+std::vector<std::string> findScripts(const std::string& directory) {
+    if (!fs::is_directory(directory)) {
+        throw std::runtime_error("Not a directory: " + directory);
+    }
+    std::vector<std::string> scripts;
+    for (const auto& entry : fs::recursive_directory_iterator(directory)) {
+        if (entry.is_regular_file() && entry.path().extension() == ".zpp") {
+            scripts.push_back(entry.path().string());
+        }
+    }
+    std::sort(scripts.begin(), scripts.end());
+    return scripts;
+}
+
+std::vector<BatchResult> runBatch(const std::vector<std::string>& scripts, const ScriptRunner& run,
+                                  unsigned threads) {
+    std::vector<BatchResult> results(scripts.size());
+    if (scripts.empty()) return results;
+    if (threads == 0) threads = std::max(1u, std::thread::hardware_concurrency());
+    threads = static_cast<unsigned>(std::min<size_t>(threads, scripts.size()));
+
+    // Deal the scripts round-robin so neighbouring (often similar) scripts spread across workers
+    std::vector<std::unique_ptr<WorkQueue>> queues;
+    for (unsigned t = 0; t < threads; ++t) queues.emplace_back(new WorkQueue());
+    for (size_t i = 0; i < scripts.size(); ++i) queues[i % threads]->items.push_back(i);
+
+    auto work = [&](unsigned self) {
+        size_t item;
+        while (true) {
+            bool found = queues[self]->popFront(item);
+            for (unsigned k = 1; !found && k < threads; ++k) {
+                found = queues[(self + k) % threads]->popBack(item);
+            }
+            if (!found) return;  // Nothing is ever added, so empty everywhere means done
+            results[item] = runOne(scripts[item], run);
+        }
+    };
+    std::vector<std::thread> pool;
+    for (unsigned t = 1; t < threads; ++t) pool.emplace_back(work, t);
+    work(0);
+    for (auto& thread : pool) thread.join();
+    return results;
+}
+
+size_t reportBatch(const std::vector<BatchResult>& results, std::ostream& out) {
+    size_t failed = 0;
+    double total = 0;
+    for (const auto& result : results) {
+        total += result.seconds;
+        out << (result.status == 0 ? "PASS " : "FAIL ") << std::fixed << std::setprecision(3)
+            << std::setw(8) << result.seconds << "s  " << result.path;
+        if (result.status != 0) {
+            failed++;
+            out << " (status " << result.status << ")\n";
+            std::istringstream lines(result.output);
+            for (std::string line; std::getline(lines, line);) out << "    " << line << "\n";
+        } else {
+            out << "\n";
+        }
+    }
+    out << results.size() - failed << " passed, " << failed << " failed, " << std::fixed
+        << std::setprecision(3) << total << "s of script time\n";
+    return failed;
+}
@@ -0,0 +1,50 @@
+#include "builtins.h"
+#include <stdexcept>
+#include <unordered_map>
+
+namespace {
+
+// The registry: one entry per builtin
+const std::vector<Builtin>& registry() {
+    static const std::vector<Builtin> builtins = {
+        {"len", IROpCode::LEN, -1, "int", {"array"}},
+        {"screen", IROpCode::SCREEN, -1, "int", {"int", "int", "string"}},
+        {"clearScreen", IROpCode::CLEAR_SCREEN, -1, "int", {"int", "int", "int"}},
+        {"drawPixel", IROpCode::DRAW_PIXEL, -1, "int", {"int", "int", "int", "int", "int"}},
+        {"drawRect", IROpCode::DRAW_RECT, -1, "int", {"int", "int", "int", "int", "int", "int", "int", "int"}},
+        {"drawLine", IROpCode::DRAW_LINE, -1, "int", {"int", "int", "int", "int", "int", "int", "int"}},
+        {"drawCircle", IROpCode::DRAW_CIRCLE, -1, "int", {"int", "int", "int", "int", "int", "int", "int"}},
+        {"display", IROpCode::PRESENT, -1, "int", {}},
+        {"quit", IROpCode::CALL_NATIVE, NATIVE_QUIT, "void", {}},
+        {"isKeyDown", IROpCode::CALL_NATIVE, NATIVE_IS_KEY_DOWN, "int", {"string"}},
+        {"updateInput", IROpCode::CALL_NATIVE, NATIVE_UPDATE_INPUT, "int", {}},
+        {"snapshot", IROpCode::CALL_NATIVE, NATIVE_SNAPSHOT, "int", {}},
+    };
+    return builtins;
+}
+
+} // namespace
+
+const Builtin* findBuiltin(const std::string& name) {
+    static const std::unordered_map<std::string, const Builtin*> byName = [] {
+        std::unordered_map<std::string, const Builtin*> index;
+        for (const auto& builtin : registry()) index[builtin.name] = &builtin;
+        return index;
+    }();
+    auto it = byName.find(name);
+    return it == byName.end() ? nullptr : it->second;
+}
+
+const Builtin& nativeBuiltin(int native) {
+    static const std::vector<const Builtin*> byId = [] {
+        std::vector<const Builtin*> index(NATIVE_COUNT, nullptr);
+        for (const auto& builtin : registry()) {
+            if (builtin.native >= 0) index[builtin.native] = &builtin;
+        }
+        return index;
+    }();
+    if (native < 0 || native >= NATIVE_COUNT || !byId[native]) {
+        throw std::runtime_error("Unknown native builtin: " + std::to_string(native));
+    }
+    return *byId[native];
+}
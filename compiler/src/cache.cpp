@@ -0,0 +1,311 @@
+#include "cache.h"
+#include "profile.h"
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <sstream>
+#include <stdexcept>
+#include <thread>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+// ZPP_BUILD_ID: Identifies the compiler build, so entries written by any other build are never reused
+#if __has_include("build_id.h")
+#include "build_id.h"
+#endif
+#ifndef ZPP_BUILD_ID
+#define ZPP_BUILD_ID "dev"
+#endif
+
+namespace fs = std::filesystem;
+
+namespace {
+
+// Bumped whenever the encoding below changes
+const uint32_t kFormatVersion = 1;
+const char kMagic[4] = {'Z', 'P', 'P', 'C'};
+
+// Writer: Appends fixed-width integers and length-prefixed strings
+class Writer {
+public:
+    void u8(uint8_t v) { out.push_back(static_cast<char>(v)); }
+    void u32(uint32_t v) { raw(&v, sizeof(v)); }
+    void i32(int32_t v) { raw(&v, sizeof(v)); }
+    void u64(uint64_t v) { raw(&v, sizeof(v)); }
+    void str(const std::string& s) {
+        u32(static_cast<uint32_t>(s.size()));
+        out.append(s);
+    }
+    void value(const IRValue& v) {
+        u8(static_cast<uint8_t>(v.type));
+        str(v.name);
+        i32(v.id);
+    }
+    std::string take() { return std::move(out); }
+
+private:
+    std::string out;
+    void raw(const void* p, size_t n) { out.append(static_cast<const char*>(p), n); }
+};
+
+// Reader: Bounds-checked counterpart of Writer
+class Reader {
+public:
+    Reader(const char* data, size_t size) : data(data), size(size), pos(0) {}
+
+    uint8_t u8() { uint8_t v; raw(&v, sizeof(v)); return v; }
+    uint32_t u32() { uint32_t v; raw(&v, sizeof(v)); return v; }
+    int32_t i32() { int32_t v; raw(&v, sizeof(v)); return v; }
+    uint64_t u64() { uint64_t v; raw(&v, sizeof(v)); return v; }
+    std::string str() {
+        uint32_t n = u32();
+        need(n);
+        std::string s(data + pos, n);
+        pos += n;
+        return s;
+    }
+    IRValue value() {
+        IRValue v;
+        v.type = static_cast<IRValue::Type>(u8());
+        v.name = str();
+        v.id = i32();
+        return v;
+    }
+    // count(): Element count, sanity-checked against the bytes left
+    uint32_t count() {
+        uint32_t n = u32();
+        need(n);
+        return n;
+    }
+    bool done() const { return pos == size; }
+
+private:
+    const char* data;
+    size_t size;
+    size_t pos;
+
+    void need(size_t n) {
+        if (n > size - pos) throw std::runtime_error("Truncated IR data");
+    }
+    void raw(void* p, size_t n) {
+        need(n);
+        std::memcpy(p, data + pos, n);
+        pos += n;
+    }
+};
+
+std::string envOr(const char* name, const std::string& fallback) {
+    const char* value = std::getenv(name);
+    return value && *value ? value : fallback;
+}
+
+} // namespace
+
+std::string serializeIR(const IRProgram& program) {
+    Writer w;
+    w.u32(kFormatVersion);
+
+    std::vector<std::pair<std::string, std::string>> globals(program.globalVariables.begin(),
+                                                              program.globalVariables.end());
+    std::sort(globals.begin(), globals.end());
+    w.u32(static_cast<uint32_t>(globals.size()));
+    for (const auto& global : globals) {
+        w.str(global.first);
+        w.str(global.second);
+    }
+
+    w.u32(static_cast<uint32_t>(program.functions.size()));
+    for (const auto& func : program.functions) {
+        w.str(func.name);
+        w.str(func.returnType);
+        w.u32(static_cast<uint32_t>(func.parameters.size()));
+        for (const auto& param : func.parameters) {
+            w.str(param.first);
+            w.str(param.second);
+        }
+        w.u32(static_cast<uint32_t>(func.instructions.size()));
+        for (const auto& instr : func.instructions) {
+            w.u32(static_cast<uint32_t>(instr.opcode));
+            w.u32(static_cast<uint32_t>(instr.operands.size()));
+            for (const auto& operand : instr.operands) w.value(operand);
+            w.value(instr.result);
+            w.str(instr.label);
+            w.str(instr.prompt);
+            w.u32(static_cast<uint32_t>(instr.cases.size()));
+            for (const auto& c : instr.cases) {
+                w.i32(c.first);
+                w.str(c.second);
+            }
+            w.u64(instr.site);
+            w.i32(instr.native);
+        }
+    }
+    return w.take();
+}
+
+IRProgram deserializeIR(const char* data, size_t size) {
+    Reader r(data, size);
+    if (r.u32() != kFormatVersion) {
+        throw std::runtime_error("IR data has an unsupported format version");
+    }
+
+    IRProgram program;
+    for (uint32_t i = r.count(); i > 0; --i) {
+        std::string name = r.str();
+        program.globalVariables[name] = r.str();
+    }
+
+    program.functions.resize(r.count());
+    for (auto& func : program.functions) {
+        func.name = r.str();
+        func.returnType = r.str();
+        func.parameters.resize(r.count());
+        for (auto& param : func.parameters) {
+            param.first = r.str();
+            param.second = r.str();
+        }
+        uint32_t count = r.count();
+        func.instructions.reserve(count);
+        for (uint32_t i = 0; i < count; ++i) {
+            uint32_t opcode = r.u32();
+            if (opcode > static_cast<uint32_t>(IROpCode::NOP)) {
+                throw std::runtime_error("IR data has an unknown opcode");
+            }
+            IRInstruction instr(static_cast<IROpCode>(opcode));
+            instr.operands.resize(r.count());
+            for (auto& operand : instr.operands) operand = r.value();
+            instr.result = r.value();
+            instr.label = r.str();
+            instr.prompt = r.str();
+            instr.cases.resize(r.count());
+            for (auto& c : instr.cases) {
+                c.first = r.i32();
+                c.second = r.str();
+            }
+            instr.site = r.u64();
+            instr.native = r.i32();
+            func.instructions.push_back(std::move(instr));
+        }
+    }
+    if (!r.done()) {
+        throw std::runtime_error("Trailing bytes after IR data");
+    }
+    return program;
+}
+
+CompileCache::CompileCache(const std::string& directory, uint64_t limit)
+    : directory(directory), limit(limit) {}
+
+std::string CompileCache::defaultDirectory() {
+    std::string explicitDir = envOr("ZPP_CACHE_DIR", "");
+    if (!explicitDir.empty()) return explicitDir;
+    std::string xdg = envOr("XDG_CACHE_HOME", "");
+    if (!xdg.empty()) return xdg + "/zpp";
+    return envOr("HOME", ".") + "/.cache/zpp";
+}
+
+std::string CompileCache::key(const std::string& source, const std::string& flags) {
+    std::ostringstream oss;
+    oss << std::hex << hashText(std::string(ZPP_BUILD_ID) + '\0' + flags + '\0' + source);
+    return oss.str();
+}
+
+std::string CompileCache::entryPath(const std::string& key) const {
+    return directory + "/" + key + ".zppc";
+}
+
+bool CompileCache::load(const std::string& key, IRProgram& program) {
+    std::string path = entryPath(key);
+    int fd = ::open(path.c_str(), O_RDONLY);
+    if (fd < 0) return false;
+
+    struct stat info;
+    if (fstat(fd, &info) != 0 || info.st_size < static_cast<off_t>(sizeof(kMagic))) {
+        ::close(fd);
+        return false;
+    }
+    size_t size = static_cast<size_t>(info.st_size);
+    void* mapped = mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+    ::close(fd);
+    if (mapped == MAP_FAILED) return false;
+
+    const char* data = static_cast<const char*>(mapped);
+    bool hit = false;
+    if (std::memcmp(data, kMagic, sizeof(kMagic)) == 0) {
+        try {
+            program = deserializeIR(data + sizeof(kMagic), size - sizeof(kMagic));
+            hit = true;
+        } catch (const std::exception&) {
+            // Damaged or stale entry: drop it and compile from source
+        }
+    }
+    munmap(mapped, size);
+
+    std::error_code ec;
+    if (hit) {
+        fs::last_write_time(path, fs::file_time_type::clock::now(), ec);  // Most recently used
+    } else {
+        fs::remove(path, ec);
+    }
+    return hit;
+}
+
+void CompileCache::store(const std::string& key, const IRProgram& program) {
+    std::error_code ec;
+    fs::create_directories(directory, ec);
+    if (ec) return;
+
+    std::string path = entryPath(key);
+    std::string temp = path + ".tmp." + std::to_string(getpid()) + "." +
+                       std::to_string(std::hash<std::thread::id>()(std::this_thread::get_id()));
+    {
+        std::ofstream out(temp, std::ios::binary);
+        if (!out) return;
+        out.write(kMagic, sizeof(kMagic));
+        std::string data = serializeIR(program);
+        out.write(data.data(), static_cast<std::streamsize>(data.size()));
+        if (!out) {
+            out.close();
+            fs::remove(temp, ec);
+            return;
+        }
+    }
+    fs::rename(temp, path, ec);
+    if (ec) {
+        fs::remove(temp, ec);
+        return;
+    }
+    evict();
+}
+
+void CompileCache::evict() {
+    struct Entry {
+        fs::path path;
+        fs::file_time_type used;
+        uintmax_t size;
+    };
+    std::vector<Entry> entries;
+    uintmax_t total = 0;
+
+    std::error_code ec;
+    for (fs::directory_iterator it(directory, ec), end; !ec && it != end; it.increment(ec)) {
+        if (it->path().extension() != ".zppc") continue;
+        std::error_code statError;
+        Entry entry{it->path(), fs::last_write_time(it->path(), statError), fs::file_size(it->path(), statError)};
+        if (statError) continue;
+        total += entry.size;
+        entries.push_back(entry);
+    }
+    if (total <= limit) return;
+
+    // Least recently used first
+    std::sort(entries.begin(), entries.end(), [](const Entry& a, const Entry& b) { return a.used < b.used; });
+    for (const auto& entry : entries) {
+        if (total <= limit) break;
+        if (fs::remove(entry.path, ec)) total -= entry.size;
+    }
+}
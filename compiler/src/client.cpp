@@ -0,0 +1,32 @@
+#include <iostream>
+#include <stdexcept>
+#include "server.h"
+
+// zpp-client: Run a script on a resident `compiler --server`
+// Takes the same arguments as the compiler; the script's output, input and exit status are the client's own.
+// Does not link SDL, so starting it costs little more than a fork and exec.
+int main(int argc, char* argv[]) {
+    std::string socketPath = defaultSocketPath();
+    std::vector<std::string> args;
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        if (arg == "--socket" && i + 1 < argc) {
+            socketPath = argv[++i];
+        } else {
+            args.push_back(arg);
+        }
+    }
+
+    try {
+        int status = forward(socketPath, args);
+        if (status < 0) {
+            std::cerr << "Error: No server is listening on " << socketPath
+                      << " (start one with `compiler --server`)" << std::endl;
+            return 1;
+        }
+        return status;
+    } catch (const std::exception& e) {
+        std::cerr << "Error: " << e.what() << std::endl;
+        return 1;
+    }
+}
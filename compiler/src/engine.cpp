@@ -0,0 +1,1259 @@
+#include "engine.h"
+#include "builtins.h"
+#include "graphics.h"
+#include "incremental.h"
+#include "modules.h"
+#include "optimizer.h"
+#include "snapshot.h"
+#include <algorithm>
+#include <condition_variable>
+#include <fstream>
+#include <limits>
+#include <set>
+#include <sstream>
+#include <stdexcept>
+#include <thread>
+#include <termios.h>
+#include <unistd.h>
+
+namespace {
+
+// readSingleKey: Read a single character from stdin without waiting for Enter
+// Uses termios to disable canonical mode (line buffering)
+char readSingleKey() {
+    struct termios old_settings, new_settings;
+    tcgetattr(STDIN_FILENO, &old_settings);
+    new_settings = old_settings;
+    new_settings.c_lflag &= ~(ICANON | ECHO);    // Disable canonical mode and echo
+    tcsetattr(STDIN_FILENO, TCSANOW, &new_settings);
+    
+    char ch;
+    read(STDIN_FILENO, &ch, 1);
+    
+    tcsetattr(STDIN_FILENO, TCSANOW, &old_settings);  // Restore original settings
+    return ch;
+}
+
+// Frame: Activation record of one running IR function
+struct Frame {
+    const Module::Function* info;
+    std::vector<Value> registers;          // Temps, indexed by register number
+    std::map<std::string, Value> locals;   // Named variables
+    size_t ip;
+    IRValue resultSlot;                    // Caller temp that receives the return value
+
+    // slot(): Storage for an IR operand in this frame
+    Value& slot(const IRValue& value) {
+        if (value.type == IRValue::Type::TEMP && value.id >= 0) {
+            if (static_cast<size_t>(value.id) >= registers.size()) registers.resize(value.id + 1);
+            return registers[value.id];
+        }
+        return locals[value.type == IRValue::Type::LOCAL ? value.name : value.toString()];
+    }
+};
+
+// enterFunction: Point a frame at the start of a function with fresh storage and bound arguments
+void enterFunction(Frame& frame, const Module::Function* info, const std::vector<Value>& args) {
+    frame.info = info;
+    frame.ip = 0;
+    frame.registers.assign(info->registerCount, Value());
+    frame.locals.clear();
+    const auto& params = info->func->parameters;
+    for (size_t i = 0; i < params.size() && i < args.size(); ++i) {
+        frame.locals[params[i].second] = args[i];
+    }
+}
+
+// remapFrames: Move frames running replaced functions onto their new code after a reload
+// Every frame stands just past a safepoint: the display() the top frame ran, or the call each frame
+// below it waits on. A frame resumes after the same occurrence of that instruction in the new code,
+// with the locals the new code still uses; parameters whose declared type changed are dropped too.
+// Temps are kept as they are: code around a matching safepoint is generated the same way, and the
+// optimizer can leave temps live across it (loop invariants, unrolled loop counters). A frame whose
+// safepoint has no counterpart finishes in its old code.
+template <typename Lookup>
+void remapFrames(std::vector<Frame>& frames, const Lookup& find) {
+    for (size_t i = 0; i < frames.size(); ++i) {
+        Frame& frame = frames[i];
+        const Module::Function* next = find(frame.info->func->name);
+        if (!next || next == frame.info || frame.ip == 0) continue;
+        
+        const auto& before = frame.info->func->instructions;
+        const auto& after = next->func->instructions;
+        const IRInstruction& mark = before[frame.ip - 1];
+        auto same = [&](const IRInstruction& instr) {
+            return instr.opcode == mark.opcode && instr.label == mark.label;
+        };
+        size_t occurrence = std::count_if(before.begin(), before.begin() + (frame.ip - 1), same);
+        size_t at = 0;
+        for (; at < after.size(); ++at) {
+            if (same(after[at]) && occurrence-- == 0) break;
+        }
+        if (at == after.size()) continue;
+        
+        std::set<std::string> used;
+        for (const auto& instr : after) {
+            if (instr.result.type == IRValue::Type::LOCAL) used.insert(instr.result.name);
+            for (const auto& operand : instr.operands) {
+                if (operand.type == IRValue::Type::LOCAL) used.insert(operand.name);
+            }
+        }
+        for (const auto& param : frame.info->func->parameters) {
+            for (const auto& replacement : next->func->parameters) {
+                if (replacement.second == param.second && replacement.first != param.first) used.erase(param.second);
+            }
+        }
+        for (auto it = frame.locals.begin(); it != frame.locals.end();) {
+            it = used.count(it->first) ? std::next(it) : frame.locals.erase(it);
+        }
+        
+        frame.info = next;
+        frame.ip = at + 1;
+        frame.registers.resize(std::max(frame.registers.size(), next->registerCount));
+        if (i + 1 < frames.size()) frames[i + 1].resultSlot = after[at].result;
+    }
+}
+
+// profileType: Profile type bit for a runtime value
+uint32_t profileType(const Value& v) {
+    if (std::holds_alternative<int>(v)) return PROFILE_INT;
+    if (std::holds_alternative<double>(v)) return PROFILE_DOUBLE;
+    if (std::holds_alternative<std::string>(v)) return PROFILE_STRING;
+    if (std::holds_alternative<bool>(v)) return PROFILE_BOOL;
+    return PROFILE_ARRAY;
+}
+
+// recordProfile: Count one execution of an instruction the optimizer can use
+void recordProfile(Profile& profile, const IRInstruction& instr, Frame& frame) {
+    switch (genericOpCode(instr.opcode)) {
+        case IROpCode::JZ:
+        case IROpCode::JNZ:
+            profile.recordBranch(instr.site, valueToBool(frame.slot(instr.operands[0])));
+            break;
+        case IROpCode::CALL:
+            profile.recordCall(instr.site);
+            break;
+        case IROpCode::ADD:
+        case IROpCode::SUB:
+        case IROpCode::MUL:
+        case IROpCode::DIV:
+        case IROpCode::MOD:
+        case IROpCode::EQ:
+        case IROpCode::NE:
+        case IROpCode::LT:
+        case IROpCode::GT:
+        case IROpCode::LE:
+        case IROpCode::GE:
+            profile.recordTypes(instr.site, profileType(frame.slot(instr.operands[0])) |
+                                            profileType(frame.slot(instr.operands[1])));
+            break;
+        default:
+            break;
+    }
+}
+
+// countGrowth: Count a string buffer that had to grow as one allocation
+void countGrowth(MemoryStats& stats, size_t before, size_t after) {
+    if (after > before) {
+        stats.allocations++;
+        stats.allocatedBytes += after + 1;
+    }
+}
+
+// Watchdog class: One thread per process that sets the stop flags of runs past their deadline
+// Started on first use and never destroyed, so no run has to wait for it to exit. A forked child
+// (as the server runs scripts in) doesn't inherit the thread, so it starts its own.
+class Watchdog {
+public:
+    using Clock = std::chrono::steady_clock;
+
+    // Alarm: Value to store in flag at the deadline; flag is cleared once it has gone off
+    struct Alarm {
+        std::atomic<int>* flag;
+        int value;
+    };
+    using Ticket = std::multimap<Clock::time_point, Alarm>::iterator;
+
+    static Watchdog& get() {
+        static std::mutex lock;
+        static Watchdog* current = nullptr;
+        std::lock_guard<std::mutex> guard(lock);
+        if (!current || current->owner != getpid()) current = new Watchdog();
+        return *current;
+    }
+
+    // watch(): Set the alarm; every ticket must be cancelled, whether or not it went off
+    Ticket watch(Clock::time_point deadline, Alarm alarm) {
+        std::lock_guard<std::mutex> guard(lock);
+        Ticket ticket = deadlines.emplace(deadline, alarm);
+        if (ticket == deadlines.begin()) wake.notify_one();
+        return ticket;
+    }
+
+    void cancel(Ticket ticket) {
+        std::lock_guard<std::mutex> guard(lock);
+        deadlines.erase(ticket);
+    }
+
+private:
+    pid_t owner;
+    std::mutex lock;
+    std::condition_variable wake;
+    std::multimap<Clock::time_point, Alarm> deadlines;
+
+    Watchdog() : owner(getpid()) {
+        std::thread([this]() { loop(); }).detach();
+    }
+
+    void loop() {
+        std::unique_lock<std::mutex> guard(lock);
+        while (true) {
+            auto next = std::find_if(deadlines.begin(), deadlines.end(),
+                                     [](const auto& entry) { return entry.second.flag != nullptr; });
+            if (next == deadlines.end()) {
+                wake.wait(guard);
+            } else if (Clock::now() >= next->first) {
+                next->second.flag->store(next->second.value, std::memory_order_relaxed);
+                next->second.flag = nullptr;
+            } else {
+                wake.wait_until(guard, next->first);
+            }
+        }
+    }
+};
+
+// NativeFunction: Interpreter implementation of a CALL_NATIVE builtin
+// Sets halt to end the program once the call returns.
+using NativeFunction = Value (*)(Instance& instance, const std::vector<Value>& args, bool& halt);
+
+// quit() - Clean exit
+Value nativeQuit(Instance& instance, const std::vector<Value>&, bool& halt) {
+    if (instance.window()) {
+        // Process pending events one final time
+        instance.window()->handleEvents();
+        instance.closeWindow();
+    }
+    halt = true;
+    return Value();
+}
+
+// isKeyDown(keyCode) - returns 1 if key is down, 0 otherwise
+Value nativeIsKeyDown(Instance& instance, const std::vector<Value>& args, bool&) {
+    int result = 0;
+    if (instance.window() && !args.empty()) {
+        const Value& keyVal = args[0];
+        std::string keyStr;
+        if (std::holds_alternative<std::string>(keyVal)) {
+            keyStr = std::get<std::string>(keyVal);
+        } else if (std::holds_alternative<int>(keyVal)) {
+            keyStr = std::to_string(std::get<int>(keyVal));
+        } else if (std::holds_alternative<double>(keyVal)) {
+            keyStr = std::to_string(static_cast<int>(std::get<double>(keyVal)));
+        }
+        
+        result = instance.window()->isKeyPressed(keyStr) ? 1 : 0;
+        
+        if (result == 1) {
+            instance.output() << "Key detected: " << keyStr << std::endl;
+        }
+    }
+    return result;
+}
+
+// updateInput() - manually update input state
+Value nativeUpdateInput(Instance& instance, const std::vector<Value>&, bool&) {
+    if (instance.window()) {
+        instance.window()->handleEvents();
+    }
+    return 1;
+}
+
+// snapshot() - Saving needs the call stack, so the interpreter handles it before reaching this table
+Value nativeSnapshot(Instance&, const std::vector<Value>&, bool&) {
+    return 0;
+}
+
+// Native table, indexed by NativeId
+const NativeFunction kNatives[] = {
+    nativeQuit,
+    nativeIsKeyDown,
+    nativeUpdateInput,
+    nativeSnapshot,
+};
+static_assert(sizeof(kNatives) / sizeof(kNatives[0]) == NATIVE_COUNT, "every NativeId needs a native function");
+
+} // namespace
+
+Module::Module(IRProgram program, std::string text, std::shared_ptr<const std::vector<NativeBinding>> natives,
+               std::vector<std::string> files)
+    : ir(std::move(program)), programText(std::move(text)), sourceFiles(std::move(files)),
+      natives(std::move(natives)) {
+    size_t bound = this->natives ? this->natives->size() : 0;
+    for (const auto& func : ir.functions) {
+        Function& info = functions[func.name];
+        info.func = &func;
+        info.natives = this->natives.get();
+        int maxTemp = -1;
+        for (size_t i = 0; i < func.instructions.size(); ++i) {
+            const auto& instr = func.instructions[i];
+            if (instr.opcode == IROpCode::LABEL) {
+                info.labels[instr.label] = i;
+            }
+            if (instr.opcode == IROpCode::CALL_NATIVE &&
+                (instr.native < 0 || static_cast<size_t>(instr.native) >= NATIVE_COUNT + bound ||
+                 instr.operands.size() > kMaxNativeArity)) {
+                throw std::runtime_error("Call to native function '" + instr.label + "' that isn't bound");
+            }
+            if (instr.result.type == IRValue::Type::TEMP) maxTemp = std::max(maxTemp, instr.result.id);
+            for (const auto& operand : instr.operands) {
+                if (operand.type == IRValue::Type::TEMP) maxTemp = std::max(maxTemp, operand.id);
+            }
+        }
+        info.registerCount = static_cast<size_t>(maxTemp + 1);
+    }
+}
+
+Engine::Engine(EngineConfig config) : settings(std::move(config)) {}
+
+void Engine::addNative(NativeBinding binding) {
+    if (findBuiltin(binding.name)) {
+        throw std::runtime_error("Can't bind '" + binding.name + "': it is a builtin");
+    }
+    for (const auto& call : nativeCalls) {
+        if (call.name == binding.name) {
+            throw std::runtime_error("Can't bind '" + binding.name + "' twice");
+        }
+    }
+    // Modules compiled earlier keep the table they were compiled against
+    auto table = natives ? std::make_shared<std::vector<NativeBinding>>(*natives)
+                         : std::make_shared<std::vector<NativeBinding>>();
+    int id = NATIVE_COUNT + static_cast<int>(table->size());
+    nativeCalls.push_back({binding.name, IROpCode::CALL_NATIVE, id, binding.returnType, binding.parameterTypes});
+    table->push_back(std::move(binding));
+    natives = table;
+}
+
+ModulePtr Engine::compileProgram(const ProgramPtr& ast, bool inlining) const {
+    if (!ast->imports.empty()) {
+        throw std::runtime_error("Imports need a file to resolve against; use compile()");
+    }
+    IRGenerator generator(ast, &nativeCalls);
+    IRProgram ir = generator.generate();
+    IROptimizer(ir).optimize(inlining);
+    return std::make_shared<const Module>(std::move(ir), "", natives);
+}
+
+ModulePtr Engine::compileFile(const std::string& path) const {
+    std::ifstream file(path);
+    if (!file.is_open()) {
+        throw std::runtime_error("Could not open file " + path);
+    }
+    std::stringstream buffer;
+    buffer << file.rdbuf();
+    return compile(buffer.str(), path);
+}
+
+ModulePtr Engine::compile(const std::string& source, const std::string& path) const {
+    // The entry file and everything it imports, in the order they were found
+    std::vector<SourceModule> modules = loadModules(path, source);
+    std::string text = programText(modules);
+    
+    // Optimized IR is cached by source and by everything else that changes it
+    std::string flags;
+    if (!settings.profileUse.empty()) {
+        std::ifstream profileFile(settings.profileUse);
+        std::stringstream profileText;
+        profileText << profileFile.rdbuf();
+        flags = "profile-use " + std::to_string(hashText(profileText.str()));
+    }
+    // Bound natives are compiled in by id, so their names and signatures are part of the key too
+    for (const auto& call : nativeCalls) {
+        flags += "\nnative " + call.name + "(";
+        for (const auto& type : call.parameterTypes) flags += type + ",";
+        flags += ")" + call.returnType;
+    }
+    std::string key = CompileCache::key(text, flags);
+    
+    if (settings.memoryCacheEntries > 0) {
+        std::lock_guard<std::mutex> guard(memoryLock);
+        auto it = memoryIndex.find(key);
+        if (it != memoryIndex.end()) {
+            memoryEntries.splice(memoryEntries.begin(), memoryEntries, it->second);
+            return it->second->second;
+        }
+    }
+    
+    CompileCache cache(settings.cacheDir, settings.cacheLimit);
+    IRProgram ir;
+    if (!settings.useCache || !cache.load(key, ir)) {
+        Profile recorded;
+        if (!settings.profileUse.empty()) {
+            recorded = Profile::load(settings.profileUse, hashText(text));
+        }
+        const Profile* guide = settings.profileUse.empty() ? nullptr : &recorded;
+        
+        // Modules compile in parallel; within each, unchanged functions come from the cache
+        ir = compileModules(modules, settings.useCache ? &cache : nullptr, flags, guide, &nativeCalls);
+        if (settings.useCache) cache.store(key, ir);
+    }
+    // Source given as text has no file of its own, but what it imports does
+    std::vector<std::string> files;
+    for (size_t m = path.empty() ? 1 : 0; m < modules.size(); ++m) files.push_back(modules[m].path);
+    ModulePtr module = std::make_shared<const Module>(std::move(ir), std::move(text), natives, std::move(files));
+    
+    if (settings.memoryCacheEntries > 0) {
+        std::lock_guard<std::mutex> guard(memoryLock);
+        if (!memoryIndex.count(key)) {
+            memoryEntries.emplace_front(key, module);
+            memoryIndex[key] = memoryEntries.begin();
+            if (memoryEntries.size() > settings.memoryCacheEntries) {
+                memoryIndex.erase(memoryEntries.back().first);
+                memoryEntries.pop_back();
+            }
+        }
+    }
+    return module;
+}
+
+Instance::Instance(ModulePtr module, std::istream& in, std::ostream& out, std::ostream& err)
+    : module(std::move(module)), in(in), out(out), err(err), profile(nullptr), headless(false), stopped(false),
+      graphics(nullptr), instructionLimit(0), timeLimit(0), stopRequest(kRunning), reloadPending(false), fuel(0),
+      depth(0),
+      heap(new ArrayHeap()) {}
+
+Instance::~Instance() {
+    delete graphics;
+    heap->release();
+}
+
+void Instance::closeWindow() {
+    delete graphics;
+    graphics = nullptr;
+}
+
+// storeString: Copy text into a register, reusing the string buffer it already holds
+void Instance::storeString(Value& slot, const std::string& text) {
+    MemoryStats& stats = heap->stats();
+    stats.strings++;
+    std::string* current = std::get_if<std::string>(&slot);
+    if (!current) {
+        slot = std::string();
+        current = &std::get<std::string>(slot);
+    }
+    size_t capacity = current->capacity();
+    current->assign(text);
+    countGrowth(stats, capacity, current->capacity());
+    if (current->capacity() == capacity) stats.stringsReused++;
+}
+
+void Instance::run() {
+    const Module::Function* entry = findFunction("main");
+    if (!entry || stopped) return;
+    std::unique_ptr<Snapshot> resume = std::move(resumeFrom);
+    execute(*entry, {}, nullptr, resume.get());
+}
+
+bool Instance::restore(const std::string& path) {
+    std::unique_ptr<Snapshot> snapshot(new Snapshot());
+    if (!loadSnapshot(path, fingerprint(), *heap, *snapshot)) return false;
+    for (const auto& frame : snapshot->frames) {
+        if (!findFunction(frame.function)) return false;
+    }
+    resumeFrom = std::move(snapshot);
+    return true;
+}
+
+// fingerprint: Hash of the IR of every loaded module and of the natives it calls by id
+// Frames are saved as instruction positions, so anything that changes the IR, such as a different
+// profile to optimize with, has to invalidate a snapshot just as editing the source does.
+uint64_t Instance::fingerprint() const {
+    std::string code;
+    auto add = [&code](const Module& source) {
+        code += serializeIR(source.ir);
+        if (source.natives) {
+            for (const auto& binding : *source.natives) code += '\0' + binding.name;
+        }
+        code += '\n';
+    };
+    add(*module);
+    for (const auto& more : loaded) add(*more);
+    return hashText(code);
+}
+
+Value Instance::call(const std::string& function, const std::vector<Value>& args) {
+    const Module::Function* entry = findFunction(function);
+    if (!entry) {
+        throw std::runtime_error("No function named '" + function + "'");
+    }
+    if (stopped) return Value();
+    return execute(*entry, args);
+}
+
+Value Instance::callInScope(const std::string& function, std::map<std::string, Value>& variables) {
+    const Module::Function* entry = findFunction(function);
+    if (!entry) {
+        throw std::runtime_error("No function named '" + function + "'");
+    }
+    if (stopped) return Value();
+    return execute(*entry, {}, &variables);
+}
+
+void Instance::load(ModulePtr more) {
+    for (const auto& function : more->functions) {
+        overrides[function.first] = &function.second;
+    }
+    loaded.push_back(std::move(more));
+}
+
+void Instance::reload(ModulePtr next) {
+    std::lock_guard<std::mutex> guard(reloadLock);
+    pendingReload = std::move(next);
+    reloadPending.store(true, std::memory_order_release);
+}
+
+const Module::Function* Instance::findFunction(const std::string& name) const {
+    if (!overrides.empty()) {
+        auto it = overrides.find(name);
+        if (it != overrides.end()) return it->second;
+    }
+    auto it = module->functions.find(name);
+    return it == module->functions.end() ? nullptr : &it->second;
+}
+
+// charge: Account for cost instructions; the slow path only runs near a limit or on a stop request
+inline void Instance::charge(uint64_t cost) {
+    if (cost >= fuel || stopRequest.load(std::memory_order_relaxed) != kRunning) {
+        checkLimits(cost);
+    } else {
+        fuel -= cost;
+    }
+}
+
+// jump: Target of a jump taken at from; going backward closes a loop, charged for the instructions it spans
+inline size_t Instance::jump(size_t from, size_t to) {
+    if (to <= from) charge(from - to + 1);
+    return to;
+}
+
+void Instance::checkLimits(uint64_t cost) {
+    int request = stopRequest.exchange(kRunning, std::memory_order_relaxed);
+    if (request == kTimedOut) {
+        throw ScriptInterrupted("Script exceeded its time limit of " + std::to_string(timeLimit.count()) + " ms");
+    }
+    if (request == kInterrupted) {
+        throw ScriptInterrupted("Script was interrupted");
+    }
+    if (cost >= fuel) {
+        if (instructionLimit) {
+            throw ScriptInterrupted("Script exceeded its limit of " + std::to_string(instructionLimit) +
+                                    " instructions");
+        }
+        fuel = std::numeric_limits<uint64_t>::max();
+    }
+    fuel -= cost;
+}
+
+// execute: Run the IR starting at entry until it returns
+// Walks through the IR instructions, pushing a frame for every user function call. With a profile,
+// branch outcomes, calls and operand types are counted per instruction site.
+Value Instance::execute(const Module::Function& entry, const std::vector<Value>& args,
+                        std::map<std::string, Value>* variables, const Snapshot* resume) {
+    // Limits cover the outermost run; natives calling back into the script share its budget
+    struct Run {
+        Instance& instance;
+        bool watched = false;
+        Watchdog::Ticket ticket;
+        explicit Run(Instance& instance) : instance(instance) {
+            if (instance.depth++ > 0) return;
+            instance.stopRequest.store(kRunning, std::memory_order_relaxed);
+            instance.fuel = instance.instructionLimit ? instance.instructionLimit
+                                                      : std::numeric_limits<uint64_t>::max();
+            if (instance.timeLimit.count() > 0) {
+                ticket = Watchdog::get().watch(Watchdog::Clock::now() + instance.timeLimit,
+                                               {&instance.stopRequest, kTimedOut});
+                watched = true;
+            }
+        }
+        ~Run() {
+            instance.depth--;
+            if (watched) Watchdog::get().cancel(ticket);
+        }
+    } run(*this);
+
+    Value returned;
+    std::vector<Frame> frames(1);
+    enterFunction(frames[0], &entry, args);
+    if (resume) {
+        // Pick up where snapshot() left off instead of at the start of entry
+        frames.resize(resume->frames.size());
+        for (size_t i = 0; i < frames.size(); ++i) {
+            const SnapshotFrame& saved = resume->frames[i];
+            frames[i].info = findFunction(saved.function);
+            frames[i].ip = saved.ip;
+            frames[i].registers = saved.registers;
+            frames[i].locals = saved.locals;
+            frames[i].resultSlot = saved.resultSlot;
+        }
+    }
+    if (variables) frames[0].locals.swap(*variables);
+    // keepVariables: Hands the entry frame's locals back once it is done with them, or on the way out
+    // of an exception; declared after frames so it still sees them while unwinding
+    struct KeepVariables {
+        std::vector<Frame>& frames;
+        std::map<std::string, Value>*& variables;
+        void operator()() {
+            if (variables && !frames.empty()) frames.front().locals.swap(*variables);
+            variables = nullptr;
+        }
+        ~KeepVariables() { (*this)(); }
+    } keepVariables{frames, variables};
+    const Module::Function* callee = nullptr;
+
+    while (!frames.empty()) {
+        // References below are only valid until the frame stack changes
+        Frame& frame = frames.back();
+        const IRFunction& func = *frame.info->func;
+        auto& labels = frame.info->labels;
+        size_t& ip = frame.ip;
+        bool switched = false;  // Frame stack changed; resume with the new top frame
+
+        while (ip < func.instructions.size()) {
+            const auto& instr = func.instructions[ip];
+            
+            if (profile && instr.site) recordProfile(*profile, instr, frame);
+            
+            // Int-specialized opcodes: fast path when both operands are ints, generic handler otherwise
+            IROpCode op = instr.opcode;
+            if (op != genericOpCode(op)) {
+                const Value& a = frame.slot(instr.operands[0]);
+                const Value& b = frame.slot(instr.operands[1]);
+                if (std::holds_alternative<int>(a) && std::holds_alternative<int>(b)) {
+                    int x = std::get<int>(a);
+                    int y = std::get<int>(b);
+                    int r = 0;
+                    switch (op) {
+                        case IROpCode::ADD_INT: r = x + y; break;
+                        case IROpCode::SUB_INT: r = x - y; break;
+                        case IROpCode::MUL_INT: r = x * y; break;
+                        case IROpCode::EQ_INT: r = x == y; break;
+                        case IROpCode::NE_INT: r = x != y; break;
+                        case IROpCode::LT_INT: r = x < y; break;
+                        case IROpCode::GT_INT: r = x > y; break;
+                        case IROpCode::LE_INT: r = x <= y; break;
+                        case IROpCode::GE_INT: r = x >= y; break;
+                        default: break;
+                    }
+                    frame.slot(instr.result) = r;
+                    ip++;
+                    continue;
+                }
+                op = genericOpCode(op);
+            }
+            
+            if (op == IROpCode::LOAD_INT) {
+                int v = std::stoi(instr.operands[0].name);
+                frame.slot(instr.result) = v;
+            } else if (op == IROpCode::LOAD_FLOAT) {
+                double v = std::stod(instr.operands[0].name);
+                frame.slot(instr.result) = v;
+            } else if (op == IROpCode::LOAD_STRING) {
+                frame.slot(instr.result) = instr.operands[0].name;
+            } else if (op == IROpCode::LOAD_ARRAY) {
+                ArrayRef arrayValue = heap->allocate(instr.operands.size());
+                for (const auto& operand : instr.operands) {
+                    arrayValue->elements.push_back(frame.slot(operand));
+                }
+                frame.slot(instr.result) = arrayValue;
+            } else if (op == IROpCode::ADD) {
+                const Value& a = frame.slot(instr.operands[0]);
+                const Value& b = frame.slot(instr.operands[1]);
+                
+                // Helper to convert Value to int
+                auto toInt = [](const Value& v) -> int {
+                    if (std::holds_alternative<int>(v)) return std::get<int>(v);
+                    if (std::holds_alternative<double>(v)) return static_cast<int>(std::get<double>(v));
+                    if (std::holds_alternative<std::string>(v)) return std::stoi(std::get<std::string>(v));
+                    throw std::runtime_error("Cannot convert to int");
+                };
+                
+                frame.slot(instr.result) = toInt(a) + toInt(b);
+            } else if (op == IROpCode::SUB) {
+                const Value& a = frame.slot(instr.operands[0]);
+                const Value& b = frame.slot(instr.operands[1]);
+                
+                auto toInt = [](const Value& v) -> int {
+                    if (std::holds_alternative<int>(v)) return std::get<int>(v);
+                    if (std::holds_alternative<double>(v)) return static_cast<int>(std::get<double>(v));
+                    if (std::holds_alternative<std::string>(v)) return std::stoi(std::get<std::string>(v));
+                    throw std::runtime_error("Cannot convert to int");
+                };
+                
+                frame.slot(instr.result) = toInt(a) - toInt(b);
+            } else if (op == IROpCode::MUL) {
+                const Value& a = frame.slot(instr.operands[0]);
+                const Value& b = frame.slot(instr.operands[1]);
+                
+                auto toInt = [](const Value& v) -> int {
+                    if (std::holds_alternative<int>(v)) return std::get<int>(v);
+                    if (std::holds_alternative<double>(v)) return static_cast<int>(std::get<double>(v));
+                    if (std::holds_alternative<std::string>(v)) return std::stoi(std::get<std::string>(v));
+                    throw std::runtime_error("Cannot convert to int");
+                };
+                
+                frame.slot(instr.result) = toInt(a) * toInt(b);
+            } else if (op == IROpCode::DIV) {
+                const Value& a = frame.slot(instr.operands[0]);
+                const Value& b = frame.slot(instr.operands[1]);
+                
+                auto toInt = [](const Value& v) -> int {
+                    if (std::holds_alternative<int>(v)) return std::get<int>(v);
+                    if (std::holds_alternative<double>(v)) return static_cast<int>(std::get<double>(v));
+                    if (std::holds_alternative<std::string>(v)) return std::stoi(std::get<std::string>(v));
+                    throw std::runtime_error("Cannot convert to int");
+                };
+                
+                int divisor = toInt(b);
+                if (divisor == 0) throw std::runtime_error("Division by zero");
+                frame.slot(instr.result) = toInt(a) / divisor;
+            } else if (op == IROpCode::MOD) {
+                const Value& a = frame.slot(instr.operands[0]);
+                const Value& b = frame.slot(instr.operands[1]);
+                
+                auto toInt = [](const Value& v) -> int {
+                    if (std::holds_alternative<int>(v)) return std::get<int>(v);
+                    if (std::holds_alternative<double>(v)) return static_cast<int>(std::get<double>(v));
+                    if (std::holds_alternative<std::string>(v)) return std::stoi(std::get<std::string>(v));
+                    throw std::runtime_error("Cannot convert to int");
+                };
+                
+                int divisor = toInt(b);
+                if (divisor == 0) throw std::runtime_error("Division by zero");
+                frame.slot(instr.result) = toInt(a) % divisor;
+            } else if (op == IROpCode::CONCAT) {
+                Value& target = frame.slot(instr.result);
+                const Value& left = frame.slot(instr.operands[0]);
+                const Value& right = frame.slot(instr.operands[1]);
+                std::string* text = std::get_if<std::string>(&target);
+                if (text && &right != &target) {
+                    // Built in the string the result already holds. s = (s, x) appends where s is, its
+                    // capacity growing geometrically, so building a string in a loop is linear.
+                    MemoryStats& stats = heap->stats();
+                    stats.strings++;
+                    size_t capacity = text->capacity();
+                    if (&left != &target) {
+                        text->clear();
+                        appendValue(*text, left);
+                    }
+                    appendValue(*text, right);
+                    countGrowth(stats, capacity, text->capacity());
+                    if (text->capacity() == capacity) stats.stringsReused++;
+                } else {
+                    // The result is the right operand or isn't a string yet: build in the scratch buffer
+                    scratch.clear();
+                    size_t capacity = scratch.capacity();
+                    appendValue(scratch, left);
+                    appendValue(scratch, right);
+                    countGrowth(heap->stats(), capacity, scratch.capacity());
+                    storeString(target, scratch);
+                }
+            } else if (op == IROpCode::NEG) {
+                const Value& a = frame.slot(instr.operands[0]);
+                if (std::holds_alternative<double>(a)) {
+                    frame.slot(instr.result) = -std::get<double>(a);
+                } else {
+                    frame.slot(instr.result) = -valueToInt(a);
+                }
+            } else if (op == IROpCode::NOT) {
+                bool a = valueToBool(frame.slot(instr.operands[0]));
+                frame.slot(instr.result) = a ? 0 : 1;
+            } else if (op == IROpCode::AND) {
+                bool a = valueToBool(frame.slot(instr.operands[0]));
+                bool b = valueToBool(frame.slot(instr.operands[1]));
+                frame.slot(instr.result) = (a && b) ? 1 : 0;
+            } else if (op == IROpCode::OR) {
+                bool a = valueToBool(frame.slot(instr.operands[0]));
+                bool b = valueToBool(frame.slot(instr.operands[1]));
+                frame.slot(instr.result) = (a || b) ? 1 : 0;
+            } else if (op == IROpCode::LEN) {
+                const Value& arrVal = frame.slot(instr.operands[0]);
+                if (!std::holds_alternative<ArrayRef>(arrVal)) {
+                    throw std::runtime_error("len can only be used on arrays");
+                }
+                const ArrayRef& arr = std::get<ArrayRef>(arrVal);
+                frame.slot(instr.result) = static_cast<int>(arr ? arr->elements.size() : 0);
+            } else if (op == IROpCode::PRINT) {
+                writeValue(out, frame.slot(instr.operands[0]));
+                out.flush();
+            } else if (op == IROpCode::LT) {
+                const Value& a = frame.slot(instr.operands[0]);
+                const Value& b = frame.slot(instr.operands[1]);
+                int result = std::visit([](const auto& x, const auto& y) -> int {
+                    using X = std::decay_t<decltype(x)>;
+                    using Y = std::decay_t<decltype(y)>;
+                    if constexpr (std::is_same_v<X, int> && std::is_same_v<Y, int>) {
+                        return x < y ? 1 : 0;
+                    } else if constexpr ((std::is_same_v<X, int> && std::is_same_v<Y, double>) ||
+                                         (std::is_same_v<X, double> && std::is_same_v<Y, int>) ||
+                                         (std::is_same_v<X, double> && std::is_same_v<Y, double>)) {
+                        return static_cast<double>(x) < static_cast<double>(y) ? 1 : 0;
+                    } else if constexpr (std::is_same_v<X, std::string> && std::is_same_v<Y, std::string>) {
+                        return x < y ? 1 : 0;
+                    } else {
+                        throw std::runtime_error("Invalid types for LT");
+                    }
+                }, a, b);
+                frame.slot(instr.result) = result;
+            } else if (op == IROpCode::GT) {
+                const Value& a = frame.slot(instr.operands[0]);
+                const Value& b = frame.slot(instr.operands[1]);
+                int result = std::visit([](const auto& x, const auto& y) -> int {
+                    using X = std::decay_t<decltype(x)>;
+                    using Y = std::decay_t<decltype(y)>;
+                    if constexpr (std::is_same_v<X, int> && std::is_same_v<Y, int>) {
+                        return x > y ? 1 : 0;
+                    } else if constexpr ((std::is_same_v<X, int> && std::is_same_v<Y, double>) ||
+                                         (std::is_same_v<X, double> && std::is_same_v<Y, int>) ||
+                                         (std::is_same_v<X, double> && std::is_same_v<Y, double>)) {
+                        return static_cast<double>(x) > static_cast<double>(y) ? 1 : 0;
+                    } else if constexpr (std::is_same_v<X, std::string> && std::is_same_v<Y, std::string>) {
+                        return x > y ? 1 : 0;
+                    } else {
+                        throw std::runtime_error("Invalid types for GT");
+                    }
+                }, a, b);
+                frame.slot(instr.result) = result;
+            } else if (op == IROpCode::LE) {
+                const Value& a = frame.slot(instr.operands[0]);
+                const Value& b = frame.slot(instr.operands[1]);
+                int result = std::visit([](const auto& x, const auto& y) -> int {
+                    using X = std::decay_t<decltype(x)>;
+                    using Y = std::decay_t<decltype(y)>;
+                    if constexpr (std::is_same_v<X, int> && std::is_same_v<Y, int>) {
+                        return x <= y ? 1 : 0;
+                    } else if constexpr ((std::is_same_v<X, int> && std::is_same_v<Y, double>) ||
+                                         (std::is_same_v<X, double> && std::is_same_v<Y, int>) ||
+                                         (std::is_same_v<X, double> && std::is_same_v<Y, double>)) {
+                        return static_cast<double>(x) <= static_cast<double>(y) ? 1 : 0;
+                    } else if constexpr (std::is_same_v<X, std::string> && std::is_same_v<Y, std::string>) {
+                        return x <= y ? 1 : 0;
+                    } else {
+                        throw std::runtime_error("Invalid types for LE");
+                    }
+                }, a, b);
+                frame.slot(instr.result) = result;
+            } else if (op == IROpCode::GE) {
+                const Value& a = frame.slot(instr.operands[0]);
+                const Value& b = frame.slot(instr.operands[1]);
+                int result = std::visit([](const auto& x, const auto& y) -> int {
+                    using X = std::decay_t<decltype(x)>;
+                    using Y = std::decay_t<decltype(y)>;
+                    if constexpr (std::is_same_v<X, int> && std::is_same_v<Y, int>) {
+                        return x >= y ? 1 : 0;
+                    } else if constexpr ((std::is_same_v<X, int> && std::is_same_v<Y, double>) ||
+                                         (std::is_same_v<X, double> && std::is_same_v<Y, int>) ||
+                                         (std::is_same_v<X, double> && std::is_same_v<Y, double>)) {
+                        return static_cast<double>(x) >= static_cast<double>(y) ? 1 : 0;
+                    } else if constexpr (std::is_same_v<X, std::string> && std::is_same_v<Y, std::string>) {
+                        return x >= y ? 1 : 0;
+                    } else {
+                        throw std::runtime_error("Invalid types for GE");
+                    }
+                }, a, b);
+                frame.slot(instr.result) = result;
+            } else if (op == IROpCode::EQ) {
+                const Value& a = frame.slot(instr.operands[0]);
+                const Value& b = frame.slot(instr.operands[1]);
+                int result = std::visit([](const auto& x, const auto& y) -> int {
+                    using X = std::decay_t<decltype(x)>;
+                    using Y = std::decay_t<decltype(y)>;
+                    if constexpr (std::is_same_v<X, int> && std::is_same_v<Y, int>) {
+                        return x == y ? 1 : 0;
+                    } else if constexpr ((std::is_same_v<X, int> && std::is_same_v<Y, double>) ||
+                                         (std::is_same_v<X, double> && std::is_same_v<Y, int>) ||
+                                         (std::is_same_v<X, double> && std::is_same_v<Y, double>)) {
+                        return static_cast<double>(x) == static_cast<double>(y) ? 1 : 0;
+                    } else if constexpr (std::is_same_v<X, std::string> && std::is_same_v<Y, std::string>) {
+                        return x == y ? 1 : 0;
+                    } else {
+                        throw std::runtime_error("Invalid types for EQ");
+                    }
+                }, a, b);
+                frame.slot(instr.result) = result;
+            } else if (op == IROpCode::NE) {
+                const Value& a = frame.slot(instr.operands[0]);
+                const Value& b = frame.slot(instr.operands[1]);
+                int result = std::visit([](const auto& x, const auto& y) -> int {
+                    using X = std::decay_t<decltype(x)>;
+                    using Y = std::decay_t<decltype(y)>;
+                    if constexpr (std::is_same_v<X, int> && std::is_same_v<Y, int>) {
+                        return x != y ? 1 : 0;
+                    } else if constexpr ((std::is_same_v<X, int> && std::is_same_v<Y, double>) ||
+                                         (std::is_same_v<X, double> && std::is_same_v<Y, int>) ||
+                                         (std::is_same_v<X, double> && std::is_same_v<Y, double>)) {
+                        return static_cast<double>(x) != static_cast<double>(y) ? 1 : 0;
+                    } else if constexpr (std::is_same_v<X, std::string> && std::is_same_v<Y, std::string>) {
+                        return x != y ? 1 : 0;
+                    } else {
+                        throw std::runtime_error("Invalid types for NE");
+                    }
+                }, a, b);
+                frame.slot(instr.result) = result;
+            } else if (op == IROpCode::JZ) {
+                if (!valueToBool(frame.slot(instr.operands[0]))) {
+                    ip = jump(ip, labels.at(instr.label));
+                    continue;
+                }
+            } else if (op == IROpCode::JNZ) {
+                if (valueToBool(frame.slot(instr.operands[0]))) {
+                    ip = jump(ip, labels.at(instr.label));
+                    continue;
+                }
+            } else if (op == IROpCode::JMP) {
+                ip = jump(ip, labels.at(instr.label));
+                continue;
+            } else if (op == IROpCode::JUMP_TABLE || op == IROpCode::SWITCH) {
+                // Multiway branch on an integer; anything without a case takes the default label
+                const Value& v = frame.slot(instr.operands[0]);
+                bool integral = false;
+                int key = 0;
+                if (std::holds_alternative<int>(v)) {
+                    key = std::get<int>(v);
+                    integral = true;
+                } else if (std::holds_alternative<double>(v)) {
+                    double d = std::get<double>(v);
+                    integral = d >= std::numeric_limits<int>::min() && d <= std::numeric_limits<int>::max() &&
+                               d == static_cast<int>(d);
+                    key = integral ? static_cast<int>(d) : 0;
+                } else {
+                    throw std::runtime_error("Invalid types for EQ");
+                }
+                const std::string* target = &instr.label;
+                if (integral && op == IROpCode::JUMP_TABLE) {
+                    long index = static_cast<long>(key) - instr.cases.front().first;
+                    if (index >= 0 && index < static_cast<long>(instr.cases.size())) target = &instr.cases[index].second;
+                } else if (integral) {
+                    auto it = std::lower_bound(instr.cases.begin(), instr.cases.end(), key,
+                        [](const std::pair<int, std::string>& c, int k) { return c.first < k; });
+                    if (it != instr.cases.end() && it->first == key) target = &it->second;
+                }
+                ip = jump(ip, labels.at(*target));
+                continue;
+            } else if (op == IROpCode::STORE) {
+                frame.slot(instr.result) = frame.slot(instr.operands[0]);
+            } else if (op == IROpCode::LOAD_INDEX) {
+                const Value& arrVal = frame.slot(instr.operands[0]);
+                int idx = valueToInt(frame.slot(instr.operands[1]));
+                if (!std::holds_alternative<ArrayRef>(arrVal)) {
+                    throw std::runtime_error("Attempted index access on non-array value");
+                }
+                const ArrayRef& arr = std::get<ArrayRef>(arrVal);
+                if (!arr || idx < 0 || static_cast<size_t>(idx) >= arr->elements.size()) {
+                    throw std::runtime_error("Array index out of bounds");
+                }
+                Value element = arr->elements[idx];  // The result may be the register holding the array
+                frame.slot(instr.result) = std::move(element);
+            } else if (op == IROpCode::STORE_INDEX) {
+                Value& arrVal = frame.slot(instr.operands[0]);
+                int idx = valueToInt(frame.slot(instr.operands[1]));
+                Value newValue = frame.slot(instr.operands[2]);
+                if (!std::holds_alternative<ArrayRef>(arrVal)) {
+                    throw std::runtime_error("Attempted index assignment on non-array value");
+                }
+                const ArrayRef& arr = std::get<ArrayRef>(arrVal);
+                if (!arr || idx < 0 || static_cast<size_t>(idx) >= arr->elements.size()) {
+                    throw std::runtime_error("Array index out of bounds");
+                }
+                arr->elements[idx] = newValue;
+                frame.slot(instr.result) = arr;
+            } else if (op == IROpCode::LOAD_INDEX_UNCHECKED) {
+                // Index proven to be an in-range int by the optimizer
+                const ArrayRef& arr = std::get<ArrayRef>(frame.slot(instr.operands[0]));
+                int idx = std::get<int>(frame.slot(instr.operands[1]));
+                Value element = arr->elements[idx];
+                frame.slot(instr.result) = std::move(element);
+            } else if (op == IROpCode::STORE_INDEX_UNCHECKED) {
+                const ArrayRef& arr = std::get<ArrayRef>(frame.slot(instr.operands[0]));
+                int idx = std::get<int>(frame.slot(instr.operands[1]));
+                arr->elements[idx] = frame.slot(instr.operands[2]);
+            } else if (op == IROpCode::INPUT) {
+                // Print the prompt if provided
+                if (!instr.prompt.empty()) {
+                    out << instr.prompt;
+                    out.flush();
+                }
+                std::string input;
+                std::getline(in, input);
+                frame.slot(instr.result) = input;
+            } else if (op == IROpCode::KEY_PRESSED) {
+                // Read a single character without waiting for Enter; only the process's own stdin is a terminal
+                char key = &in == &std::cin ? readSingleKey() : static_cast<char>(in.get());
+                std::string keyStr(1, key);
+                frame.slot(instr.result) = keyStr;
+            } else if (op == IROpCode::SCREEN) {
+                // Screen initialization: create graphics window
+                if (instr.operands.size() >= 3) {
+                    auto toInt = [](const Value& v) -> int {
+                        if (std::holds_alternative<int>(v)) return std::get<int>(v);
+                        if (std::holds_alternative<double>(v)) return static_cast<int>(std::get<double>(v));
+                        if (std::holds_alternative<std::string>(v)) {
+                            try { return std::stoi(std::get<std::string>(v)); } catch (...) { return 0; }
+                        }
+                        return 0;
+                    };
+                    
+                    auto toString = [](const Value& v) -> std::string {
+                        if (std::holds_alternative<std::string>(v)) return std::get<std::string>(v);
+                        if (std::holds_alternative<int>(v)) return std::to_string(std::get<int>(v));
+                        if (std::holds_alternative<double>(v)) return std::to_string(std::get<double>(v));
+                        return "";
+                    };
+                    
+                    int width = toInt(frame.slot(instr.operands[0]));
+                    int height = toInt(frame.slot(instr.operands[1]));
+                    std::string title = toString(frame.slot(instr.operands[2]));
+                    
+                    try {
+                        if (!headless) {
+                            closeWindow();
+                            graphics = openGraphics(width, height, title);
+                            out << "\033[2J\033[1;1H";  // Clear terminal
+                            out << "Graphics window created: " << width << "x" << height << " - " << title << std::endl;
+                        }
+                    } catch (const std::exception& e) {
+                        err << "Failed to create graphics window: " << e.what() << std::endl;
+                    }
+                }
+                frame.slot(instr.result) = 1;  // Return success
+            } else if (op == IROpCode::DRAW_PIXEL) {
+                // drawPixel(x, y, r, g, b)
+                if (graphics && instr.operands.size() >= 5) {
+                    auto toInt = [](const Value& v) -> int {
+                        if (std::holds_alternative<int>(v)) return std::get<int>(v);
+                        if (std::holds_alternative<double>(v)) return static_cast<int>(std::get<double>(v));
+                        if (std::holds_alternative<std::string>(v)) {
+                            try { return std::stoi(std::get<std::string>(v)); } catch (...) { return 0; }
+                        }
+                        return 0;
+                    };
+                    int x = toInt(frame.slot(instr.operands[0]));
+                    int y = toInt(frame.slot(instr.operands[1]));
+                    int r = toInt(frame.slot(instr.operands[2]));
+                    int g = toInt(frame.slot(instr.operands[3]));
+                    int b = toInt(frame.slot(instr.operands[4]));
+                    graphics->drawPixel(x, y, r, g, b);
+                    frame.slot(instr.result) = 1;
+                }
+            } else if (op == IROpCode::DRAW_RECT) {
+                // drawRect(x, y, w, h, r, g, b, filled)
+                if (graphics && instr.operands.size() >= 8) {
+                    auto toInt = [](const Value& v) -> int {
+                        if (std::holds_alternative<int>(v)) return std::get<int>(v);
+                        if (std::holds_alternative<double>(v)) return static_cast<int>(std::get<double>(v));
+                        if (std::holds_alternative<std::string>(v)) {
+                            try { return std::stoi(std::get<std::string>(v)); } catch (...) { return 0; }
+                        }
+                        return 0;
+                    };
+                    int x = toInt(frame.slot(instr.operands[0]));
+                    int y = toInt(frame.slot(instr.operands[1]));
+                    int w = toInt(frame.slot(instr.operands[2]));
+                    int h = toInt(frame.slot(instr.operands[3]));
+                    int r = toInt(frame.slot(instr.operands[4]));
+                    int g = toInt(frame.slot(instr.operands[5]));
+                    int b = toInt(frame.slot(instr.operands[6]));
+                    int filled = toInt(frame.slot(instr.operands[7]));
+                    graphics->drawRect(x, y, w, h, r, g, b, filled);
+                    frame.slot(instr.result) = 1;
+                }
+            } else if (op == IROpCode::DRAW_LINE) {
+                // drawLine(x1, y1, x2, y2, r, g, b)
+                if (graphics && instr.operands.size() >= 7) {
+                    auto toInt = [](const Value& v) -> int {
+                        if (std::holds_alternative<int>(v)) return std::get<int>(v);
+                        if (std::holds_alternative<double>(v)) return static_cast<int>(std::get<double>(v));
+                        if (std::holds_alternative<std::string>(v)) {
+                            try { return std::stoi(std::get<std::string>(v)); } catch (...) { return 0; }
+                        }
+                        return 0;
+                    };
+                    int x1 = toInt(frame.slot(instr.operands[0]));
+                    int y1 = toInt(frame.slot(instr.operands[1]));
+                    int x2 = toInt(frame.slot(instr.operands[2]));
+                    int y2 = toInt(frame.slot(instr.operands[3]));
+                    int r = toInt(frame.slot(instr.operands[4]));
+                    int g = toInt(frame.slot(instr.operands[5]));
+                    int b = toInt(frame.slot(instr.operands[6]));
+                    graphics->drawLine(x1, y1, x2, y2, r, g, b);
+                    frame.slot(instr.result) = 1;
+                }
+            } else if (op == IROpCode::DRAW_CIRCLE) {
+                // drawCircle(x, y, radius, r, g, b, filled)
+                if (graphics && instr.operands.size() >= 7) {
+                    auto toInt = [](const Value& v) -> int {
+                        if (std::holds_alternative<int>(v)) return std::get<int>(v);
+                        if (std::holds_alternative<double>(v)) return static_cast<int>(std::get<double>(v));
+                        if (std::holds_alternative<std::string>(v)) {
+                            try { return std::stoi(std::get<std::string>(v)); } catch (...) { return 0; }
+                        }
+                        return 0;
+                    };
+                    int x = toInt(frame.slot(instr.operands[0]));
+                    int y = toInt(frame.slot(instr.operands[1]));
+                    int radius = toInt(frame.slot(instr.operands[2]));
+                    int r = toInt(frame.slot(instr.operands[3]));
+                    int g = toInt(frame.slot(instr.operands[4]));
+                    int b = toInt(frame.slot(instr.operands[5]));
+                    int filled = toInt(frame.slot(instr.operands[6]));
+                    graphics->drawCircle(x, y, radius, r, g, b, filled);
+                    frame.slot(instr.result) = 1;
+                }
+            } else if (op == IROpCode::CLEAR_SCREEN) {
+                // clearScreen(r, g, b) - Clear to color
+                if (graphics && instr.operands.size() >= 3) {
+                    auto toInt = [](const Value& v) -> int {
+                        if (std::holds_alternative<int>(v)) return std::get<int>(v);
+                        if (std::holds_alternative<double>(v)) return static_cast<int>(std::get<double>(v));
+                        if (std::holds_alternative<std::string>(v)) {
+                            try { return std::stoi(std::get<std::string>(v)); } catch (...) { return 0; }
+                        }
+                        return 0;
+                    };
+                    int r = toInt(frame.slot(instr.operands[0]));
+                    int g = toInt(frame.slot(instr.operands[1]));
+                    int b = toInt(frame.slot(instr.operands[2]));
+                    graphics->clear(r, g, b);
+                    frame.slot(instr.result) = 1;
+                }
+            } else if (op == IROpCode::PRESENT) {
+                // present() - Update display
+                if (graphics) {
+                    graphics->handleEvents();
+                    graphics->present();
+                    // Check if window was closed via X button or Alt+F4
+                    if (graphics->shouldClose()) {
+                        closeWindow();
+                        stopped = true;
+                        keepVariables();
+                        frames.clear();  // Exit program
+                        switched = true;
+                        break;
+                    }
+                }
+                frame.slot(instr.result) = 1;
+                if (reloadPending.load(std::memory_order_acquire)) {
+                    // Safepoint: between frames, so swapping code can't tear a frame's drawing
+                    ModulePtr next;
+                    {
+                        std::lock_guard<std::mutex> guard(reloadLock);
+                        next = std::move(pendingReload);
+                        reloadPending.store(false, std::memory_order_relaxed);
+                    }
+                    if (next) load(std::move(next));
+                    ip++;
+                    remapFrames(frames, [this](const std::string& name) { return findFunction(name); });
+                    switched = true;
+                    break;
+                }
+            } else if (op == IROpCode::CALL_NATIVE && instr.native == NATIVE_SNAPSHOT) {
+                // snapshot() - Save every frame as it will be after this call, which returns 1 on resuming
+                frame.slot(instr.result) = 0;
+                if (!snapshotPath.empty()) {
+                    if (graphics) {
+                        throw std::runtime_error("snapshot() must come before screen(): a window can't be saved");
+                    }
+                    if (depth > 1) {
+                        throw std::runtime_error("snapshot() can't be taken in a script called from a native function");
+                    }
+                    Snapshot snapshot;
+                    snapshot.program = fingerprint();
+                    frame.slot(instr.result) = 1;
+                    for (const auto& saved : frames) {
+                        snapshot.frames.push_back(
+                            {saved.info->func->name, saved.ip, saved.registers, saved.locals, saved.resultSlot});
+                    }
+                    snapshot.frames.back().ip = ip + 1;
+                    frame.slot(instr.result) = 0;
+                    saveSnapshot(snapshotPath, snapshot);
+                }
+            } else if (op == IROpCode::CALL_NATIVE && instr.native >= NATIVE_COUNT) {
+                // Bound function: its thunk reads the argument registers in place
+                const NativeBinding& binding = (*frame.info->natives)[instr.native - NATIVE_COUNT];
+                const Value* args[kMaxNativeArity];
+                for (size_t i = 0; i < instr.operands.size(); ++i) {
+                    args[i] = &frame.slot(instr.operands[i]);
+                }
+                frame.slot(instr.result) = binding.thunk(*this, binding.function, args);
+            } else if (op == IROpCode::CALL_NATIVE) {
+                // Builtin: index straight into the native table
+                std::vector<Value> args;
+                args.reserve(instr.operands.size());
+                for (const auto& operand : instr.operands) {
+                    args.push_back(frame.slot(operand));
+                }
+                bool halt = false;
+                frame.slot(instr.result) = kNatives[instr.native](*this, args, halt);
+                if (halt) {
+                    stopped = true;
+                    keepVariables();
+                    frames.clear();  // Exit program
+                    switched = true;
+                    break;
+                }
+            } else if (op == IROpCode::CALL && (callee = findFunction(instr.label))) {
+                // User function call: push a frame and resume at the callee's first instruction
+                charge(1);
+                std::vector<Value> args;
+                for (const auto& operand : instr.operands) {
+                    args.push_back(frame.slot(operand));
+                }
+                Frame next;
+                enterFunction(next, callee, args);
+                next.resultSlot = instr.result;
+                ip++;
+                frames.push_back(std::move(next));
+                switched = true;
+                break;
+            } else if (op == IROpCode::TAIL_CALL) {
+                // Tail call: the callee takes over this frame and returns straight to our caller
+                charge(1);
+                std::vector<Value> args;
+                for (const auto& operand : instr.operands) {
+                    args.push_back(frame.slot(operand));
+                }
+                callee = findFunction(instr.label);
+                if (!callee) throw std::runtime_error("No function named '" + instr.label + "'");
+                if (frames.size() == 1) keepVariables();
+                enterFunction(frame, callee, args);
+                switched = true;
+                break;
+            } else if (op == IROpCode::RET) {
+                Value result = instr.operands.empty() ? Value(0) : frame.slot(instr.operands[0]);
+                IRValue slot = frame.resultSlot;
+                if (frames.size() == 1) keepVariables();
+                frames.pop_back();
+                if (!frames.empty()) {
+                    frames.back().slot(slot) = result;
+                } else {
+                    returned = result;
+                }
+                switched = true;
+                break;
+            } else if (op == IROpCode::LABEL) {
+                // No-op
+            }
+            
+            ip++;
+        }
+
+        if (!switched) {
+            // Fell off the end of the function: return without a value
+            IRValue slot = frame.resultSlot;
+            if (frames.size() == 1) keepVariables();
+            frames.pop_back();
+            if (!frames.empty()) {
+                frames.back().slot(slot) = Value();
+            }
+        }
+    }
+    return returned;
+}
@@ -1,10 +1,11 @@
-#include "graphics.h"
+#include "sdl_graphics.h"
 #include <cmath>
 #include <stdexcept>
 #include <iostream>
 #include <algorithm>
+#include <type_traits>
 
-Graphics::Graphics(int w, int h, const std::string& title)
+SdlGraphics::SdlGraphics(int w, int h, const std::string& title)
     : width(w), height(h), open(false), window(nullptr), renderer(nullptr), keyState(nullptr) {
     
     if (SDL_Init(SDL_INIT_VIDEO) < 0) {
@@ -43,12 +44,12 @@ Graphics::Graphics(int w, int h, const std::string& title)
     open = true;
 }
 
-Graphics::~Graphics() {
+SdlGraphics::~SdlGraphics() {
     freeAllImages();
     close();
 }
 
-void Graphics::close() {
+void SdlGraphics::close() {
     freeAllImages();
     if (renderer) {
         SDL_DestroyRenderer(renderer);
@@ -63,13 +64,13 @@ void Graphics::close() {
     open = false;
 }
 
-void Graphics::setTitle(const std::string& title) {
+void SdlGraphics::setTitle(const std::string& title) {
     if (window) {
         SDL_SetWindowTitle(window, title.c_str());
     }
 }
 
-void Graphics::handleEvents() {
+void SdlGraphics::handleEvents() {
     SDL_Event event;
     while (SDL_PollEvent(&event)) {
         if (event.type == SDL_QUIT) {
@@ -82,24 +83,24 @@ void Graphics::handleEvents() {
     }
 }
 
-void Graphics::clear(int r, int g, int b) {
+void SdlGraphics::clear(int r, int g, int b) {
     if (!renderer) return;
     SDL_SetRenderDrawColor(renderer, r, g, b, 255);
     SDL_RenderClear(renderer);
 }
 
-void Graphics::present() {
+void SdlGraphics::present() {
     if (!renderer) return;
     SDL_RenderPresent(renderer);
 }
 
-void Graphics::drawPixel(int x, int y, int r, int g, int b, int a) {
+void SdlGraphics::drawPixel(int x, int y, int r, int g, int b, int a) {
     if (!renderer || x < 0 || y < 0 || x >= width || y >= height) return;
     SDL_SetRenderDrawColor(renderer, r, g, b, a);
     SDL_RenderDrawPoint(renderer, x, y);
 }
 
-void Graphics::drawRect(int x, int y, int w, int h, int r, int g, int b, int filled) {
+void SdlGraphics::drawRect(int x, int y, int w, int h, int r, int g, int b, int filled) {
     if (!renderer) return;
     SDL_Rect rect = {x, y, w, h};
     SDL_SetRenderDrawColor(renderer, r, g, b, 255);
@@ -111,17 +112,17 @@ void Graphics::drawRect(int x, int y, int w, int h, int r, int g, int b, int fil
     }
 }
 
-void Graphics::fillRect(int x, int y, int w, int h, int r, int g, int b) {
+void SdlGraphics::fillRect(int x, int y, int w, int h, int r, int g, int b) {
     drawRect(x, y, w, h, r, g, b, 1);
 }
 
-void Graphics::drawLine(int x1, int y1, int x2, int y2, int r, int g, int b) {
+void SdlGraphics::drawLine(int x1, int y1, int x2, int y2, int r, int g, int b) {
     if (!renderer) return;
     SDL_SetRenderDrawColor(renderer, r, g, b, 255);
     SDL_RenderDrawLine(renderer, x1, y1, x2, y2);
 }
 
-void Graphics::midpointCircle(int x, int y, int radius, int r, int g, int b) {
+void SdlGraphics::midpointCircle(int x, int y, int radius, int r, int g, int b) {
     int x0 = 0;
     int y0 = radius;
     int d = 3 - 2 * radius;
@@ -148,7 +149,7 @@ void Graphics::midpointCircle(int x, int y, int radius, int r, int g, int b) {
     }
 }
 
-void Graphics::drawCircle(int x, int y, int radius, int r, int g, int b, int filled) {
+void SdlGraphics::drawCircle(int x, int y, int radius, int r, int g, int b, int filled) {
     if (!renderer) return;
     
     if (filled) {
@@ -162,11 +163,11 @@ void Graphics::drawCircle(int x, int y, int radius, int r, int g, int b, int fil
     }
 }
 
-void Graphics::fillCircle(int x, int y, int radius, int r, int g, int b) {
+void SdlGraphics::fillCircle(int x, int y, int radius, int r, int g, int b) {
     drawCircle(x, y, radius, r, g, b, 1);
 }
 
-void Graphics::drawTriangle(int x1, int y1, int x2, int y2, int x3, int y3, int r, int g, int b, int filled) {
+void SdlGraphics::drawTriangle(int x1, int y1, int x2, int y2, int x3, int y3, int r, int g, int b, int filled) {
     if (!renderer) return;
     
     if (filled) {
@@ -178,7 +179,7 @@ void Graphics::drawTriangle(int x1, int y1, int x2, int y2, int x3, int y3, int
     }
 }
 
-void Graphics::fillTriangle(int x1, int y1, int x2, int y2, int x3, int y3, int r, int g, int b) {
+void SdlGraphics::fillTriangle(int x1, int y1, int x2, int y2, int x3, int y3, int r, int g, int b) {
     if (!renderer) return;
     
     SDL_SetRenderDrawColor(renderer, r, g, b, 255);
@@ -217,7 +218,7 @@ void Graphics::fillTriangle(int x1, int y1, int x2, int y2, int x3, int y3, int
 }
 
 // Image/Texture support
-bool Graphics::loadImage(const std::string& filename, const std::string& name) {
+bool SdlGraphics::loadImage(const std::string& filename, const std::string& name) {
     if (!renderer) return false;
     
     if (textures.find(name) != textures.end()) {
@@ -242,7 +243,7 @@ bool Graphics::loadImage(const std::string& filename, const std::string& name) {
     return true;
 }
 
-void Graphics::blitImage(const std::string& name, int x, int y) {
+void SdlGraphics::blitImage(const std::string& name, int x, int y) {
     if (!renderer || textures.find(name) == textures.end()) return;
     
     SDL_Texture* texture = textures[name];
@@ -253,7 +254,7 @@ void Graphics::blitImage(const std::string& name, int x, int y) {
     SDL_RenderCopy(renderer, texture, nullptr, &dstRect);
 }
 
-void Graphics::blitImageScaled(const std::string& name, int x, int y, int w, int h) {
+void SdlGraphics::blitImageScaled(const std::string& name, int x, int y, int w, int h) {
     if (!renderer || textures.find(name) == textures.end()) return;
     
     SDL_Texture* texture = textures[name];
@@ -261,41 +262,48 @@ void Graphics::blitImageScaled(const std::string& name, int x, int y, int w, int
     SDL_RenderCopy(renderer, texture, nullptr, &dstRect);
 }
 
-void Graphics::freeImage(const std::string& name) {
+void SdlGraphics::freeImage(const std::string& name) {
     if (textures.find(name) != textures.end()) {
         SDL_DestroyTexture(textures[name]);
         textures.erase(name);
     }
 }
 
-void Graphics::freeAllImages() {
+void SdlGraphics::freeAllImages() {
     for (auto& pair : textures) {
         SDL_DestroyTexture(pair.second);
     }
     textures.clear();
 }
 
-bool Graphics::imageExists(const std::string& name) const {
+bool SdlGraphics::imageExists(const std::string& name) const {
     return textures.find(name) != textures.end();
 }
 
-void Graphics::drawText(const std::string& text, int x, int y, int r, int g, int b) {
+void SdlGraphics::drawText(const std::string& text, int x, int y, int r, int g, int b) {
     // Basic text rendering - in a full implementation, would use SDL_ttf
     // For now, just a placeholder
     (void)text; (void)x; (void)y; (void)r; (void)g; (void)b;
 }
 
-bool Graphics::isKeyPressed(SDL_Keycode key) {
+bool SdlGraphics::isKeyPressed(const std::string& key) {
+    static const std::unordered_map<std::string, SDL_Keycode> keys = {
+        {"a", SDLK_a}, {"d", SDLK_d}, {"w", SDLK_w}, {"s", SDLK_s},
+        {"space", SDLK_SPACE}, {"left", SDLK_LEFT}, {"right", SDLK_RIGHT},
+        {"up", SDLK_UP}, {"down", SDLK_DOWN}, {"escape", SDLK_ESCAPE},
+    };
+    auto it = keys.find(key);
+    if (it == keys.end()) return false;
     keyState = SDL_GetKeyboardState(nullptr);
-    SDL_Scancode scancode = SDL_GetScancodeFromKey(key);
+    SDL_Scancode scancode = SDL_GetScancodeFromKey(it->second);
     return keyState != nullptr && keyState[scancode] != 0;
 }
 
-bool Graphics::getMousePos(int& x, int& y) {
+bool SdlGraphics::getMousePos(int& x, int& y) {
     return SDL_GetMouseState(&x, &y) != 0;
 }
 
-bool Graphics::isMouseButtonDown(int button) {
+bool SdlGraphics::isMouseButtonDown(int button) {
     int mouseState = SDL_GetMouseState(nullptr, nullptr);
     switch (button) {
         case 1: return (mouseState & SDL_BUTTON_LMASK) != 0;  // Left
@@ -304,3 +312,15 @@ bool Graphics::isMouseButtonDown(int button) {
         default: return false;
     }
 }
+
+// zppOpenGraphics: The plugin's entry point, looked up by openGraphics(); see GraphicsFactory
+// Errors come back as text rather than as exceptions, which shouldn't cross the dlopen boundary.
+extern "C" Graphics* zppOpenGraphics(int width, int height, const char* title, std::string* error) {
+    try {
+        return new SdlGraphics(width, height, title);
+    } catch (const std::exception& e) {
+        *error = e.what();
+        return nullptr;
+    }
+}
+static_assert(std::is_same<decltype(&zppOpenGraphics), GraphicsFactory>::value, "zppOpenGraphics must match GraphicsFactory");
@@ -0,0 +1,60 @@
+#include "graphics.h"
+#include <cstdlib>
+#include <mutex>
+#include <stdexcept>
+#include <string>
+#include <vector>
+#include <dlfcn.h>
+#include <limits.h>
+#include <unistd.h>
+
+namespace {
+
+const char* const kPluginName = "libzpp_graphics.so";
+
+// pluginCandidates: Where to look for the plugin, in order
+std::vector<std::string> pluginCandidates() {
+    const char* configured = std::getenv("ZPP_GRAPHICS_PLUGIN");
+    if (configured && *configured) return {configured};
+    std::vector<std::string> candidates;
+    char exe[PATH_MAX];
+    ssize_t length = readlink("/proc/self/exe", exe, sizeof(exe) - 1);
+    if (length > 0) {
+        std::string path(exe, static_cast<size_t>(length));
+        candidates.push_back(path.substr(0, path.rfind('/') + 1) + kPluginName);
+    }
+    candidates.push_back(kPluginName);  // The dynamic linker's search path
+    return candidates;
+}
+
+// loadFactory: Load the plugin once per process; it stays loaded, as windows' code lives in it
+GraphicsFactory loadFactory() {
+    static std::mutex lock;
+    static GraphicsFactory factory = nullptr;
+    static std::string failure;
+    std::lock_guard<std::mutex> guard(lock);
+    if (factory) return factory;
+    if (failure.empty()) {
+        for (const auto& candidate : pluginCandidates()) {
+            void* handle = dlopen(candidate.c_str(), RTLD_NOW | RTLD_LOCAL);
+            if (!handle) {
+                failure = dlerror();
+                continue;
+            }
+            factory = reinterpret_cast<GraphicsFactory>(dlsym(handle, "zppOpenGraphics"));
+            if (factory) return factory;
+            failure = candidate + " has no zppOpenGraphics";
+            dlclose(handle);
+        }
+    }
+    throw std::runtime_error("Graphics plugin unavailable: " + failure);
+}
+
+} // namespace
+
+Graphics* openGraphics(int width, int height, const std::string& title) {
+    std::string error;
+    Graphics* graphics = loadFactory()(width, height, title.c_str(), &error);
+    if (!graphics) throw std::runtime_error(error);
+    return graphics;
+}
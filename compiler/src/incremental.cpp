@@ -0,0 +1,189 @@
+#include "incremental.h"
+#include "builtins.h"
+#include "optimizer.h"
+#include "parser.h"
+#include <algorithm>
+#include <map>
+#include <set>
+#include <sstream>
+#include <unordered_map>
+
+namespace {
+
+uint64_t fingerprintTokens(const std::vector<Token>& tokens, size_t begin, size_t end) {
+    std::string text;
+    for (size_t i = begin; i < end; ++i) {
+        text += std::to_string(static_cast<int>(tokens[i].type));
+        text += ':';
+        text += tokens[i].value;
+        text += '\0';
+    }
+    return hashText(text);
+}
+
+// Functions reachable from a unit through calls, the unit itself included
+std::set<size_t> reachable(size_t unit, const std::vector<FunctionUnit>& units,
+                           const std::unordered_map<std::string, size_t>& byName) {
+    std::set<size_t> seen;
+    std::vector<size_t> stack = {unit};
+    while (!stack.empty()) {
+        size_t u = stack.back();
+        stack.pop_back();
+        if (!seen.insert(u).second) continue;
+        for (const auto& callee : units[u].callees) {
+            auto it = byName.find(callee);
+            if (it != byName.end()) stack.push_back(it->second);
+        }
+    }
+    return seen;
+}
+
+// Compile every function, bypassing the cache
+IRProgram compileAll(const std::vector<Token>& tokens, const Profile* profile,
+                     const std::vector<Builtin>* natives) {
+    Parser parser(tokens);
+    auto ast = parser.parse();
+    IRGenerator irgen(ast, natives);
+    auto ir = irgen.generate();
+    IROptimizer optimizer(ir, profile);
+    optimizer.optimize();
+    return ir;
+}
+
+} // namespace
+
+bool splitFunctions(const std::vector<Token>& tokens, std::vector<FunctionUnit>& units) {
+    units.clear();
+    size_t i = 0;
+    while (i < tokens.size()) {
+        while (i < tokens.size() && tokens[i].type == TokenType::NEWLINE) i++;
+        if (i >= tokens.size() || tokens[i].type == TokenType::END_OF_FILE) return true;
+
+        // Imports are resolved by the module loader, not compiled here
+        if (tokens[i].type == TokenType::IMPORT) {
+            if (i + 2 >= tokens.size() || tokens[i + 1].type != TokenType::STRING ||
+                tokens[i + 2].type != TokenType::SEMICOLON) {
+                return false;
+            }
+            i += 3;
+            continue;
+        }
+
+        FunctionUnit unit;
+        unit.begin = i;
+
+        // Header: the name is the identifier before the parameter list
+        while (i < tokens.size() && tokens[i].type != TokenType::LPAREN) i++;
+        if (i == unit.begin || i >= tokens.size() || tokens[i - 1].type != TokenType::IDENTIFIER) return false;
+        unit.name = tokens[i - 1].value;
+        while (i < tokens.size() && tokens[i].type != TokenType::LBRACE) i++;
+
+        // Body: up to the matching closing brace
+        int depth = 0;
+        for (; i < tokens.size(); ++i) {
+            if (tokens[i].type == TokenType::LBRACE) {
+                depth++;
+            } else if (tokens[i].type == TokenType::RBRACE) {
+                if (--depth == 0) break;
+            } else if (tokens[i].type == TokenType::IDENTIFIER && i + 1 < tokens.size() &&
+                       tokens[i + 1].type == TokenType::LPAREN) {
+                unit.callees.push_back(tokens[i].value);
+            } else if (tokens[i].type == TokenType::END_OF_FILE) {
+                return false;
+            }
+        }
+        if (i >= tokens.size()) return false;
+        unit.end = ++i;
+        unit.fingerprint = fingerprintTokens(tokens, unit.begin, unit.end);
+        units.push_back(unit);
+    }
+    return true;
+}
+
+IncrementalCompiler::IncrementalCompiler(CompileCache& cache, const std::string& flags, const Profile* profile,
+                                         const std::vector<Builtin>* natives)
+    : cache(cache), flags(flags), profile(profile), natives(natives), reused(0), compiled(0) {}
+
+IRProgram IncrementalCompiler::compile(const std::string& source) {
+    reused = 0;
+    compiled = 0;
+
+    Lexer lexer(source);
+    auto tokens = lexer.tokenize();
+
+    std::vector<FunctionUnit> units;
+    std::unordered_map<std::string, size_t> byName;
+    bool split = splitFunctions(tokens, units);
+    for (size_t u = 0; split && u < units.size(); ++u) {
+        split = byName.emplace(units[u].name, u).second;
+    }
+    if (!split) {
+        // Malformed or duplicated functions: the parser and VM decide what they mean
+        auto ir = compileAll(tokens, profile, natives);
+        compiled = ir.functions.size();
+        return ir;
+    }
+
+    // Key each function by its fingerprint and those of everything it reaches
+    std::vector<std::set<size_t>> reach(units.size());
+    std::vector<std::string> keys(units.size());
+    for (size_t u = 0; u < units.size(); ++u) {
+        reach[u] = reachable(u, units, byName);
+        std::map<std::string, uint64_t> inputs;
+        for (size_t r : reach[u]) inputs[units[r].name] = units[r].fingerprint;
+        std::ostringstream text;
+        text << "function " << units[u].name << "\n" << std::hex;
+        for (const auto& input : inputs) text << input.first << " " << input.second << "\n";
+        keys[u] = CompileCache::key(text.str(), flags);
+    }
+
+    std::vector<IRFunction> result(units.size());
+    std::set<std::string> dirty;
+    std::set<size_t> needed;
+    for (size_t u = 0; u < units.size(); ++u) {
+        IRProgram entry;
+        if (cache.load(keys[u], entry) && entry.functions.size() == 1) {
+            result[u] = std::move(entry.functions[0]);
+            reused++;
+        } else {
+            dirty.insert(units[u].name);
+            needed.insert(reach[u].begin(), reach[u].end());
+        }
+    }
+
+    if (!dirty.empty()) {
+        // Parse the changed functions and the callees they may inline, in source order
+        std::vector<Token> subset;
+        for (size_t u : needed) {
+            subset.insert(subset.end(), tokens.begin() + units[u].begin, tokens.begin() + units[u].end);
+        }
+        subset.push_back(Token(TokenType::END_OF_FILE));
+        Parser parser(subset);
+        auto ast = parser.parse();
+        if (ast->functions.size() != needed.size()) {
+            auto ir = compileAll(tokens, profile, natives);
+            compiled = ir.functions.size();
+            reused = 0;
+            return ir;
+        }
+        IRGenerator irgen(ast, natives);
+        auto ir = irgen.generate();
+        IROptimizer optimizer(ir, profile);
+        optimizer.optimize(dirty);
+
+        size_t next = 0;
+        for (size_t u : needed) {
+            IRFunction& func = ir.functions[next++];
+            if (!dirty.count(func.name)) continue;
+            IRProgram entry;
+            entry.functions.push_back(func);
+            cache.store(keys[u], entry);
+            result[u] = std::move(func);
+            compiled++;
+        }
+    }
+
+    IRProgram program;
+    program.functions = std::move(result);
+    return program;
+}
@@ -1,4 +1,6 @@
 #include "ir.h" 
+#include "builtins.h"
+#include <algorithm>
 #include <sstream>
 #include <stdexcept>
 
@@ -33,7 +35,8 @@ std::string IRInstruction::toString() const {
         
         if (opcode != IROpCode::JMP && opcode != IROpCode::JZ && 
             opcode != IROpCode::JNZ && opcode != IROpCode::RET &&
-            opcode != IROpCode::NOP) {
+            opcode != IROpCode::TAIL_CALL && opcode != IROpCode::JUMP_TABLE &&
+            opcode != IROpCode::SWITCH && opcode != IROpCode::NOP) {
             oss << " -> " << result.toString();
         }
     }
@@ -63,13 +66,28 @@ std::string opCodeToString(IROpCode opcode) {
         case IROpCode::JZ: return "JZ";
         case IROpCode::JNZ: return "JNZ";
         case IROpCode::CALL: return "CALL";
+        case IROpCode::CALL_NATIVE: return "CALL_NATIVE";
         case IROpCode::RET: return "RET";
+        case IROpCode::TAIL_CALL: return "TAIL_CALL";
+        case IROpCode::ADD_INT: return "ADD_INT";
+        case IROpCode::SUB_INT: return "SUB_INT";
+        case IROpCode::MUL_INT: return "MUL_INT";
+        case IROpCode::EQ_INT: return "EQ_INT";
+        case IROpCode::NE_INT: return "NE_INT";
+        case IROpCode::LT_INT: return "LT_INT";
+        case IROpCode::GT_INT: return "GT_INT";
+        case IROpCode::LE_INT: return "LE_INT";
+        case IROpCode::GE_INT: return "GE_INT";
+        case IROpCode::JUMP_TABLE: return "JUMP_TABLE";
+        case IROpCode::SWITCH: return "SWITCH";
         case IROpCode::LOAD: return "LOAD";
         case IROpCode::STORE: return "STORE";
         case IROpCode::LOAD_GLOBAL: return "LOAD_GLOBAL";
         case IROpCode::STORE_GLOBAL: return "STORE_GLOBAL";
         case IROpCode::LOAD_INDEX: return "LOAD_INDEX";
         case IROpCode::STORE_INDEX: return "STORE_INDEX";
+        case IROpCode::LOAD_INDEX_UNCHECKED: return "LOAD_INDEX_UNCHECKED";
+        case IROpCode::STORE_INDEX_UNCHECKED: return "STORE_INDEX_UNCHECKED";
         case IROpCode::LOAD_INT: return "LOAD_INT";
         case IROpCode::LOAD_FLOAT: return "LOAD_FLOAT";
         case IROpCode::LOAD_STRING: return "LOAD_STRING";
@@ -91,8 +109,8 @@ std::string opCodeToString(IROpCode opcode) {
     }
 }
 
-IRGenerator::IRGenerator(const ProgramPtr& ast)
-    : ast(ast), currentFunction(nullptr), tempCounter(0), labelCounter(0) {}
+IRGenerator::IRGenerator(const ProgramPtr& ast, const std::vector<Builtin>* natives)
+    : ast(ast), natives(natives), currentFunction(nullptr), tempCounter(0), labelCounter(0) {}
 
 IRProgram IRGenerator::generate() {
     visitProgram(ast);
@@ -172,24 +190,180 @@ void IRGenerator::visitReturnStatement(const std::shared_ptr<ReturnStatement>& r
     }
 }
 
+namespace {
+
+// Minimum number of arms before an elif chain becomes a table or search
+const size_t kMinSwitchArms = 4;
+
+// Match `name == value` or `value == name` with an integer literal value
+bool matchCaseTest(const ExpressionPtr& expr, std::string& name, int& value) {
+    auto binOp = std::dynamic_pointer_cast<BinaryOp>(expr);
+    if (!binOp || binOp->op != TokenType::EQUAL) return false;
+
+    auto constant = [](const ExpressionPtr& e, int& out) {
+        bool negative = false;
+        ExpressionPtr inner = e;
+        if (auto unary = std::dynamic_pointer_cast<UnaryOp>(e)) {
+            if (unary->op != TokenType::MINUS) return false;
+            negative = true;
+            inner = unary->operand;
+        }
+        auto lit = std::dynamic_pointer_cast<Literal>(inner);
+        if (!lit || lit->type != TokenType::INTEGER) return false;
+        try {
+            out = std::stoi(lit->value);
+        } catch (...) {
+            return false;
+        }
+        if (negative) out = -out;
+        return true;
+    };
+
+    auto left = std::dynamic_pointer_cast<Identifier>(binOp->left);
+    auto right = std::dynamic_pointer_cast<Identifier>(binOp->right);
+    if (left && constant(binOp->right, value)) {
+        name = left->name;
+        return true;
+    }
+    if (right && constant(binOp->left, value)) {
+        name = right->name;
+        return true;
+    }
+    return false;
+}
+
+// appendable: Can the part be evaluated ahead of the appends before it? It mustn't involve name or
+// assign any variable, which a part evaluated earlier may have read. Unknown node types can't.
+bool appendable(const ExpressionPtr& expr, const std::string& name) {
+    if (!expr || std::dynamic_pointer_cast<Literal>(expr) || std::dynamic_pointer_cast<KeyPressedCall>(expr)) {
+        return true;
+    }
+    if (auto id = std::dynamic_pointer_cast<Identifier>(expr)) return id->name != name;
+    if (auto binOp = std::dynamic_pointer_cast<BinaryOp>(expr)) {
+        return appendable(binOp->left, name) && appendable(binOp->right, name);
+    }
+    if (auto unaryOp = std::dynamic_pointer_cast<UnaryOp>(expr)) return appendable(unaryOp->operand, name);
+    if (auto call = std::dynamic_pointer_cast<FunctionCall>(expr)) {
+        for (const auto& arg : call->arguments) {
+            if (!appendable(arg, name)) return false;
+        }
+        return true;
+    }
+    if (auto access = std::dynamic_pointer_cast<ArrayAccess>(expr)) {
+        return appendable(access->array, name) && appendable(access->index, name);
+    }
+    if (auto literal = std::dynamic_pointer_cast<ArrayLiteral>(expr)) {
+        for (const auto& element : literal->elements) {
+            if (!appendable(element, name)) return false;
+        }
+        return true;
+    }
+    if (auto input = std::dynamic_pointer_cast<InputCall>(expr)) return appendable(input->prompt, name);
+    return false;
+}
+
+// Match `name = (name, a, b, ...)` with appendable parts; parts receives a, b, ... in order
+bool matchAppend(const std::shared_ptr<Assignment>& assign, std::vector<ExpressionPtr>& parts) {
+    ExpressionPtr expr = assign->value;
+    std::shared_ptr<BinaryOp> concat;
+    while ((concat = std::dynamic_pointer_cast<BinaryOp>(expr)) && concat->op == TokenType::COMMA) {
+        if (!appendable(concat->right, assign->name)) return false;
+        parts.push_back(concat->right);
+        expr = concat->left;
+    }
+    auto head = std::dynamic_pointer_cast<Identifier>(expr);
+    if (!head || head->name != assign->name || parts.empty()) return false;
+    std::reverse(parts.begin(), parts.end());
+    return true;
+}
+
+} // namespace
+
+bool IRGenerator::visitSwitchChain(const std::shared_ptr<IfStatement>& ifStmt) {
+    // Walk the elif chain while every arm tests the same variable against a constant
+    std::string var;
+    std::vector<std::pair<int, StatementPtr>> arms;
+    StatementPtr otherwise;
+    std::shared_ptr<IfStatement> arm = ifStmt;
+    while (arm) {
+        std::string name;
+        int value = 0;
+        if (!matchCaseTest(arm->condition, name, value) || (!var.empty() && name != var)) {
+            otherwise = arm;
+            break;
+        }
+        var = name;
+        bool seen = false;
+        for (const auto& existing : arms) {
+            if (existing.first == value) seen = true;  // Later duplicates can never match
+        }
+        if (!seen) arms.push_back({value, arm->thenBranch});
+
+        auto next = std::dynamic_pointer_cast<IfStatement>(arm->elseBranch);
+        if (!next) otherwise = arm->elseBranch;
+        arm = next;
+    }
+    if (arms.size() < kMinSwitchArms) return false;
+
+    std::string endLabel = createLabel();
+    std::string defaultLabel = otherwise ? createLabel() : endLabel;
+    std::vector<std::string> armLabels;
+    for (size_t i = 0; i < arms.size(); ++i) armLabels.push_back(createLabel());
+
+    std::vector<std::pair<int, std::string>> cases;
+    for (size_t i = 0; i < arms.size(); ++i) cases.push_back({arms[i].first, armLabels[i]});
+    std::sort(cases.begin(), cases.end());
+
+    // Dense value ranges index a table directly, sparse ones are searched
+    long range = static_cast<long>(cases.back().first) - cases.front().first + 1;
+    IRInstruction dispatch(range <= static_cast<long>(2 * cases.size()) ? IROpCode::JUMP_TABLE : IROpCode::SWITCH);
+    dispatch.operands.push_back(visitIdentifier(std::make_shared<Identifier>(var)));
+    dispatch.label = defaultLabel;
+    if (dispatch.opcode == IROpCode::JUMP_TABLE) {
+        size_t next = 0;
+        for (long value = cases.front().first; value <= cases.back().first; ++value) {
+            bool present = next < cases.size() && cases[next].first == value;
+            dispatch.cases.push_back({static_cast<int>(value), present ? cases[next++].second : defaultLabel});
+        }
+    } else {
+        dispatch.cases = cases;
+    }
+    emitInstruction(dispatch);
+
+    for (size_t i = 0; i < arms.size(); ++i) {
+        emitLabel(armLabels[i]);
+        visitStatement(arms[i].second);
+        IRInstruction jmpEnd(IROpCode::JMP);
+        jmpEnd.label = endLabel;
+        emitInstruction(jmpEnd);
+    }
+    if (otherwise) {
+        emitLabel(defaultLabel);
+        visitStatement(otherwise);
+    }
+    emitLabel(endLabel);
+    return true;
+}
+
 void IRGenerator::visitIfStatement(const std::shared_ptr<IfStatement>& ifStmt) {
-    IRValue cond = visitExpression(ifStmt->condition);
+    if (ifStmt->elseBranch && visitSwitchChain(ifStmt)) return;
     
-    std::string thenLabel = createLabel();
-    std::string elseLabel = createLabel();
     std::string endLabel = createLabel();
     
+    if (!ifStmt->elseBranch) {
+        // Skip the then branch if condition is false
+        visitCondition(ifStmt->condition, endLabel, false);
+        visitStatement(ifStmt->thenBranch);
+        emitLabel(endLabel);
+        return;
+    }
+    
+    std::string elseLabel = createLabel();
+    
     // Jump to else if condition is false
-    IRInstruction jz(IROpCode::JZ);
-    jz.operands.push_back(cond);
-    jz.label = elseLabel;
-    emitInstruction(jz);
+    visitCondition(ifStmt->condition, elseLabel, false);
     
     // Then branch
-    IRInstruction thenLabelInstr(IROpCode::LABEL);
-    thenLabelInstr.label = thenLabel;
-    emitInstruction(thenLabelInstr);
-    
     visitStatement(ifStmt->thenBranch);
     
     IRInstruction jmpEnd(IROpCode::JMP);
@@ -197,18 +371,11 @@ void IRGenerator::visitIfStatement(const std::shared_ptr<IfStatement>& ifStmt) {
     emitInstruction(jmpEnd);
     
     // Else branch
-    IRInstruction elseLabelInstr(IROpCode::LABEL);
-    elseLabelInstr.label = elseLabel;
-    emitInstruction(elseLabelInstr);
-    
-    if (ifStmt->elseBranch) {
-        visitStatement(ifStmt->elseBranch);
-    }
+    emitLabel(elseLabel);
+    visitStatement(ifStmt->elseBranch);
     
     // End label
-    IRInstruction endLabelInstr(IROpCode::LABEL);
-    endLabelInstr.label = endLabel;
-    emitInstruction(endLabelInstr);
+    emitLabel(endLabel);
 }
 
 void IRGenerator::visitWhileStatement(const std::shared_ptr<WhileStatement>& whileStmt) {
@@ -221,12 +388,7 @@ void IRGenerator::visitWhileStatement(const std::shared_ptr<WhileStatement>& whi
     emitInstruction(loopLabelInstr);
     
     // Check condition
-    IRValue cond = visitExpression(whileStmt->condition);
-    
-    IRInstruction jz(IROpCode::JZ);
-    jz.operands.push_back(cond);
-    jz.label = endLabel;
-    emitInstruction(jz);
+    visitCondition(whileStmt->condition, endLabel, false);
     
     // Loop body
     visitStatement(whileStmt->body);
@@ -258,12 +420,7 @@ void IRGenerator::visitForStatement(const std::shared_ptr<ForStatement>& forStmt
     
     // Check condition
     if (forStmt->condition) {
-        IRValue cond = visitExpression(forStmt->condition);
-        
-        IRInstruction jz(IROpCode::JZ);
-        jz.operands.push_back(cond);
-        jz.label = endLabel;
-        emitInstruction(jz);
+        visitCondition(forStmt->condition, endLabel, false);
     }
     
     // Loop body
@@ -350,17 +507,34 @@ IRValue IRGenerator::visitExpression(const ExpressionPtr& expr) {
 }
 
 IRValue IRGenerator::visitBinaryOp(const std::shared_ptr<BinaryOp>& binOp) {
+    if (binOp->op == TokenType::AND || binOp->op == TokenType::OR) {
+        // Materialize a short-circuit condition as 0/1:
+        //   result = 0; <branch to end if false>; result = 1; end:
+        IRValue result = createTemp();
+        std::string endLabel = createLabel();
+        
+        IRInstruction loadFalse(IROpCode::LOAD_INT);
+        loadFalse.operands.push_back(IRValue(IRValue::Type::CONSTANT, "0"));
+        loadFalse.result = result;
+        emitInstruction(loadFalse);
+        
+        visitCondition(binOp, endLabel, false);
+        
+        IRInstruction loadTrue(IROpCode::LOAD_INT);
+        loadTrue.operands.push_back(IRValue(IRValue::Type::CONSTANT, "1"));
+        loadTrue.result = result;
+        emitInstruction(loadTrue);
+        
+        emitLabel(endLabel);
+        return result;
+    }
+    
     IRValue left = visitExpression(binOp->left);
     IRValue right = visitExpression(binOp->right);
     IRValue result = createTemp();
     
-    // Use CONCAT for comma or || when concatenating values
-    IROpCode opcode = IROpCode::NOP;
-    if (binOp->op == TokenType::OR || binOp->op == TokenType::COMMA) {
-        opcode = IROpCode::CONCAT;
-    } else {
-        opcode = tokenTypeToOpCode(binOp->op);
-    }
+    // Comma concatenates its operands
+    IROpCode opcode = tokenTypeToOpCode(binOp->op);
     
     IRInstruction instr(opcode);
     instr.operands.push_back(left);
@@ -375,7 +549,8 @@ IRValue IRGenerator::visitUnaryOp(const std::shared_ptr<UnaryOp>& unaryOp) {
     IRValue operand = visitExpression(unaryOp->operand);
     IRValue result = createTemp();
     
-    IROpCode opcode = tokenTypeToOpCode(unaryOp->op);
+    // Unary minus is negation, not the binary SUB the token maps to
+    IROpCode opcode = unaryOp->op == TokenType::MINUS ? IROpCode::NEG : tokenTypeToOpCode(unaryOp->op);
     
     IRInstruction instr(opcode);
     instr.operands.push_back(operand);
@@ -395,6 +570,9 @@ IRValue IRGenerator::visitLiteral(const std::shared_ptr<Literal>& lit) {
         loadOp = IROpCode::LOAD_FLOAT;
     } else if (lit->type == TokenType::STRING) {
         loadOp = IROpCode::LOAD_STRING;
+    } else if (lit->type == TokenType::TRUE_LIT || lit->type == TokenType::FALSE_LIT) {
+        // Booleans are 0/1 ints at runtime
+        loadOp = IROpCode::LOAD_INT;
     } else {
         return val;
     }
@@ -424,125 +602,24 @@ IRValue IRGenerator::visitIdentifier(const std::shared_ptr<Identifier>& id) {
 IRValue IRGenerator::visitFunctionCall(const std::shared_ptr<FunctionCall>& call) {
     IRValue result = createTemp();
     
-    // Handle screen() function specially
-    if (call->name == "len") {
-        if (call->arguments.size() != 1) {
-            throw std::runtime_error("len expects exactly one argument");
-        }
-
-        IRInstruction instr(IROpCode::LEN);
-        instr.operands.push_back(visitExpression(call->arguments[0]));
-        instr.result = result;
-        emitInstruction(instr);
-        return result;
-    }
-    
-    if (call->name == "screen") {
-        IRInstruction instr(IROpCode::SCREEN);
-        
-        // Extract width, height, and title from arguments
-        for (size_t i = 0; i < call->arguments.size(); i++) {
-            IRValue argVal = visitExpression(call->arguments[i]);
-            instr.operands.push_back(argVal);
-        }
-        
-        instr.result = result;
-        emitInstruction(instr);
-        return result;
-    }
-    
-    // Handle graphics drawing functions
-    if (call->name == "clearScreen") {
-        IRInstruction instr(IROpCode::CLEAR_SCREEN);
-        for (const auto& arg : call->arguments) {
-            IRValue argVal = visitExpression(arg);
-            instr.operands.push_back(argVal);
-        }
-        instr.result = result;
-        emitInstruction(instr);
-        return result;
-    }
-    
-    if (call->name == "drawPixel") {
-        IRInstruction instr(IROpCode::DRAW_PIXEL);
-        for (const auto& arg : call->arguments) {
-            IRValue argVal = visitExpression(arg);
-            instr.operands.push_back(argVal);
-        }
-        instr.result = result;
-        emitInstruction(instr);
-        return result;
-    }
-    
-    if (call->name == "drawRect") {
-        IRInstruction instr(IROpCode::DRAW_RECT);
-        for (const auto& arg : call->arguments) {
-            IRValue argVal = visitExpression(arg);
-            instr.operands.push_back(argVal);
-        }
-        instr.result = result;
-        emitInstruction(instr);
-        return result;
+    // Builtins lower to their own opcode, or to CALL_NATIVE with the id the interpreter dispatches on
+    const Builtin* builtin = findBuiltin(call->name);
+    for (size_t i = 0; !builtin && natives && i < natives->size(); ++i) {
+        if ((*natives)[i].name == call->name) builtin = &(*natives)[i];
     }
-    
-    if (call->name == "drawLine") {
-        IRInstruction instr(IROpCode::DRAW_LINE);
-        for (const auto& arg : call->arguments) {
-            IRValue argVal = visitExpression(arg);
-            instr.operands.push_back(argVal);
+    if (builtin) {
+        if (call->arguments.size() != builtin->parameterTypes.size()) {
+            throw std::runtime_error(call->name + " expects " + std::to_string(builtin->parameterTypes.size()) +
+                                     " argument(s), got " + std::to_string(call->arguments.size()));
         }
-        instr.result = result;
-        emitInstruction(instr);
-        return result;
-    }
-    
-    if (call->name == "drawCircle") {
-        IRInstruction instr(IROpCode::DRAW_CIRCLE);
+        IRInstruction instr(builtin->opcode);
         for (const auto& arg : call->arguments) {
-            IRValue argVal = visitExpression(arg);
-            instr.operands.push_back(argVal);
+            instr.operands.push_back(visitExpression(arg));
         }
-        instr.result = result;
-        emitInstruction(instr);
-        return result;
-    }
-    
-    if (call->name == "display") {
-        IRInstruction instr(IROpCode::PRESENT);
-        instr.result = result;
-        emitInstruction(instr);
-        return result;
-    }
-    
-    if (call->name == "quit") {
-        // For now, quit just exits the program
-        // We can handle this in the interpreter
-        IRInstruction instr(IROpCode::CALL);
-        instr.label = "quit";
-        instr.result = result;
-        emitInstruction(instr);
-        return result;
-    }
-    
-    if (call->name == "isKeyDown") {
-        // isKeyDown(keyCode) - returns 1 if key is pressed, 0 otherwise
-        IRInstruction instr(IROpCode::CALL);
-        instr.label = "isKeyDown";
-        
-        if (call->arguments.size() > 0) {
-            IRValue keyVal = visitExpression(call->arguments[0]);
-            instr.operands.push_back(keyVal);
+        if (builtin->opcode == IROpCode::CALL_NATIVE) {
+            instr.label = builtin->name;
+            instr.native = builtin->native;
         }
-        
-        instr.result = result;
-        emitInstruction(instr);
-        return result;
-    }
-    
-    if (call->name == "updateInput") {
-        // updateInput() - update keyboard state
-        IRInstruction instr(IROpCode::CALL);
-        instr.label = "updateInput";
         instr.result = result;
         emitInstruction(instr);
         return result;
@@ -563,6 +640,25 @@ IRValue IRGenerator::visitFunctionCall(const std::shared_ptr<FunctionCall>& call
 }
 
 IRValue IRGenerator::visitAssignment(const std::shared_ptr<Assignment>& assign) {
+    // s = (s, a, b): the parts are appended to s where it is, instead of concatenated into a copy that
+    // is stored back, so building a string in a loop is linear. Every part is evaluated first, so s
+    // only changes through the CONCATs, which can't fail halfway.
+    std::vector<ExpressionPtr> parts;
+    auto known = symbolTable.find(assign->name);
+    if (known != symbolTable.end() && known->second.type == IRValue::Type::LOCAL && matchAppend(assign, parts)) {
+        IRValue var = known->second;
+        std::vector<IRValue> values;
+        for (const auto& part : parts) values.push_back(visitExpression(part));
+        for (const auto& value : values) {
+            IRInstruction instr(IROpCode::CONCAT);
+            instr.operands.push_back(var);
+            instr.operands.push_back(value);
+            instr.result = var;
+            emitInstruction(instr);
+        }
+        return var;
+    }
+    
     IRValue value = visitExpression(assign->value);
     
     auto it = symbolTable.find(assign->name);
@@ -626,6 +722,39 @@ IRValue IRGenerator::visitArrayElementAssignment(const std::shared_ptr<ArrayElem
     return valueVal;
 }
 
+void IRGenerator::visitCondition(const ExpressionPtr& expr, const std::string& target, bool jumpIfTrue) {
+    auto binOp = std::dynamic_pointer_cast<BinaryOp>(expr);
+    if (binOp && (binOp->op == TokenType::AND || binOp->op == TokenType::OR)) {
+        bool isAnd = binOp->op == TokenType::AND;
+        if (isAnd != jumpIfTrue) {
+            // a && b jumps when false if either side is false;
+            // a || b jumps when true if either side is true
+            visitCondition(binOp->left, target, jumpIfTrue);
+            visitCondition(binOp->right, target, jumpIfTrue);
+        } else {
+            // The left operand alone decides the opposite outcome,
+            // so it skips over the right operand
+            std::string skipLabel = createLabel();
+            visitCondition(binOp->left, skipLabel, !jumpIfTrue);
+            visitCondition(binOp->right, target, jumpIfTrue);
+            emitLabel(skipLabel);
+        }
+        return;
+    }
+    
+    auto unaryOp = std::dynamic_pointer_cast<UnaryOp>(expr);
+    if (unaryOp && unaryOp->op == TokenType::NOT) {
+        visitCondition(unaryOp->operand, target, !jumpIfTrue);
+        return;
+    }
+    
+    IRValue cond = visitExpression(expr);
+    IRInstruction jump(jumpIfTrue ? IROpCode::JNZ : IROpCode::JZ);
+    jump.operands.push_back(cond);
+    jump.label = target;
+    emitInstruction(jump);
+}
+
 IRValue IRGenerator::createTemp() {
     return IRValue(IRValue::Type::TEMP, "t" + std::to_string(tempCounter), tempCounter++);
 }
@@ -634,9 +763,23 @@ std::string IRGenerator::createLabel() {
     return "L" + std::to_string(labelCounter++);
 }
 
+void IRGenerator::emitLabel(const std::string& label) {
+    IRInstruction instr(IROpCode::LABEL);
+    instr.label = label;
+    emitInstruction(instr);
+}
+
 void IRGenerator::emitInstruction(const IRInstruction& instr) {
     if (currentFunction) {
+        // Site: FNV-1a of the function name mixed with the position, stable across compiles
+        uint64_t site = 14695981039346656037ULL;
+        for (unsigned char c : currentFunction->name) {
+            site = (site ^ c) * 1099511628211ULL;
+        }
+        site = (site ^ (currentFunction->instructions.size() + 1)) * 1099511628211ULL;
+        
         currentFunction->instructions.push_back(instr);
+        currentFunction->instructions.back().site = site ? site : 1;
     }
 }
 
@@ -660,3 +803,18 @@ IROpCode IRGenerator::tokenTypeToOpCode(TokenType type) {
         default: return IROpCode::NOP;
     }
 }
+
+IROpCode genericOpCode(IROpCode opcode) {
+    switch (opcode) {
+        case IROpCode::ADD_INT: return IROpCode::ADD;
+        case IROpCode::SUB_INT: return IROpCode::SUB;
+        case IROpCode::MUL_INT: return IROpCode::MUL;
+        case IROpCode::EQ_INT: return IROpCode::EQ;
+        case IROpCode::NE_INT: return IROpCode::NE;
+        case IROpCode::LT_INT: return IROpCode::LT;
+        case IROpCode::GT_INT: return IROpCode::GT;
+        case IROpCode::LE_INT: return IROpCode::LE;
+        case IROpCode::GE_INT: return IROpCode::GE;
+        default: return opcode;
+    }
+}
@@ -28,7 +28,8 @@ const std::unordered_map<std::string, TokenType> Lexer::keywords = {
     {"display", TokenType::DISPLAY},
     {"quit", TokenType::QUIT},
     {"isKeyDown", TokenType::IS_KEY_DOWN},
-    {"updateInput", TokenType::UPDATE_INPUT}
+    {"updateInput", TokenType::UPDATE_INPUT},
+    {"import", TokenType::IMPORT}
 };
 
 Lexer::Lexer(const std::string& source)
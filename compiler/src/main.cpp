@@ -1,20 +1,27 @@
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <functional>
 #include <iostream>
 #include <fstream>
+#include <map>
+#include <memory>
 #include <sstream>
-#include <termios.h>
-#include <unistd.h>
 
-#include "lexer.h"
-#include "parser.h"
-#include "ir.h"
-#include "graphics.h"
+#include "engine.h"
+#include "profile.h"
+#include "cache.h"
+#include "server.h"
+#include "batch.h"
+#include "repl.h"
+#include "watch.h"
+#include <unistd.h>
 
 // readFile: Read entire file contents into a string
 std::string readFile(const std::string& filename) {
     std::ifstream file(filename);
     if (!file.is_open()) {
-        std::cerr << "Error: Could not open file " << filename << std::endl;
-        exit(1);
+        throw std::runtime_error("Could not open file " + filename);
     }
     
     std::stringstream buffer;
@@ -22,580 +29,270 @@ std::string readFile(const std::string& filename) {
     return buffer.str();
 }
 
-// readSingleKey: Read a single character from stdin without waiting for Enter
-// Uses termios to disable canonical mode (line buffering)
-char readSingleKey() {
-    struct termios old_settings, new_settings;
-    tcgetattr(STDIN_FILENO, &old_settings);
-    new_settings = old_settings;
-    new_settings.c_lflag &= ~(ICANON | ECHO);    // Disable canonical mode and echo
-    tcsetattr(STDIN_FILENO, TCSANOW, &new_settings);
-    
-    char ch;
-    read(STDIN_FILENO, &ch, 1);
-    
-    tcsetattr(STDIN_FILENO, TCSANOW, &old_settings);  // Restore original settings
-    return ch;
+
+// Options: Command-line settings for one run
+struct Options {
+    std::string path;
+    std::string profileOut;  // --profile-out FILE: record a profile of this run
+    std::string profileUse;  // --profile-use FILE: optimize with a recorded profile
+    std::string snapshot;    // --snapshot FILE: resume from FILE, or save it when the script calls snapshot()
+    std::string cacheDir = CompileCache::defaultDirectory();  // --cache-dir DIR
+    bool useCache = true;    // --no-cache: always compile from source
+    bool server = false;     // --server: stay resident and run scripts sent by zpp-client
+    bool repl = false;       // --repl: interactive session; the default with no script and a terminal
+    bool watch = false;      // --watch: reload the script into the running program when its files change
+    std::string socketPath = defaultSocketPath();  // --socket PATH
+    std::string batchDir;    // --batch DIR: run every script under DIR concurrently
+    unsigned jobs = 0;       // --jobs N: worker threads for --batch, one per core by default
+    uint64_t instructionLimit = 0;  // --instruction-limit N: stop scripts after about N instructions
+    uint64_t timeLimit = 0;         // --time-limit MS: stop scripts after MS milliseconds
+};
+
+Options parseOptions(const std::vector<std::string>& args) {
+    Options options;
+    for (size_t i = 0; i < args.size(); ++i) {
+        const std::string& arg = args[i];
+        bool hasValue = i + 1 < args.size();
+        if (arg == "--profile-out" && hasValue) {
+            options.profileOut = args[++i];
+        } else if (arg == "--profile-use" && hasValue) {
+            options.profileUse = args[++i];
+        } else if (arg == "--snapshot" && hasValue) {
+            options.snapshot = args[++i];
+        } else if (arg == "--cache-dir" && hasValue) {
+            options.cacheDir = args[++i];
+        } else if (arg == "--no-cache") {
+            options.useCache = false;
+        } else if (arg == "--server") {
+            options.server = true;
+        } else if (arg == "--repl") {
+            options.repl = true;
+        } else if (arg == "--watch") {
+            options.watch = true;
+        } else if (arg == "--socket" && hasValue) {
+            options.socketPath = args[++i];
+        } else if (arg == "--batch" && hasValue) {
+            options.batchDir = args[++i];
+        } else if (arg == "--jobs" && hasValue) {
+            options.jobs = static_cast<unsigned>(std::strtoul(args[++i].c_str(), nullptr, 10));
+        } else if (arg == "--instruction-limit" && hasValue) {
+            options.instructionLimit = std::strtoull(args[++i].c_str(), nullptr, 10);
+        } else if (arg == "--time-limit" && hasValue) {
+            options.timeLimit = std::strtoull(args[++i].c_str(), nullptr, 10);
+        } else {
+            options.path = arg;
+        }
+    }
+    return options;
 }
 
-// Global graphics instance - shared across the interpreter
-Graphics* g_graphics = nullptr;
+// engineConfig: Compiler settings from the command line and ZPP_CACHE_LIMIT
+EngineConfig engineConfig(const Options& options) {
+    EngineConfig config;
+    config.useCache = options.useCache;
+    config.cacheDir = options.cacheDir;
+    config.profileUse = options.profileUse;
+    const char* limit = std::getenv("ZPP_CACHE_LIMIT");
+    if (limit) config.cacheLimit = std::strtoull(limit, nullptr, 10);
+    return config;
+}
 
-// Value type: Variant that can hold int, double, string, bool, or arrays
-// Used for storing runtime values during IR interpretation
-#include <map>
-#include <variant>
-#include <vector>
-#include <memory>
+// applyLimits: Execution limits from the command line; 0 leaves a limit off
+void applyLimits(const Options& options, Instance& instance) {
+    instance.setInstructionLimit(options.instructionLimit);
+    instance.setTimeLimit(std::chrono::milliseconds(options.timeLimit));
+}
 
-struct ArrayValue;
-using Value = std::variant<int, double, std::string, bool, std::shared_ptr<ArrayValue>>;
+// tighterLimit: The stricter of two limits, where 0 means none
+uint64_t tighterLimit(uint64_t a, uint64_t b) {
+    if (a == 0) return b;
+    if (b == 0) return a;
+    return std::min(a, b);
+}
 
-struct ArrayValue {
-    std::vector<Value> elements;
-};
+// wantsRepl: Run an interactive session rather than one script
+bool wantsRepl(const Options& options) {
+    return options.repl || (options.path.empty() && isatty(STDIN_FILENO));
+}
+
+// readScript: Script source from the file named on the command line, or from stdin up to a line "END"
+std::string readScript(const Options& options) {
+    if (!options.path.empty()) return readFile(options.path);
+    std::string source, line;
+    while (std::getline(std::cin, line)) {
+        if (line == "END") break;
+        source += line + "\n";
+    }
+    return source;
+}
 
-int valueToInt(const Value& v) {
-    if (std::holds_alternative<int>(v)) return std::get<int>(v);
-    if (std::holds_alternative<double>(v)) return static_cast<int>(std::get<double>(v));
-    if (std::holds_alternative<std::string>(v)) return std::stoi(std::get<std::string>(v));
-    if (std::holds_alternative<bool>(v)) return std::get<bool>(v) ? 1 : 0;
-    throw std::runtime_error("Cannot convert value to int");
+// runScript: Run a compiled script on this process's streams, recording a profile if asked to
+// With --snapshot, a snapshot of this script as compiled now replaces everything before snapshot();
+// otherwise the script starts from the beginning and saves one there.
+void runScript(const Options& options, const ModulePtr& module) {
+    Instance instance(module);
+    applyLimits(options, instance);
+    if (!options.snapshot.empty()) {
+        instance.setSnapshotFile(options.snapshot);
+        instance.restore(options.snapshot);
+    }
+    Profile profile;
+    if (!options.profileOut.empty()) instance.setProfile(&profile);
+    instance.run();
+    if (!options.profileOut.empty()) profile.save(options.profileOut, hashText(module->text()));
 }
 
-// interpretIR: Execute the IR bytecode
-// Walks through the IR instructions and executes them
-void interpretIR(const IRProgram& ir) {
-    for (const auto& func : ir.functions) {
-        if (func.name == "main") {  // Only execute main function
-            std::map<std::string, Value> temps;           // Runtime value storage
-            std::map<std::string, size_t> labels;         // Label address lookup
-            
-            // First pass: find all labels for jump target resolution
-            for (size_t i = 0; i < func.instructions.size(); ++i) {
-                if (func.instructions[i].opcode == IROpCode::LABEL) {
-                    labels[func.instructions[i].label] = i;
+// runWatch: Run a script, reloading it whenever it or a file it imports changes
+// Changed files compile on the watcher's thread, so only what changed is compiled again when the cache
+// is on; the new code takes over at the script's next display() call, keeping the window and the state
+// of the frame loop. A version that fails to compile is reported and the running one carries on.
+void runWatch(const Options& options) {
+    if (options.path.empty()) {
+        throw std::runtime_error("--watch needs a script file");
+    }
+    Engine engine(engineConfig(options));
+    ModulePtr module = engine.compileFile(options.path);
+    Instance instance(module);
+    applyLimits(options, instance);
+    FileWatcher watcher([&]() {
+        try {
+            ModulePtr next = engine.compileFile(options.path);
+            watcher.watch(next->files());
+            instance.reload(next);
+            std::cerr << "Reloaded " << options.path << std::endl;
+        } catch (const std::exception& e) {
+            std::cerr << "Reload failed: " << e.what() << std::endl;
+        }
+    });
+    watcher.watch(module->files());
+    instance.run();
+}
+
+// runBatchCommand: Compile and run every script under options.batchDir, one isolated instance each
+// Scripts get empty input and no window; their output is captured and shown only if they fail.
+int runBatchCommand(const Options& options) {
+    if (!options.profileOut.empty()) {
+        throw std::runtime_error("--profile-out can't be combined with --batch");
+    }
+    Engine engine(engineConfig(options));
+    auto run = [&engine, &options](const std::string& path, std::ostream& out) {
+        std::istringstream noInput;
+        Instance instance(engine.compileFile(path), noInput, out, out);
+        instance.setHeadless(true);
+        applyLimits(options, instance);
+        instance.run();
+        return 0;
+    };
+    auto results = runBatch(findScripts(options.batchDir), run, options.jobs);
+    return reportBatch(results, std::cout) == 0 ? 0 : 1;
+}
+
+// runServer: Serve zpp-client requests; scripts compile in this process and run in forked children
+// Each distinct compiler configuration gets an engine that keeps its compiled modules in memory, so a
+// repeated script skips the cache lookup on disk too.
+// Limits given to the server itself apply to every request; a request can only tighten them.
+void runServer(const Options& serverOptions) {
+    const size_t kWarmModules = 256;
+    std::map<std::string, std::unique_ptr<Engine>> engines;
+    serve(serverOptions.socketPath, [&](const ServerRequest& request) -> std::function<int()> {
+        Options options = parseOptions(request.args);
+        if (options.server) {
+            throw std::runtime_error("--server can't be sent to a server");
+        }
+        // Paths read here are relative to the client; the job itself runs in the client's directory
+        auto resolve = [&](std::string& path) {
+            if (!path.empty() && path[0] != '/') path = request.cwd + "/" + path;
+        };
+        resolve(options.path);
+        resolve(options.profileUse);
+        resolve(options.snapshot);
+        resolve(options.cacheDir);
+        options.instructionLimit = tighterLimit(options.instructionLimit, serverOptions.instructionLimit);
+        options.timeLimit = tighterLimit(options.timeLimit, serverOptions.timeLimit);
+        
+        if (!options.batchDir.empty()) {
+            return [options]() { return runBatchCommand(options); };
+        }
+        if (options.watch) {
+            return [options]() {
+                try {
+                    runWatch(options);
+                } catch (const std::exception& e) {
+                    std::cerr << "Error: " << e.what() << std::endl;
+                    return 1;
                 }
+                return 0;
+            };
+        }
+        
+        auto fail = [](const std::string& message) -> std::function<int()> {
+            return [message]() {
+                std::cerr << "Error: " << message << std::endl;
+                return 1;
+            };
+        };
+        auto execute = [options](const ModulePtr& module) {
+            try {
+                runScript(options, module);
+            } catch (const std::exception& e) {
+                std::cerr << "Error: " << e.what() << std::endl;
+                return 1;
             }
-            
-            // Debug: print IR instructions
-            // std::cerr << "=== IR Instructions ===" << std::endl;
-            // for (size_t i = 0; i < func.instructions.size(); ++i) {
-            //     std::cerr << i << ": " << func.instructions[i].toString() << std::endl;
-            // }
-            
-            size_t ip = 0;
-            while (ip < func.instructions.size()) {
-                const auto& instr = func.instructions[ip];
-                
-                if (instr.opcode == IROpCode::LOAD_INT) {
-                    int v = std::stoi(instr.operands[0].name);
-                    temps[instr.result.toString()] = v;
-                } else if (instr.opcode == IROpCode::LOAD_FLOAT) {
-                    double v = std::stod(instr.operands[0].name);
-                    temps[instr.result.toString()] = v;
-                } else if (instr.opcode == IROpCode::LOAD_STRING) {
-                    temps[instr.result.toString()] = instr.operands[0].name;
-                } else if (instr.opcode == IROpCode::LOAD_ARRAY) {
-                    auto arrayValue = std::make_shared<ArrayValue>();
-                    for (const auto& operand : instr.operands) {
-                        arrayValue->elements.push_back(temps[operand.toString()]);
-                    }
-                    temps[instr.result.toString()] = arrayValue;
-                } else if (instr.opcode == IROpCode::ADD) {
-                    auto a = temps[instr.operands[0].toString()];
-                    auto b = temps[instr.operands[1].toString()];
-                    
-                    // Helper to convert Value to int
-                    auto toInt = [](const Value& v) -> int {
-                        if (std::holds_alternative<int>(v)) return std::get<int>(v);
-                        if (std::holds_alternative<double>(v)) return static_cast<int>(std::get<double>(v));
-                        if (std::holds_alternative<std::string>(v)) return std::stoi(std::get<std::string>(v));
-                        throw std::runtime_error("Cannot convert to int");
-                    };
-                    
-                    temps[instr.result.toString()] = toInt(a) + toInt(b);
-                } else if (instr.opcode == IROpCode::SUB) {
-                    auto a = temps[instr.operands[0].toString()];
-                    auto b = temps[instr.operands[1].toString()];
-                    
-                    auto toInt = [](const Value& v) -> int {
-                        if (std::holds_alternative<int>(v)) return std::get<int>(v);
-                        if (std::holds_alternative<double>(v)) return static_cast<int>(std::get<double>(v));
-                        if (std::holds_alternative<std::string>(v)) return std::stoi(std::get<std::string>(v));
-                        throw std::runtime_error("Cannot convert to int");
-                    };
-                    
-                    temps[instr.result.toString()] = toInt(a) - toInt(b);
-                } else if (instr.opcode == IROpCode::MUL) {
-                    auto a = temps[instr.operands[0].toString()];
-                    auto b = temps[instr.operands[1].toString()];
-                    
-                    auto toInt = [](const Value& v) -> int {
-                        if (std::holds_alternative<int>(v)) return std::get<int>(v);
-                        if (std::holds_alternative<double>(v)) return static_cast<int>(std::get<double>(v));
-                        if (std::holds_alternative<std::string>(v)) return std::stoi(std::get<std::string>(v));
-                        throw std::runtime_error("Cannot convert to int");
-                    };
-                    
-                    temps[instr.result.toString()] = toInt(a) * toInt(b);
-                } else if (instr.opcode == IROpCode::DIV) {
-                    auto a = temps[instr.operands[0].toString()];
-                    auto b = temps[instr.operands[1].toString()];
-                    
-                    auto toInt = [](const Value& v) -> int {
-                        if (std::holds_alternative<int>(v)) return std::get<int>(v);
-                        if (std::holds_alternative<double>(v)) return static_cast<int>(std::get<double>(v));
-                        if (std::holds_alternative<std::string>(v)) return std::stoi(std::get<std::string>(v));
-                        throw std::runtime_error("Cannot convert to int");
-                    };
-                    
-                    int divisor = toInt(b);
-                    if (divisor == 0) throw std::runtime_error("Division by zero");
-                    temps[instr.result.toString()] = toInt(a) / divisor;
-                } else if (instr.opcode == IROpCode::MOD) {
-                    auto a = temps[instr.operands[0].toString()];
-                    auto b = temps[instr.operands[1].toString()];
-                    
-                    auto toInt = [](const Value& v) -> int {
-                        if (std::holds_alternative<int>(v)) return std::get<int>(v);
-                        if (std::holds_alternative<double>(v)) return static_cast<int>(std::get<double>(v));
-                        if (std::holds_alternative<std::string>(v)) return std::stoi(std::get<std::string>(v));
-                        throw std::runtime_error("Cannot convert to int");
-                    };
-                    
-                    int divisor = toInt(b);
-                    if (divisor == 0) throw std::runtime_error("Division by zero");
-                    temps[instr.result.toString()] = toInt(a) % divisor;
-                } else if (instr.opcode == IROpCode::CONCAT) {
-                    auto a = temps[instr.operands[0].toString()];
-                    auto b = temps[instr.operands[1].toString()];
-                    std::string result = std::visit([](auto x) -> std::string {
-                        if constexpr (std::is_same_v<std::decay_t<decltype(x)>, int>) {
-                            return std::to_string(x);
-                        } else if constexpr (std::is_same_v<std::decay_t<decltype(x)>, double>) {
-                            return std::to_string(x);
-                        } else if constexpr (std::is_same_v<std::decay_t<decltype(x)>, bool>) {
-                            return x ? "true" : "false";
-                        } else {
-                            return x;
-                        }
-                    }, a) + std::visit([](auto x) -> std::string {
-                        if constexpr (std::is_same_v<std::decay_t<decltype(x)>, int>) {
-                            return std::to_string(x);
-                        } else if constexpr (std::is_same_v<std::decay_t<decltype(x)>, double>) {
-                            return std::to_string(x);
-                        } else if constexpr (std::is_same_v<std::decay_t<decltype(x)>, bool>) {
-                            return x ? "true" : "false";
-                        } else {
-                            return x;
-                        }
-                    }, b);
-                    temps[instr.result.toString()] = result;
-                } else if (instr.opcode == IROpCode::LEN) {
-                    const Value& arrVal = temps[instr.operands[0].toString()];
-                    if (!std::holds_alternative<std::shared_ptr<ArrayValue>>(arrVal)) {
-                        throw std::runtime_error("len can only be used on arrays");
-                    }
-                    auto arr = std::get<std::shared_ptr<ArrayValue>>(arrVal);
-                    temps[instr.result.toString()] = static_cast<int>(arr ? arr->elements.size() : 0);
-                } else if (instr.opcode == IROpCode::PRINT) {
-                    auto v = temps[instr.operands[0].toString()];
-                    if (std::holds_alternative<int>(v)) std::cout << std::get<int>(v);
-                    else if (std::holds_alternative<double>(v)) std::cout << std::get<double>(v);
-                    else if (std::holds_alternative<bool>(v)) std::cout << (std::get<bool>(v) ? "true" : "false");
-                    else if (std::holds_alternative<std::string>(v)) std::cout << std::get<std::string>(v);
-                    else if (std::holds_alternative<std::shared_ptr<ArrayValue>>(v)) {
-                        auto arr = std::get<std::shared_ptr<ArrayValue>>(v);
-                        std::cout << "[array size=" << (arr ? arr->elements.size() : 0) << "]";
-                    }
-                    std::cout.flush();
-                } else if (instr.opcode == IROpCode::LT) {
-                    auto a = temps[instr.operands[0].toString()];
-                    auto b = temps[instr.operands[1].toString()];
-                    int result = std::visit([](auto x, auto y) -> int {
-                        using X = std::decay_t<decltype(x)>;
-                        using Y = std::decay_t<decltype(y)>;
-                        if constexpr (std::is_same_v<X, int> && std::is_same_v<Y, int>) {
-                            return x < y ? 1 : 0;
-                        } else if constexpr ((std::is_same_v<X, int> && std::is_same_v<Y, double>) ||
-                                             (std::is_same_v<X, double> && std::is_same_v<Y, int>) ||
-                                             (std::is_same_v<X, double> && std::is_same_v<Y, double>)) {
-                            return static_cast<double>(x) < static_cast<double>(y) ? 1 : 0;
-                        } else if constexpr (std::is_same_v<X, std::string> && std::is_same_v<Y, std::string>) {
-                            return x < y ? 1 : 0;
-                        } else {
-                            throw std::runtime_error("Invalid types for LT");
-                        }
-                    }, a, b);
-                    temps[instr.result.toString()] = result;
-                } else if (instr.opcode == IROpCode::GT) {
-                    auto a = temps[instr.operands[0].toString()];
-                    auto b = temps[instr.operands[1].toString()];
-                    int result = std::visit([](auto x, auto y) -> int {
-                        using X = std::decay_t<decltype(x)>;
-                        using Y = std::decay_t<decltype(y)>;
-                        if constexpr (std::is_same_v<X, int> && std::is_same_v<Y, int>) {
-                            return x > y ? 1 : 0;
-                        } else if constexpr ((std::is_same_v<X, int> && std::is_same_v<Y, double>) ||
-                                             (std::is_same_v<X, double> && std::is_same_v<Y, int>) ||
-                                             (std::is_same_v<X, double> && std::is_same_v<Y, double>)) {
-                            return static_cast<double>(x) > static_cast<double>(y) ? 1 : 0;
-                        } else if constexpr (std::is_same_v<X, std::string> && std::is_same_v<Y, std::string>) {
-                            return x > y ? 1 : 0;
-                        } else {
-                            throw std::runtime_error("Invalid types for GT");
-                        }
-                    }, a, b);
-                    temps[instr.result.toString()] = result;
-                } else if (instr.opcode == IROpCode::LE) {
-                    auto a = temps[instr.operands[0].toString()];
-                    auto b = temps[instr.operands[1].toString()];
-                    int result = std::visit([](auto x, auto y) -> int {
-                        using X = std::decay_t<decltype(x)>;
-                        using Y = std::decay_t<decltype(y)>;
-                        if constexpr (std::is_same_v<X, int> && std::is_same_v<Y, int>) {
-                            return x <= y ? 1 : 0;
-                        } else if constexpr ((std::is_same_v<X, int> && std::is_same_v<Y, double>) ||
-                                             (std::is_same_v<X, double> && std::is_same_v<Y, int>) ||
-                                             (std::is_same_v<X, double> && std::is_same_v<Y, double>)) {
-                            return static_cast<double>(x) <= static_cast<double>(y) ? 1 : 0;
-                        } else if constexpr (std::is_same_v<X, std::string> && std::is_same_v<Y, std::string>) {
-                            return x <= y ? 1 : 0;
-                        } else {
-                            throw std::runtime_error("Invalid types for LE");
-                        }
-                    }, a, b);
-                    temps[instr.result.toString()] = result;
-                } else if (instr.opcode == IROpCode::GE) {
-                    auto a = temps[instr.operands[0].toString()];
-                    auto b = temps[instr.operands[1].toString()];
-                    int result = std::visit([](auto x, auto y) -> int {
-                        using X = std::decay_t<decltype(x)>;
-                        using Y = std::decay_t<decltype(y)>;
-                        if constexpr (std::is_same_v<X, int> && std::is_same_v<Y, int>) {
-                            return x >= y ? 1 : 0;
-                        } else if constexpr ((std::is_same_v<X, int> && std::is_same_v<Y, double>) ||
-                                             (std::is_same_v<X, double> && std::is_same_v<Y, int>) ||
-                                             (std::is_same_v<X, double> && std::is_same_v<Y, double>)) {
-                            return static_cast<double>(x) >= static_cast<double>(y) ? 1 : 0;
-                        } else if constexpr (std::is_same_v<X, std::string> && std::is_same_v<Y, std::string>) {
-                            return x >= y ? 1 : 0;
-                        } else {
-                            throw std::runtime_error("Invalid types for GE");
-                        }
-                    }, a, b);
-                    temps[instr.result.toString()] = result;
-                } else if (instr.opcode == IROpCode::EQ) {
-                    auto a = temps[instr.operands[0].toString()];
-                    auto b = temps[instr.operands[1].toString()];
-                    int result = std::visit([](auto x, auto y) -> int {
-                        using X = std::decay_t<decltype(x)>;
-                        using Y = std::decay_t<decltype(y)>;
-                        if constexpr (std::is_same_v<X, int> && std::is_same_v<Y, int>) {
-                            return x == y ? 1 : 0;
-                        } else if constexpr ((std::is_same_v<X, int> && std::is_same_v<Y, double>) ||
-                                             (std::is_same_v<X, double> && std::is_same_v<Y, int>) ||
-                                             (std::is_same_v<X, double> && std::is_same_v<Y, double>)) {
-                            return static_cast<double>(x) == static_cast<double>(y) ? 1 : 0;
-                        } else if constexpr (std::is_same_v<X, std::string> && std::is_same_v<Y, std::string>) {
-                            return x == y ? 1 : 0;
-                        } else {
-                            throw std::runtime_error("Invalid types for EQ");
-                        }
-                    }, a, b);
-                    temps[instr.result.toString()] = result;
-                } else if (instr.opcode == IROpCode::NE) {
-                    auto a = temps[instr.operands[0].toString()];
-                    auto b = temps[instr.operands[1].toString()];
-                    int result = std::visit([](auto x, auto y) -> int {
-                        using X = std::decay_t<decltype(x)>;
-                        using Y = std::decay_t<decltype(y)>;
-                        if constexpr (std::is_same_v<X, int> && std::is_same_v<Y, int>) {
-                            return x != y ? 1 : 0;
-                        } else if constexpr ((std::is_same_v<X, int> && std::is_same_v<Y, double>) ||
-                                             (std::is_same_v<X, double> && std::is_same_v<Y, int>) ||
-                                             (std::is_same_v<X, double> && std::is_same_v<Y, double>)) {
-                            return static_cast<double>(x) != static_cast<double>(y) ? 1 : 0;
-                        } else if constexpr (std::is_same_v<X, std::string> && std::is_same_v<Y, std::string>) {
-                            return x != y ? 1 : 0;
-                        } else {
-                            throw std::runtime_error("Invalid types for NE");
-                        }
-                    }, a, b);
-                    temps[instr.result.toString()] = result;
-                } else if (instr.opcode == IROpCode::JZ) {
-                    int cond = std::get<int>(temps[instr.operands[0].toString()]);
-                    if (cond == 0) {
-                        ip = labels[instr.label];
-                        continue;
-                    }
-                } else if (instr.opcode == IROpCode::JMP) {
-                    ip = labels[instr.label];
-                    continue;
-                } else if (instr.opcode == IROpCode::STORE) {
-                    temps[instr.result.toString()] = temps[instr.operands[0].toString()];
-                } else if (instr.opcode == IROpCode::LOAD_INDEX) {
-                    const Value& arrVal = temps[instr.operands[0].toString()];
-                    int idx = valueToInt(temps[instr.operands[1].toString()]);
-                    if (!std::holds_alternative<std::shared_ptr<ArrayValue>>(arrVal)) {
-                        throw std::runtime_error("Attempted index access on non-array value");
-                    }
-                    auto arr = std::get<std::shared_ptr<ArrayValue>>(arrVal);
-                    if (!arr || idx < 0 || static_cast<size_t>(idx) >= arr->elements.size()) {
-                        throw std::runtime_error("Array index out of bounds");
-                    }
-                    temps[instr.result.toString()] = arr->elements[idx];
-                } else if (instr.opcode == IROpCode::STORE_INDEX) {
-                    Value& arrVal = temps[instr.operands[0].toString()];
-                    int idx = valueToInt(temps[instr.operands[1].toString()]);
-                    Value newValue = temps[instr.operands[2].toString()];
-                    if (!std::holds_alternative<std::shared_ptr<ArrayValue>>(arrVal)) {
-                        throw std::runtime_error("Attempted index assignment on non-array value");
-                    }
-                    auto arr = std::get<std::shared_ptr<ArrayValue>>(arrVal);
-                    if (!arr || idx < 0 || static_cast<size_t>(idx) >= arr->elements.size()) {
-                        throw std::runtime_error("Array index out of bounds");
-                    }
-                    arr->elements[idx] = newValue;
-                    temps[instr.result.toString()] = arr;
-                } else if (instr.opcode == IROpCode::INPUT) {
-                    // Print the prompt if provided
-                    if (!instr.prompt.empty()) {
-                        std::cout << instr.prompt;
-                        std::cout.flush();
-                    }
-                    std::string input;
-                    std::getline(std::cin, input);
-                    temps[instr.result.toString()] = input;
-                } else if (instr.opcode == IROpCode::KEY_PRESSED) {
-                    // Read a single character without waiting for Enter
-                    char key = readSingleKey();
-                    std::string keyStr(1, key);
-                    temps[instr.result.toString()] = keyStr;
-                } else if (instr.opcode == IROpCode::SCREEN) {
-                    // Screen initialization: create graphics window
-                    if (instr.operands.size() >= 3) {
-                        auto toInt = [](const Value& v) -> int {
-                            if (std::holds_alternative<int>(v)) return std::get<int>(v);
-                            if (std::holds_alternative<double>(v)) return static_cast<int>(std::get<double>(v));
-                            if (std::holds_alternative<std::string>(v)) {
-                                try { return std::stoi(std::get<std::string>(v)); } catch (...) { return 0; }
-                            }
-                            return 0;
-                        };
-                        
-                        auto toString = [](const Value& v) -> std::string {
-                            if (std::holds_alternative<std::string>(v)) return std::get<std::string>(v);
-                            if (std::holds_alternative<int>(v)) return std::to_string(std::get<int>(v));
-                            if (std::holds_alternative<double>(v)) return std::to_string(std::get<double>(v));
-                            return "";
-                        };
-                        
-                        int width = toInt(temps[instr.operands[0].toString()]);
-                        int height = toInt(temps[instr.operands[1].toString()]);
-                        std::string title = toString(temps[instr.operands[2].toString()]);
-                        
-                        try {
-                            if (g_graphics) delete g_graphics;
-                            g_graphics = new Graphics(width, height, title);
-                            std::cout << "\033[2J\033[1;1H";  // Clear terminal
-                            std::cout << "Graphics window created: " << width << "x" << height << " - " << title << std::endl;
-                        } catch (const std::exception& e) {
-                            std::cerr << "Failed to create graphics window: " << e.what() << std::endl;
-                        }
-                    }
-                    temps[instr.result.toString()] = 1;  // Return success
-                } else if (instr.opcode == IROpCode::DRAW_PIXEL) {
-                    // drawPixel(x, y, r, g, b)
-                    if (g_graphics && instr.operands.size() >= 5) {
-                        auto toInt = [](const Value& v) -> int {
-                            if (std::holds_alternative<int>(v)) return std::get<int>(v);
-                            if (std::holds_alternative<double>(v)) return static_cast<int>(std::get<double>(v));
-                            if (std::holds_alternative<std::string>(v)) {
-                                try { return std::stoi(std::get<std::string>(v)); } catch (...) { return 0; }
-                            }
-                            return 0;
-                        };
-                        int x = toInt(temps[instr.operands[0].toString()]);
-                        int y = toInt(temps[instr.operands[1].toString()]);
-                        int r = toInt(temps[instr.operands[2].toString()]);
-                        int g = toInt(temps[instr.operands[3].toString()]);
-                        int b = toInt(temps[instr.operands[4].toString()]);
-                        g_graphics->drawPixel(x, y, r, g, b);
-                        temps[instr.result.toString()] = 1;
-                    }
-                } else if (instr.opcode == IROpCode::DRAW_RECT) {
-                    // drawRect(x, y, w, h, r, g, b, filled)
-                    if (g_graphics && instr.operands.size() >= 8) {
-                        auto toInt = [](const Value& v) -> int {
-                            if (std::holds_alternative<int>(v)) return std::get<int>(v);
-                            if (std::holds_alternative<double>(v)) return static_cast<int>(std::get<double>(v));
-                            if (std::holds_alternative<std::string>(v)) {
-                                try { return std::stoi(std::get<std::string>(v)); } catch (...) { return 0; }
-                            }
-                            return 0;
-                        };
-                        int x = toInt(temps[instr.operands[0].toString()]);
-                        int y = toInt(temps[instr.operands[1].toString()]);
-                        int w = toInt(temps[instr.operands[2].toString()]);
-                        int h = toInt(temps[instr.operands[3].toString()]);
-                        int r = toInt(temps[instr.operands[4].toString()]);
-                        int g = toInt(temps[instr.operands[5].toString()]);
-                        int b = toInt(temps[instr.operands[6].toString()]);
-                        int filled = toInt(temps[instr.operands[7].toString()]);
-                        g_graphics->drawRect(x, y, w, h, r, g, b, filled);
-                        temps[instr.result.toString()] = 1;
-                    }
-                } else if (instr.opcode == IROpCode::DRAW_LINE) {
-                    // drawLine(x1, y1, x2, y2, r, g, b)
-                    if (g_graphics && instr.operands.size() >= 7) {
-                        auto toInt = [](const Value& v) -> int {
-                            if (std::holds_alternative<int>(v)) return std::get<int>(v);
-                            if (std::holds_alternative<double>(v)) return static_cast<int>(std::get<double>(v));
-                            if (std::holds_alternative<std::string>(v)) {
-                                try { return std::stoi(std::get<std::string>(v)); } catch (...) { return 0; }
-                            }
-                            return 0;
-                        };
-                        int x1 = toInt(temps[instr.operands[0].toString()]);
-                        int y1 = toInt(temps[instr.operands[1].toString()]);
-                        int x2 = toInt(temps[instr.operands[2].toString()]);
-                        int y2 = toInt(temps[instr.operands[3].toString()]);
-                        int r = toInt(temps[instr.operands[4].toString()]);
-                        int g = toInt(temps[instr.operands[5].toString()]);
-                        int b = toInt(temps[instr.operands[6].toString()]);
-                        g_graphics->drawLine(x1, y1, x2, y2, r, g, b);
-                        temps[instr.result.toString()] = 1;
-                    }
-                } else if (instr.opcode == IROpCode::DRAW_CIRCLE) {
-                    // drawCircle(x, y, radius, r, g, b, filled)
-                    if (g_graphics && instr.operands.size() >= 7) {
-                        auto toInt = [](const Value& v) -> int {
-                            if (std::holds_alternative<int>(v)) return std::get<int>(v);
-                            if (std::holds_alternative<double>(v)) return static_cast<int>(std::get<double>(v));
-                            if (std::holds_alternative<std::string>(v)) {
-                                try { return std::stoi(std::get<std::string>(v)); } catch (...) { return 0; }
-                            }
-                            return 0;
-                        };
-                        int x = toInt(temps[instr.operands[0].toString()]);
-                        int y = toInt(temps[instr.operands[1].toString()]);
-                        int radius = toInt(temps[instr.operands[2].toString()]);
-                        int r = toInt(temps[instr.operands[3].toString()]);
-                        int g = toInt(temps[instr.operands[4].toString()]);
-                        int b = toInt(temps[instr.operands[5].toString()]);
-                        int filled = toInt(temps[instr.operands[6].toString()]);
-                        g_graphics->drawCircle(x, y, radius, r, g, b, filled);
-                        temps[instr.result.toString()] = 1;
+            return 0;
+        };
+        
+        if (options.path.empty() || options.repl) {
+            // Source arrives on the client's stdin, which only the job can read
+            return [options, execute, fail]() {
+                try {
+                    Engine engine(engineConfig(options));
+                    if (wantsRepl(options)) {
+                        runRepl(engine);
+                        return 0;
                     }
-                } else if (instr.opcode == IROpCode::CLEAR_SCREEN) {
-                    // clearScreen(r, g, b) - Clear to color
-                    if (g_graphics && instr.operands.size() >= 3) {
-                        auto toInt = [](const Value& v) -> int {
-                            if (std::holds_alternative<int>(v)) return std::get<int>(v);
-                            if (std::holds_alternative<double>(v)) return static_cast<int>(std::get<double>(v));
-                            if (std::holds_alternative<std::string>(v)) {
-                                try { return std::stoi(std::get<std::string>(v)); } catch (...) { return 0; }
-                            }
-                            return 0;
-                        };
-                        int r = toInt(temps[instr.operands[0].toString()]);
-                        int g = toInt(temps[instr.operands[1].toString()]);
-                        int b = toInt(temps[instr.operands[2].toString()]);
-                        g_graphics->clear(r, g, b);
-                        temps[instr.result.toString()] = 1;
-                    }
-                } else if (instr.opcode == IROpCode::PRESENT) {
-                    // present() - Update display
-                    if (g_graphics) {
-                        g_graphics->handleEvents();
-                        g_graphics->present();
-                        // Check if window was closed via X button or Alt+F4
-                        if (g_graphics->shouldClose()) {
-                            delete g_graphics;
-                            g_graphics = nullptr;
-                            ip = func.instructions.size();  // Exit loop
-                            break;
-                        }
-                    }
-                    temps[instr.result.toString()] = 1;
-                } else if (instr.opcode == IROpCode::CALL && instr.label == "quit") {
-                    // quit() - Clean exit
-                    if (g_graphics) {
-                        // Process pending events one final time
-                        g_graphics->handleEvents();
-                        delete g_graphics;
-                        g_graphics = nullptr;
-                    }
-                    exit(0);
-                } else if (instr.opcode == IROpCode::CALL && instr.label == "isKeyDown") {
-                    // isKeyDown(keyCode) - returns 1 if key is down, 0 otherwise
-                    int result = 0;
-                    if (g_graphics && instr.operands.size() > 0) {
-                        Value keyVal = temps[instr.operands[0].toString()];
-                        std::string keyStr;
-                        if (std::holds_alternative<std::string>(keyVal)) {
-                            keyStr = std::get<std::string>(keyVal);
-                        } else if (std::holds_alternative<int>(keyVal)) {
-                            keyStr = std::to_string(std::get<int>(keyVal));
-                        } else if (std::holds_alternative<double>(keyVal)) {
-                            keyStr = std::to_string(static_cast<int>(std::get<double>(keyVal)));
-                        }
-                        
-                        // Check specific keys
-                        if (keyStr == "a") result = g_graphics->isKeyPressed(SDLK_a) ? 1 : 0;
-                        else if (keyStr == "d") result = g_graphics->isKeyPressed(SDLK_d) ? 1 : 0;
-                        else if (keyStr == "w") result = g_graphics->isKeyPressed(SDLK_w) ? 1 : 0;
-                        else if (keyStr == "s") result = g_graphics->isKeyPressed(SDLK_s) ? 1 : 0;
-                        else if (keyStr == "space") result = g_graphics->isKeyPressed(SDLK_SPACE) ? 1 : 0;
-                        else if (keyStr == "left") result = g_graphics->isKeyPressed(SDLK_LEFT) ? 1 : 0;
-                        else if (keyStr == "right") result = g_graphics->isKeyPressed(SDLK_RIGHT) ? 1 : 0;
-                        else if (keyStr == "up") result = g_graphics->isKeyPressed(SDLK_UP) ? 1 : 0;
-                        else if (keyStr == "down") result = g_graphics->isKeyPressed(SDLK_DOWN) ? 1 : 0;
-                        else if (keyStr == "escape") result = g_graphics->isKeyPressed(SDLK_ESCAPE) ? 1 : 0;
-                        
-                        if (result == 1) {
-                            std::cout << "Key detected: " << keyStr << std::endl;
-                        }
-                    }
-                    temps[instr.result.toString()] = result;
-                } else if (instr.opcode == IROpCode::CALL && instr.label == "updateInput") {
-                    // updateInput() - manually update input state
-                    if (g_graphics) {
-                        g_graphics->handleEvents();
-                    }
-                    temps[instr.result.toString()] = 1;
-                } else if (instr.opcode == IROpCode::LABEL) {
-                    // No-op
+                    return execute(engine.compile(readScript(options)));
+                } catch (const std::exception& e) {
+                    return fail(e.what())();
                 }
-                
-                ip++;
+            };
+        }
+        try {
+            EngineConfig config = engineConfig(options);
+            std::string engineKey = std::to_string(config.useCache) + '\0' + config.cacheDir + '\0' + config.profileUse;
+            auto& engine = engines[engineKey];
+            if (!engine) {
+                if (config.useCache) config.memoryCacheEntries = kWarmModules;
+                engine.reset(new Engine(config));
             }
+            ModulePtr module = engine->compileFile(options.path);
+            return [module, execute]() { return execute(module); };
+        } catch (const std::exception& e) {
+            return fail(e.what());
         }
-    }
+    });
 }
 
-
 int main(int argc, char* argv[]) {
-    std::string source;
-    if (argc > 1) {
-        source = readFile(argv[1]);
-    } else {
-        std::string line;
-        while (std::getline(std::cin, line)) {
-            if (line == "END") break;
-            source += line + "\n";
-        }
-    }
+    Options options = parseOptions(std::vector<std::string>(argv + 1, argv + argc));
     try {
-        Lexer lexer(source);
-        auto tokens = lexer.tokenize();
-        Parser parser(tokens);
-        auto program = parser.parse();
-        IRGenerator irgen(program);
-        auto ir = irgen.generate();
-        interpretIR(ir);
+        if (options.server) {
+            std::cerr << "Serving on " << options.socketPath << std::endl;
+            runServer(options);
+            return 0;
+        }
+        if (!options.batchDir.empty()) {
+            return runBatchCommand(options);
+        }
+        if (options.watch) {
+            runWatch(options);
+            return 0;
+        }
+        Engine engine(engineConfig(options));
+        if (wantsRepl(options)) {
+            runRepl(engine);
+            return 0;
+        }
+        runScript(options, engine.compile(readScript(options), options.path));
     } catch (const std::exception& e) {
         std::cerr << "Error: " << e.what() << std::endl;
         return 1;
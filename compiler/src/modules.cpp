@@ -0,0 +1,160 @@
+#include "modules.h"
+#include "incremental.h"
+#include "lexer.h"
+#include "optimizer.h"
+#include "parser.h"
+#include <algorithm>
+#include <atomic>
+#include <exception>
+#include <filesystem>
+#include <fstream>
+#include <sstream>
+#include <stdexcept>
+#include <thread>
+#include <unordered_map>
+
+namespace fs = std::filesystem;
+
+namespace {
+
+std::string readModule(const std::string& path) {
+    std::ifstream file(path);
+    if (!file.is_open()) {
+        throw std::runtime_error("Could not open module " + path);
+    }
+    std::stringstream buffer;
+    buffer << file.rdbuf();
+    return buffer.str();
+}
+
+// Paths named by top-level `import "path";` declarations
+std::vector<std::string> importsOf(const std::string& source) {
+    Lexer lexer(source);
+    auto tokens = lexer.tokenize();
+    std::vector<std::string> imports;
+    int depth = 0;
+    for (size_t i = 0; i + 1 < tokens.size(); ++i) {
+        if (tokens[i].type == TokenType::LBRACE) depth++;
+        if (tokens[i].type == TokenType::RBRACE) depth--;
+        if (depth == 0 && tokens[i].type == TokenType::IMPORT && tokens[i + 1].type == TokenType::STRING) {
+            imports.push_back(tokens[i + 1].value);
+        }
+    }
+    return imports;
+}
+
+IRProgram compileModule(const SourceModule& module, CompileCache* cache, const std::string& flags,
+                        const Profile* profile, const std::vector<Builtin>* natives) {
+    if (cache) {
+        IncrementalCompiler compiler(*cache, flags, profile, natives);
+        return compiler.compile(module.source);
+    }
+    Lexer lexer(module.source);
+    auto tokens = lexer.tokenize();
+    Parser parser(tokens);
+    auto ast = parser.parse();
+    IRGenerator irgen(ast, natives);
+    auto ir = irgen.generate();
+    IROptimizer optimizer(ir, profile);
+    optimizer.optimize();
+    return ir;
+}
+
+} // namespace
+
+std::vector<SourceModule> loadModules(const std::string& entryPath, const std::string& entrySource) {
+    std::vector<SourceModule> modules;
+    std::unordered_map<std::string, size_t> byPath;
+
+    SourceModule entry;
+    entry.path = entryPath.empty() ? "<stdin>" : fs::weakly_canonical(entryPath).string();
+    entry.source = entrySource;
+    byPath[entry.path] = 0;
+    modules.push_back(entry);
+
+    // Breadth-first over imports; modules are appended as they are discovered
+    for (size_t m = 0; m < modules.size(); ++m) {
+        fs::path base = entryPath.empty() && m == 0 ? fs::current_path() : fs::path(modules[m].path).parent_path();
+        for (const auto& name : importsOf(modules[m].source)) {
+            std::string path = fs::weakly_canonical(base / name).string();
+            auto it = byPath.find(path);
+            size_t index;
+            if (it != byPath.end()) {
+                index = it->second;
+            } else {
+                SourceModule imported;
+                imported.path = path;
+                imported.source = readModule(path);
+                index = modules.size();
+                byPath[path] = index;
+                modules.push_back(std::move(imported));
+            }
+            modules[m].imports.push_back(index);
+        }
+    }
+    return modules;
+}
+
+std::string programText(const std::vector<SourceModule>& modules) {
+    // A lone module is identified by its source alone, as before modules existed
+    if (modules.size() == 1) return modules[0].source;
+    std::string text;
+    for (const auto& module : modules) {
+        text += module.path;
+        text += '\0';
+        text += module.source;
+        text += '\0';
+    }
+    return text;
+}
+
+IRProgram compileModules(const std::vector<SourceModule>& modules, CompileCache* cache, const std::string& flags,
+                         const Profile* profile, const std::vector<Builtin>* natives, unsigned threads) {
+    std::vector<IRProgram> compiled(modules.size());
+    std::vector<std::exception_ptr> errors(modules.size());
+
+    if (threads == 0) threads = std::max(1u, std::thread::hardware_concurrency());
+    threads = static_cast<unsigned>(std::min<size_t>(threads, modules.size()));
+
+    // Thread pool: workers take the next module until none are left
+    std::atomic<size_t> next(0);
+    auto work = [&]() {
+        for (size_t m = next++; m < modules.size(); m = next++) {
+            try {
+                compiled[m] = compileModule(modules[m], cache, flags, profile, natives);
+            } catch (...) {
+                errors[m] = std::current_exception();
+            }
+        }
+    };
+    std::vector<std::thread> pool;
+    for (unsigned t = 1; t < threads; ++t) pool.emplace_back(work);
+    work();
+    for (auto& thread : pool) thread.join();
+
+    for (size_t m = 0; m < modules.size(); ++m) {
+        if (!errors[m]) continue;
+        try {
+            std::rethrow_exception(errors[m]);
+        } catch (const std::exception& e) {
+            if (modules.size() == 1) throw;
+            throw std::runtime_error(modules[m].path + ": " + e.what());
+        }
+    }
+
+    // Link: one program, each function defined by exactly one module
+    IRProgram program;
+    std::unordered_map<std::string, size_t> definedIn;
+    for (size_t m = 0; m < modules.size(); ++m) {
+        for (auto& func : compiled[m].functions) {
+            auto defined = definedIn.emplace(func.name, m);
+            if (!defined.second && defined.first->second != m) {
+                throw std::runtime_error("Function '" + func.name + "' is defined in both " +
+                                         modules[defined.first->second].path + " and " + modules[m].path);
+            }
+            program.functions.push_back(std::move(func));
+        }
+        for (auto& global : compiled[m].globalVariables) program.globalVariables.insert(global);
+    }
+    return program;
+}
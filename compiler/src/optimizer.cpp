@@ -0,0 +1,1659 @@
+#include "optimizer.h"
+#include <algorithm>
+#include <functional>
+#include <limits>
+#include <map>
+#include <set>
+#include <unordered_map>
+
+namespace {
+
+bool isJump(IROpCode op) {
+    return op == IROpCode::JMP || op == IROpCode::JZ || op == IROpCode::JNZ;
+}
+
+// Multiway branches always jump: to a case label or the default
+bool isMultiway(IROpCode op) {
+    return op == IROpCode::JUMP_TABLE || op == IROpCode::SWITCH;
+}
+
+bool isBranch(IROpCode op) {
+    return isJump(op) || isMultiway(op);
+}
+
+// Every label the instruction may jump to
+std::vector<std::string> branchTargets(const IRInstruction& instr) {
+    std::vector<std::string> targets;
+    if (!isBranch(instr.opcode)) return targets;
+    targets.push_back(instr.label);
+    for (const auto& c : instr.cases) targets.push_back(c.second);
+    return targets;
+}
+
+// Does the instruction assign its result slot?
+bool writesResult(const IRInstruction& instr) {
+    switch (instr.opcode) {
+        case IROpCode::JMP:
+        case IROpCode::JZ:
+        case IROpCode::JNZ:
+        case IROpCode::RET:
+        case IROpCode::TAIL_CALL:
+        case IROpCode::JUMP_TABLE:
+        case IROpCode::SWITCH:
+        case IROpCode::PRINT:
+        case IROpCode::LABEL:
+        case IROpCode::NOP:
+        case IROpCode::STORE_INDEX:  // result names the array it updates in place
+        case IROpCode::STORE_INDEX_UNCHECKED:
+            return false;
+        default:
+            return true;
+    }
+}
+
+// Side-effect free instructions whose result depends only on their operands
+bool isPure(IROpCode op) {
+    switch (op) {
+        case IROpCode::ADD:
+        case IROpCode::SUB:
+        case IROpCode::MUL:
+        case IROpCode::DIV:
+        case IROpCode::MOD:
+        case IROpCode::NEG:
+        case IROpCode::CONCAT:
+        case IROpCode::AND:
+        case IROpCode::OR:
+        case IROpCode::NOT:
+        case IROpCode::EQ:
+        case IROpCode::NE:
+        case IROpCode::LT:
+        case IROpCode::GT:
+        case IROpCode::LE:
+        case IROpCode::GE:
+        case IROpCode::STORE:
+        case IROpCode::LOAD_INT:
+        case IROpCode::LOAD_FLOAT:
+        case IROpCode::LOAD_STRING:
+        case IROpCode::LEN:
+            return true;
+        default:
+            return false;
+    }
+}
+
+bool sameValue(const IRValue& a, const IRValue& b) {
+    if (a.type != b.type) return false;
+    if (a.type == IRValue::Type::TEMP) return a.id == b.id;
+    return a.name == b.name;
+}
+
+bool writes(const IRInstruction& instr, const IRValue& value) {
+    return writesResult(instr) && sameValue(instr.result, value);
+}
+
+bool reads(const IRInstruction& instr, const IRValue& value) {
+    for (const auto& operand : instr.operands) {
+        if (sameValue(operand, value)) return true;
+    }
+    return false;
+}
+
+// Is value assigned anywhere in [from, to)?
+bool writtenIn(const std::vector<IRInstruction>& code, const IRValue& value, size_t from, size_t to) {
+    for (size_t i = from; i < to && i < code.size(); ++i) {
+        if (writes(code[i], value)) return true;
+    }
+    return false;
+}
+
+std::unordered_map<std::string, size_t> labelIndex(const std::vector<IRInstruction>& code) {
+    std::unordered_map<std::string, size_t> labels;
+    for (size_t i = 0; i < code.size(); ++i) {
+        if (code[i].opcode == IROpCode::LABEL) labels[code[i].label] = i;
+    }
+    return labels;
+}
+
+// Temps whose every definition loads the same integer literal
+std::unordered_map<int, long> constantTemps(const std::vector<IRInstruction>& code) {
+    std::unordered_map<int, long> constants;
+    std::set<int> varying;
+    for (const auto& instr : code) {
+        if (!writesResult(instr) || instr.result.type != IRValue::Type::TEMP) continue;
+        int id = instr.result.id;
+        if (varying.count(id)) continue;
+        if (instr.opcode != IROpCode::LOAD_INT) {
+            varying.insert(id);
+            constants.erase(id);
+            continue;
+        }
+        long value = std::stol(instr.operands[0].name);
+        auto it = constants.find(id);
+        if (it != constants.end() && it->second != value) {
+            varying.insert(id);
+            constants.erase(it);
+        } else {
+            constants[id] = value;
+        }
+    }
+    return constants;
+}
+
+bool lookupConstant(const std::unordered_map<int, long>& constants, const IRValue& value, long& out) {
+    if (value.type != IRValue::Type::TEMP) return false;
+    auto it = constants.find(value.id);
+    if (it == constants.end()) return false;
+    out = it->second;
+    return true;
+}
+
+int nextTempId(const IRFunction& func) {
+    int maxId = -1;
+    for (const auto& instr : func.instructions) {
+        if (instr.result.type == IRValue::Type::TEMP && instr.result.id > maxId) maxId = instr.result.id;
+        for (const auto& operand : instr.operands) {
+            if (operand.type == IRValue::Type::TEMP && operand.id > maxId) maxId = operand.id;
+        }
+    }
+    return maxId + 1;
+}
+
+IRValue makeTemp(int id) {
+    return IRValue(IRValue::Type::TEMP, "t" + std::to_string(id), id);
+}
+
+IRInstruction makeLoadInt(long value, const IRValue& result) {
+    IRInstruction instr(IROpCode::LOAD_INT);
+    instr.operands.push_back(IRValue(IRValue::Type::CONSTANT, std::to_string(value)));
+    instr.result = result;
+    return instr;
+}
+
+IROpCode swapCompare(IROpCode op) {
+    switch (op) {
+        case IROpCode::LT: return IROpCode::GT;
+        case IROpCode::GT: return IROpCode::LT;
+        case IROpCode::LE: return IROpCode::GE;
+        case IROpCode::GE: return IROpCode::LE;
+        default: return op;
+    }
+}
+
+long ceilDiv(long a, long b) {
+    return (a + b - 1) / b;
+}
+
+long computeTripCount(IROpCode compare, long start, long bound, long step) {
+    switch (compare) {
+        case IROpCode::LT:
+            if (step <= 0) return -1;
+            return start >= bound ? 0 : ceilDiv(bound - start, step);
+        case IROpCode::LE:
+            if (step <= 0) return -1;
+            return start > bound ? 0 : (bound - start) / step + 1;
+        case IROpCode::GT:
+            if (step >= 0) return -1;
+            return start <= bound ? 0 : ceilDiv(start - bound, -step);
+        case IROpCode::GE:
+            if (step >= 0) return -1;
+            return start < bound ? 0 : (start - bound) / -step + 1;
+        case IROpCode::NE:
+            if (step == 0 || (bound - start) % step != 0 || (bound - start) / step < 0) return -1;
+            return (bound - start) / step;
+        default:
+            return -1;
+    }
+}
+
+// Is value unchanged by every iteration of the loop body (header, latch)?
+bool isLoopInvariant(const std::vector<IRInstruction>& code, const LoopInfo& loop,
+                     const std::unordered_map<int, long>& constants, const IRValue& value, int depth = 0) {
+    long ignored;
+    if (lookupConstant(constants, value, ignored)) return true;
+    if (value.type == IRValue::Type::CONSTANT) return true;
+
+    // Allow a single pure recomputation from invariant operands (e.g. LEN arr in the exit test)
+    const IRInstruction* def = nullptr;
+    for (size_t i = loop.header + 1; i < loop.latch; ++i) {
+        if (!writes(code[i], value)) continue;
+        if (def) return false;
+        def = &code[i];
+    }
+    if (!def) return true;
+    if (depth > 2 || !isPure(def->opcode)) return false;
+    for (const auto& operand : def->operands) {
+        if (sameValue(operand, value)) return false;
+        if (!isLoopInvariant(code, loop, constants, operand, depth + 1)) return false;
+    }
+    return true;
+}
+
+// preheaderWrite: Index of the last write to value in the straight-line code before index from
+// (the loop header by default), looking past the guard of a rotated loop; code.size() if the value
+// isn't assigned there, such as a parameter
+size_t preheaderWrite(const std::vector<IRInstruction>& code, const LoopInfo& loop, const IRValue& value,
+                      size_t from = std::string::npos) {
+    bool skippedGuard = false;
+    for (size_t i = std::min(from, loop.header); i-- > 0;) {
+        const auto& instr = code[i];
+        if (instr.opcode == IROpCode::JZ && instr.label == loop.exitLabel && loop.rotated && !skippedGuard) {
+            skippedGuard = true;
+            continue;
+        }
+        if (instr.opcode == IROpCode::LABEL || isBranch(instr.opcode) || instr.opcode == IROpCode::RET) break;
+        if (writes(instr, value)) return i;
+    }
+    return code.size();
+}
+
+// Try to treat candidate as the loop's induction variable
+bool analyzeInduction(const std::vector<IRInstruction>& code, LoopInfo& loop,
+                      const std::unordered_map<int, long>& constants, const IRValue& candidate) {
+    if (candidate.type != IRValue::Type::LOCAL) return false;
+
+    // Exactly one assignment inside the loop: candidate = t, t = candidate +/- constant
+    size_t increment = 0;
+    int defs = 0;
+    for (size_t i = loop.header + 1; i < loop.latch; ++i) {
+        if (writes(code[i], candidate)) {
+            increment = i;
+            defs++;
+        }
+    }
+    if (defs != 1 || code[increment].opcode != IROpCode::STORE) return false;
+
+    const IRValue& stepped = code[increment].operands[0];
+    long step = 0;
+    bool found = false;
+    for (size_t i = increment; i-- > loop.header + 1;) {
+        const auto& instr = code[i];
+        if (instr.opcode == IROpCode::LABEL || isBranch(instr.opcode)) break;
+        if (!writes(instr, stepped)) continue;
+        long k;
+        if (instr.opcode == IROpCode::ADD && sameValue(instr.operands[0], candidate) &&
+            lookupConstant(constants, instr.operands[1], k)) {
+            step = k;
+            found = true;
+        } else if (instr.opcode == IROpCode::ADD && sameValue(instr.operands[1], candidate) &&
+                   lookupConstant(constants, instr.operands[0], k)) {
+            step = k;
+            found = true;
+        } else if (instr.opcode == IROpCode::SUB && sameValue(instr.operands[0], candidate) &&
+                   lookupConstant(constants, instr.operands[1], k)) {
+            step = -k;
+            found = true;
+        }
+        break;
+    }
+    if (!found || step == 0) return false;
+
+    // The step must run on every iteration: no join point between it and the latch
+    for (size_t i = increment + 1; i < loop.latch; ++i) {
+        if (code[i].opcode == IROpCode::LABEL) return false;
+    }
+
+    loop.hasInduction = true;
+    loop.inductionVar = candidate;
+    loop.incrementIndex = increment;
+    loop.step = step;
+
+    // Initial value: the assignment in the loop's preheader
+    size_t init = preheaderWrite(code, loop, candidate);
+    long k;
+    if (init < code.size() && code[init].opcode == IROpCode::STORE &&
+        lookupConstant(constants, code[init].operands[0], k)) {
+        loop.hasStart = true;
+        loop.start = k;
+    }
+    return true;
+}
+
+// Smallest length the array local can have whenever the loop runs, or -1 if unknown.
+// Proven when the preheader stores an array literal to it and the loop doesn't assign it. A value
+// that arrives from elsewhere, such as a parameter or a REPL session variable, is never trusted.
+long minimumArrayLength(const std::vector<IRInstruction>& code, const LoopInfo& loop, const IRValue& array) {
+    size_t store = preheaderWrite(code, loop, array);
+    if (store == code.size() || code[store].opcode != IROpCode::STORE) return -1;
+    if (writtenIn(code, array, loop.header, loop.latch + 1)) return -1;
+    size_t literal = preheaderWrite(code, loop, code[store].operands[0], store);
+    if (literal == code.size() || code[literal].opcode != IROpCode::LOAD_ARRAY) return -1;
+    return static_cast<long>(code[literal].operands.size());
+}
+
+// Does the exit test keep the induction variable below the length of array?
+bool boundedByLength(const std::vector<IRInstruction>& code, const LoopInfo& loop, const IRValue& array) {
+    if (loop.compare != IROpCode::LT) return false;
+    if (loop.hasConstantBound) {
+        long length = minimumArrayLength(code, loop, array);
+        return length >= 0 && loop.boundValue <= length;
+    }
+
+    // bound = LEN array, computed in the preheader or by the exit test itself, with array untouched
+    // from there to the end of the loop
+    for (const auto& instr : code) {
+        if (!writes(instr, loop.bound)) continue;
+        if (instr.opcode != IROpCode::LEN || !sameValue(instr.operands[0], array)) return false;
+    }
+    size_t def = preheaderWrite(code, loop, loop.bound);
+    if (def == code.size() && !loop.rotated) {
+        for (size_t i = loop.header + 1; i < loop.exitTest && def == code.size(); ++i) {
+            if (writes(code[i], loop.bound)) def = i;
+        }
+    }
+    if (def == code.size()) return false;
+    return !writtenIn(code, array, def, loop.latch + 1);
+}
+
+// Inlining limits, in instructions (labels excluded)
+const size_t kInlineSizeLimit = 24;        // Callees this small are inlined at every call site
+const size_t kInlineSingleCallLimit = 160; // Larger callees are inlined only when called once
+const size_t kMaxCallerSize = 4000;        // Stop growing a caller past this size
+const size_t kHotInlineSizeLimit = 96;     // Profiled call sites run this often get larger callees
+const uint64_t kHotCallCount = 1000;
+
+// A branch direction taken less than 1 in kColdRatio times is moved out of line
+const uint64_t kColdRatio = 8;
+
+size_t codeSize(const IRFunction& func) {
+    size_t size = 0;
+    for (const auto& instr : func.instructions) {
+        if (instr.opcode != IROpCode::LABEL) size++;
+    }
+    return size;
+}
+
+// Named locals of func other than its parameters; every call starts with them unset, reading as 0
+std::vector<IRValue> freshLocals(const IRFunction& func) {
+    std::set<std::string> names;
+    for (const auto& instr : func.instructions) {
+        if (instr.result.type == IRValue::Type::LOCAL) names.insert(instr.result.name);
+        for (const auto& operand : instr.operands) {
+            if (operand.type == IRValue::Type::LOCAL) names.insert(operand.name);
+        }
+    }
+    for (const auto& param : func.parameters) names.erase(param.second);
+    std::vector<IRValue> locals;
+    for (const auto& name : names) locals.push_back(IRValue(IRValue::Type::LOCAL, name));
+    return locals;
+}
+
+// Give locals the value a new call starts with, using zero as scratch
+void resetLocals(std::vector<IRInstruction>& code, const std::vector<IRValue>& locals, const IRValue& zero) {
+    if (locals.empty()) return;
+    code.push_back(makeLoadInt(0, zero));
+    for (const auto& local : locals) {
+        IRInstruction reset(IROpCode::STORE);
+        reset.operands.push_back(zero);
+        reset.result = local;
+        code.push_back(reset);
+    }
+}
+
+// Copy of callee's body for one call site, with temps, locals and labels renamed apart
+// The callee's other locals are reset after its parameters are bound, so no copy sees values left by
+// an earlier run of it; this uses the temp numbered tempBase + nextTempId(callee).
+std::vector<IRInstruction> expandCall(const IRInstruction& call, const IRFunction& callee,
+                                      int tempBase, const std::string& suffix) {
+    std::string localPrefix = callee.name + suffix + ".";
+    auto rename = [&](IRValue value) {
+        if (value.type == IRValue::Type::TEMP && value.id >= 0) {
+            value = makeTemp(value.id + tempBase);
+        } else if (value.type == IRValue::Type::LOCAL) {
+            value.name = localPrefix + value.name;
+        }
+        return value;
+    };
+
+    std::vector<IRInstruction> body;
+    for (size_t i = 0; i < callee.parameters.size(); ++i) {
+        IRInstruction bind(IROpCode::STORE);
+        bind.operands.push_back(call.operands[i]);
+        bind.result = rename(IRValue(IRValue::Type::LOCAL, callee.parameters[i].second));
+        body.push_back(bind);
+    }
+    std::vector<IRValue> locals = freshLocals(callee);
+    for (auto& local : locals) local = rename(local);
+    resetLocals(body, locals, makeTemp(tempBase + nextTempId(callee)));
+
+    std::string returnLabel = "L_ret" + suffix;
+    bool returnUsed = false;
+    const auto& code = callee.instructions;
+    for (size_t i = 0; i < code.size(); ++i) {
+        const auto& instr = code[i];
+        if (instr.opcode == IROpCode::RET) {
+            if (!instr.operands.empty()) {
+                IRInstruction store(IROpCode::STORE);
+                store.operands.push_back(rename(instr.operands[0]));
+                store.result = call.result;
+                body.push_back(store);
+            }
+            if (i + 1 < code.size()) {
+                IRInstruction jump(IROpCode::JMP);
+                jump.label = returnLabel;
+                body.push_back(jump);
+                returnUsed = true;
+            }
+            continue;
+        }
+
+        IRInstruction copy = instr;
+        for (auto& operand : copy.operands) operand = rename(operand);
+        copy.result = rename(copy.result);
+        if (!copy.label.empty() && (copy.opcode == IROpCode::LABEL || isBranch(copy.opcode))) {
+            copy.label += suffix;
+        }
+        for (auto& c : copy.cases) c.second += suffix;
+        body.push_back(copy);
+    }
+
+    if (returnUsed) {
+        IRInstruction label(IROpCode::LABEL);
+        label.label = returnLabel;
+        body.push_back(label);
+    }
+    return body;
+}
+
+// Integer value of an operation on known constants; false when it cannot be folded
+bool evaluateConstant(IROpCode op, long a, long b, long& out) {
+    switch (op) {
+        case IROpCode::ADD: out = a + b; break;
+        case IROpCode::SUB: out = a - b; break;
+        case IROpCode::MUL: out = a * b; break;
+        case IROpCode::DIV:
+            if (b == 0) return false;  // Leave the runtime error in place
+            out = a / b;
+            break;
+        case IROpCode::MOD:
+            if (b == 0) return false;
+            out = a % b;
+            break;
+        case IROpCode::EQ: out = a == b; break;
+        case IROpCode::NE: out = a != b; break;
+        case IROpCode::LT: out = a < b; break;
+        case IROpCode::GT: out = a > b; break;
+        case IROpCode::LE: out = a <= b; break;
+        case IROpCode::GE: out = a >= b; break;
+        case IROpCode::AND: out = (a != 0) && (b != 0); break;
+        case IROpCode::OR: out = (a != 0) || (b != 0); break;
+        case IROpCode::NEG: out = -a; break;
+        case IROpCode::NOT: out = a == 0; break;
+        default: return false;
+    }
+    // The VM computes in int; keep its overflow behaviour by not folding past it
+    return out >= std::numeric_limits<int>::min() && out <= std::numeric_limits<int>::max();
+}
+
+// Does control leave the instruction other than by falling through to the next one?
+bool endsBlock(IROpCode op) {
+    return isBranch(op) || op == IROpCode::RET || op == IROpCode::TAIL_CALL;
+}
+
+// Does the instruction never fall through to the next one?
+bool isTerminator(IROpCode op) {
+    return op == IROpCode::JMP || op == IROpCode::RET || op == IROpCode::TAIL_CALL || isMultiway(op);
+}
+
+// recordedCalls: Times the call at code[index] ran in the profiled run
+// A call inlined in that run never executed as a CALL and has no count of its own. The profiled
+// instructions of its block, or of the callee's entry block, ran once per call then, so they stand in.
+uint64_t recordedCalls(const Profile& profile, const std::vector<IRInstruction>& code, size_t index,
+                       const IRFunction& callee) {
+    auto ran = [&](const IRInstruction& instr) -> uint64_t {
+        const ProfileCounts* counts = instr.site ? profile.find(instr.site) : nullptr;
+        return counts ? counts->executed : 0;
+    };
+    if (uint64_t calls = ran(code[index])) return calls;
+    for (size_t i = index; i-- > 0 && code[i].opcode != IROpCode::LABEL && !endsBlock(code[i].opcode);) {
+        if (uint64_t calls = ran(code[i])) return calls;
+    }
+    for (size_t i = index + 1; i < code.size() && code[i].opcode != IROpCode::LABEL; ++i) {
+        if (uint64_t calls = ran(code[i])) return calls;
+        if (endsBlock(code[i].opcode)) break;
+    }
+    for (const auto& instr : callee.instructions) {
+        if (instr.opcode == IROpCode::LABEL) break;
+        if (uint64_t calls = ran(instr)) return calls;
+        if (endsBlock(instr.opcode)) break;
+    }
+    return 0;
+}
+
+// First non-label instruction at or after index
+size_t skipLabels(const std::vector<IRInstruction>& code, size_t index) {
+    while (index < code.size() && code[index].opcode == IROpCode::LABEL) index++;
+    return index;
+}
+
+// Retarget jumps whose destination immediately jumps again, and copy returns into jumps to them
+bool threadJumps(std::vector<IRInstruction>& code) {
+    auto labels = labelIndex(code);
+    bool changed = false;
+    // Follow a chain of unconditional jumps from label
+    auto finalTarget = [&](std::string label) {
+        std::set<std::string> seen{label};
+        while (true) {
+            auto it = labels.find(label);
+            if (it == labels.end()) return label;
+            size_t target = skipLabels(code, it->second);
+            if (target >= code.size() || code[target].opcode != IROpCode::JMP) return label;
+            if (!seen.insert(code[target].label).second) return label;  // Jump cycle
+            label = code[target].label;
+        }
+    };
+
+    for (auto& instr : code) {
+        if (isMultiway(instr.opcode)) {
+            std::string label = finalTarget(instr.label);
+            if (label != instr.label) changed = true;
+            instr.label = label;
+            for (auto& c : instr.cases) {
+                label = finalTarget(c.second);
+                if (label != c.second) changed = true;
+                c.second = label;
+            }
+            continue;
+        }
+        if (!isJump(instr.opcode)) continue;
+
+        std::set<std::string> seen{instr.label};
+        while (true) {
+            auto it = labels.find(instr.label);
+            if (it == labels.end()) break;
+            size_t target = skipLabels(code, it->second);
+            if (target >= code.size()) break;
+            const auto& next = code[target];
+
+            std::string forward;
+            if (next.opcode == IROpCode::JMP) {
+                forward = next.label;
+            } else if (next.opcode == instr.opcode && instr.opcode != IROpCode::JMP &&
+                       sameValue(next.operands[0], instr.operands[0])) {
+                // Same condition tested again: it takes the same way
+                forward = next.label;
+            } else if (next.opcode == IROpCode::RET && instr.opcode == IROpCode::JMP) {
+                instr = next;
+                changed = true;
+                break;
+            } else {
+                break;
+            }
+            if (!seen.insert(forward).second) break;  // Jump cycle
+            instr.label = forward;
+            changed = true;
+        }
+    }
+    return changed;
+}
+
+// Drop unreachable code, jumps to the next instruction, and labels nothing jumps to
+bool removeDeadBlocks(std::vector<IRInstruction>& code) {
+    std::set<std::string> targets;
+    for (const auto& instr : code) {
+        for (const auto& target : branchTargets(instr)) targets.insert(target);
+    }
+
+    std::vector<IRInstruction> live;
+    live.reserve(code.size());
+    bool reachable = true;
+    for (size_t i = 0; i < code.size(); ++i) {
+        const auto& instr = code[i];
+        if (instr.opcode == IROpCode::LABEL) {
+            if (!targets.count(instr.label)) continue;
+            reachable = true;
+        }
+        if (!reachable) continue;
+        if (isJump(instr.opcode)) {
+            // A jump landing on the next real instruction does nothing
+            size_t next = i + 1;
+            bool toNext = false;
+            while (next < code.size() && code[next].opcode == IROpCode::LABEL) {
+                if (code[next].label == instr.label) toNext = true;
+                next++;
+            }
+            if (toNext) continue;
+        }
+        if (isTerminator(instr.opcode)) reachable = false;
+        live.push_back(instr);
+    }
+
+    // Adjacent labels name the same block; keep the first
+    std::unordered_map<std::string, std::string> alias;
+    for (size_t i = 1; i < live.size(); ++i) {
+        if (live[i].opcode == IROpCode::LABEL && live[i - 1].opcode == IROpCode::LABEL) {
+            std::string keep = live[i - 1].label;
+            auto it = alias.find(keep);
+            alias[live[i].label] = it != alias.end() ? it->second : keep;
+        }
+    }
+    if (!alias.empty()) {
+        std::vector<IRInstruction> merged;
+        merged.reserve(live.size());
+        for (auto& instr : live) {
+            for (auto& c : instr.cases) {
+                auto it = alias.find(c.second);
+                if (it != alias.end()) c.second = it->second;
+            }
+            auto it = alias.find(instr.label);
+            if (it == alias.end()) {
+                merged.push_back(instr);
+            } else if (instr.opcode != IROpCode::LABEL) {
+                instr.label = it->second;
+                merged.push_back(instr);
+            }
+        }
+        live = std::move(merged);
+    }
+
+    bool changed = live.size() != code.size();
+    code = std::move(live);
+    return changed;
+}
+
+// JZ c, A; JMP B; A: -> JNZ c, B; A:  (the branch falls through to the block that follows)
+bool invertBranches(std::vector<IRInstruction>& code) {
+    bool changed = false;
+    for (size_t i = 0; i + 2 < code.size(); ++i) {
+        auto& branch = code[i];
+        auto& jump = code[i + 1];
+        if ((branch.opcode != IROpCode::JZ && branch.opcode != IROpCode::JNZ) || jump.opcode != IROpCode::JMP) continue;
+        if (code[i + 2].opcode != IROpCode::LABEL || code[i + 2].label != branch.label) continue;
+        branch.opcode = branch.opcode == IROpCode::JZ ? IROpCode::JNZ : IROpCode::JZ;
+        branch.label = jump.label;
+        code.erase(code.begin() + i + 1);
+        changed = true;
+    }
+    return changed;
+}
+
+// Move a block that is only reached by one unconditional jump to sit right after that jump
+bool chainBlocks(std::vector<IRInstruction>& code) {
+    std::unordered_map<std::string, int> references;
+    for (const auto& instr : code) {
+        for (const auto& target : branchTargets(instr)) references[target]++;
+    }
+    auto labels = labelIndex(code);
+
+    for (size_t i = 0; i < code.size(); ++i) {
+        if (code[i].opcode != IROpCode::JMP || references[code[i].label] != 1) continue;
+        size_t start = labels[code[i].label];
+        if (start == 0 || start <= i + 1) continue;
+        if (!isTerminator(code[start - 1].opcode)) continue;  // Also entered by fall-through
+
+        // The block must end in a terminator so moving it changes no fall-through
+        size_t end = start + 1;
+        while (end < code.size() && code[end].opcode != IROpCode::LABEL && !isTerminator(code[end].opcode)) end++;
+        if (end >= code.size() || !isTerminator(code[end].opcode)) continue;
+        if (i >= start && i <= end) continue;
+
+        std::vector<IRInstruction> block(code.begin() + start, code.begin() + end + 1);
+        code.erase(code.begin() + start, code.begin() + end + 1);
+        size_t jump = start < i ? i - block.size() : i;
+        code.erase(code.begin() + jump);
+        code.insert(code.begin() + jump, block.begin(), block.end());
+        return true;
+    }
+    return false;
+}
+
+// Loop unrolling limits
+const long kFullUnrollTrips = 8;        // Counted loops up to this many iterations are fully unrolled
+const long kPartialUnrollFactor = 4;    // Body copies per iteration of a partially unrolled loop
+const size_t kUnrollBudget = 160;       // Instructions one unrolling may add
+
+// Copy code[from, to) giving every label defined there a fresh name
+std::vector<IRInstruction> copyWithFreshLabels(const std::vector<IRInstruction>& code, size_t from, size_t to,
+                                               const std::string& suffix, std::set<std::string>& created) {
+    std::set<std::string> local;
+    for (size_t i = from; i < to; ++i) {
+        if (code[i].opcode == IROpCode::LABEL) local.insert(code[i].label);
+    }
+    auto rename = [&](std::string& label) {
+        if (!local.count(label)) return;
+        label += suffix;
+        created.insert(label);
+    };
+
+    std::vector<IRInstruction> copy(code.begin() + from, code.begin() + to);
+    for (auto& instr : copy) {
+        if (instr.opcode == IROpCode::LABEL || isBranch(instr.opcode)) rename(instr.label);
+        for (auto& c : instr.cases) rename(c.second);
+    }
+    return copy;
+}
+
+} // namespace
+
+std::vector<LoopInfo> findLoops(const IRFunction& func) {
+    std::vector<LoopInfo> loops;
+    const auto& code = func.instructions;
+    auto labels = labelIndex(code);
+    auto constants = constantTemps(code);
+
+    // Branch edges as (source, target) instruction indices, shared by every loop's entry check
+    std::vector<std::pair<size_t, size_t>> edges;
+    for (size_t k = 0; k < code.size(); ++k) {
+        if (!isBranch(code[k].opcode)) continue;
+        for (const auto& label : branchTargets(code[k])) {
+            auto target = labels.find(label);
+            if (target != labels.end()) edges.emplace_back(k, target->second);
+        }
+    }
+
+    for (size_t j = 0; j < code.size(); ++j) {
+        const auto& back = code[j];
+        if (back.opcode != IROpCode::JMP && back.opcode != IROpCode::JNZ) continue;
+        auto it = labels.find(back.label);
+        if (it == labels.end() || it->second >= j) continue;
+        if (j + 1 >= code.size() || code[j + 1].opcode != IROpCode::LABEL) continue;
+
+        LoopInfo loop;
+        loop.header = it->second;
+        loop.latch = j;
+        loop.headerLabel = back.label;
+        loop.exitLabel = code[j + 1].label;
+        loop.rotated = back.opcode == IROpCode::JNZ;
+
+        // Exit test: the first branch after the header, or the latch itself when rotated
+        if (loop.rotated) {
+            loop.exitTest = j;
+        } else {
+            size_t test = loop.header + 1;
+            while (test < j && code[test].opcode != IROpCode::LABEL && !isBranch(code[test].opcode)) ++test;
+            if (test >= j || code[test].opcode != IROpCode::JZ || code[test].label != loop.exitLabel) continue;
+            loop.exitTest = test;
+        }
+
+        // Single entry, single exit: only the latch targets the header, no jumps
+        // from outside land inside and none inside leave except the exit test
+        loop.singleEntry = true;
+        for (const auto& edge : edges) {
+            size_t k = edge.first;
+            bool inside = k > loop.header && k <= loop.latch;
+            bool targetInside = edge.second >= loop.header && edge.second <= loop.latch;
+            if (edge.second == loop.header && k != loop.latch) loop.singleEntry = false;
+            if (!inside && targetInside) loop.singleEntry = false;
+            if (inside && !targetInside && k != loop.exitTest) loop.singleEntry = false;
+            if (!loop.singleEntry) break;
+        }
+
+        // Induction variable from the comparison feeding the exit test
+        const IRValue& cond = code[loop.exitTest].operands[0];
+        for (size_t i = loop.exitTest; i-- > loop.header + 1;) {
+            const auto& instr = code[i];
+            if (instr.opcode == IROpCode::LABEL || isBranch(instr.opcode)) break;
+            if (!writes(instr, cond)) continue;
+            IROpCode op = instr.opcode;
+            if (op != IROpCode::LT && op != IROpCode::LE && op != IROpCode::GT &&
+                op != IROpCode::GE && op != IROpCode::NE) break;
+            if (analyzeInduction(code, loop, constants, instr.operands[0])) {
+                loop.compare = op;
+                loop.bound = instr.operands[1];
+            } else if (analyzeInduction(code, loop, constants, instr.operands[1])) {
+                loop.compare = swapCompare(op);
+                loop.bound = instr.operands[0];
+            }
+            break;
+        }
+
+        if (loop.hasInduction) {
+            loop.boundInvariant = isLoopInvariant(code, loop, constants, loop.bound);
+            loop.hasConstantBound = lookupConstant(constants, loop.bound, loop.boundValue);
+            if (loop.hasStart && loop.hasConstantBound) {
+                loop.tripCount = computeTripCount(loop.compare, loop.start, loop.boundValue, loop.step);
+            }
+        }
+
+        loops.push_back(loop);
+    }
+    return loops;
+}
+
+IROptimizer::IROptimizer(IRProgram& program, const Profile* profile)
+    : program(program), profile(profile), nameCounter(0) {}
+
+void IROptimizer::optimize(bool inlining) {
+    // Inline first so constant arguments fold through the copied bodies
+    if (inlining) inlineCalls();
+    for (auto& func : program.functions) optimizeFunction(func);
+}
+
+void IROptimizer::optimize(const std::set<std::string>& only) {
+    inlineCalls();
+    for (auto& func : program.functions) {
+        if (only.count(func.name)) optimizeFunction(func);
+    }
+}
+
+void IROptimizer::optimizeFunction(IRFunction& func) {
+    // Bounds checks are proven on the original loops; unrolled copies stay in range
+    eliminateBoundsChecks(func);
+    unrollLoops(func);
+    foldConstants(func);
+    optimizeLoops(func);
+    simplifyControlFlow(func);
+    eliminateTailCalls(func);
+    allocateRegisters(func);
+    specializeTypes(func);
+}
+
+void IROptimizer::inlineCalls() {
+    auto& functions = program.functions;
+    std::unordered_map<std::string, size_t> byName;
+    for (size_t i = 0; i < functions.size(); ++i) byName[functions[i].name] = i;
+
+    // Call graph over user functions; builtins have no IRFunction
+    std::vector<std::set<size_t>> callees(functions.size());
+    std::unordered_map<std::string, int> callSites;
+    for (size_t i = 0; i < functions.size(); ++i) {
+        for (const auto& instr : functions[i].instructions) {
+            if (instr.opcode != IROpCode::CALL) continue;
+            auto it = byName.find(instr.label);
+            if (it == byName.end()) continue;
+            callees[i].insert(it->second);
+            callSites[instr.label]++;
+        }
+    }
+
+    // A function is recursive when it can reach itself
+    std::vector<bool> recursive(functions.size(), false);
+    for (size_t i = 0; i < functions.size(); ++i) {
+        std::vector<bool> seen(functions.size(), false);
+        std::vector<size_t> stack(callees[i].begin(), callees[i].end());
+        while (!stack.empty() && !recursive[i]) {
+            size_t f = stack.back();
+            stack.pop_back();
+            if (f == i) recursive[i] = true;
+            if (seen[f]) continue;
+            seen[f] = true;
+            stack.insert(stack.end(), callees[f].begin(), callees[f].end());
+        }
+    }
+
+    // Callees before callers, so nested calls arrive already inlined
+    std::vector<size_t> order;
+    std::vector<bool> visited(functions.size(), false);
+    std::function<void(size_t)> visit = [&](size_t f) {
+        if (visited[f]) return;
+        visited[f] = true;
+        for (size_t callee : callees[f]) visit(callee);
+        order.push_back(f);
+    };
+    for (size_t i = 0; i < functions.size(); ++i) visit(i);
+
+    for (size_t f : order) inlineInto(functions[f], recursive, callSites);
+}
+
+void IROptimizer::inlineInto(IRFunction& caller, const std::vector<bool>& recursive,
+                             const std::unordered_map<std::string, int>& callSites) {
+    std::unordered_map<std::string, size_t> byName;
+    for (size_t i = 0; i < program.functions.size(); ++i) byName[program.functions[i].name] = i;
+
+    std::vector<IRInstruction> code;
+    code.reserve(caller.instructions.size());
+    size_t size = codeSize(caller);
+    int tempBase = nextTempId(caller);
+
+    for (size_t index = 0; index < caller.instructions.size(); ++index) {
+        const auto& instr = caller.instructions[index];
+        auto it = instr.opcode == IROpCode::CALL ? byName.find(instr.label) : byName.end();
+        if (it == byName.end()) {
+            code.push_back(instr);
+            continue;
+        }
+
+        const IRFunction& callee = program.functions[it->second];
+        size_t calleeSize = codeSize(callee);
+        auto sites = callSites.find(callee.name);
+        bool small = calleeSize <= kInlineSizeLimit;
+        bool onlyCall = sites != callSites.end() && sites->second == 1 && calleeSize <= kInlineSingleCallLimit;
+        if (profile && instr.site) {
+            // Profiled: never-run calls only inline when tiny, hot ones take larger bodies
+            uint64_t calls = recordedCalls(*profile, caller.instructions, index, callee);
+            if (calls == 0) onlyCall = false;
+            if (calls >= kHotCallCount) small = calleeSize <= kHotInlineSizeLimit;
+        }
+        bool inlinable = &callee != &caller && !recursive[it->second] &&
+                         instr.operands.size() == callee.parameters.size() &&
+                         (small || onlyCall) && size + calleeSize <= kMaxCallerSize;
+        if (!inlinable) {
+            code.push_back(instr);
+            continue;
+        }
+
+        std::string suffix = ".i" + std::to_string(nameCounter++);
+        auto body = expandCall(instr, callee, tempBase, suffix);
+        tempBase += nextTempId(callee) + 1;
+        size += calleeSize;
+        code.insert(code.end(), body.begin(), body.end());
+    }
+
+    caller.instructions = std::move(code);
+}
+
+void IROptimizer::unrollLoops(IRFunction& func) {
+    // Labels of loops already handled, including copies made by unrolling
+    std::set<std::string> done;
+    while (true) {
+        auto loops = findLoops(func);
+        const LoopInfo* next = nullptr;
+        for (const auto& loop : loops) {
+            if (!done.count(loop.headerLabel)) {
+                next = &loop;
+                break;
+            }
+        }
+        if (!next) break;
+        done.insert(next->headerLabel);
+        unrollLoop(func, *next, done);
+    }
+}
+
+bool IROptimizer::unrollLoop(IRFunction& func, const LoopInfo& loop, std::set<std::string>& done) {
+    if (loop.rotated || !loop.singleEntry || !loop.hasInduction || loop.step == 0) return false;
+    auto& code = func.instructions;
+
+    // The test must be a pure computation into temps that the body never reads
+    std::vector<IRValue> testTemps;
+    for (size_t i = loop.header + 1; i < loop.exitTest; ++i) {
+        const auto& instr = code[i];
+        if (!isPure(instr.opcode) || instr.result.type != IRValue::Type::TEMP) return false;
+        testTemps.push_back(instr.result);
+    }
+    for (size_t i = loop.exitTest + 1; i < loop.latch; ++i) {
+        for (const auto& temp : testTemps) {
+            if (reads(code[i], temp)) return false;
+        }
+    }
+
+    size_t bodySize = 0;
+    for (size_t i = loop.exitTest + 1; i < loop.latch; ++i) {
+        if (code[i].opcode != IROpCode::LABEL) bodySize++;
+    }
+
+    // Full unroll: the body repeated tripCount times, without test or back edge
+    if (loop.tripCount >= 0 && loop.tripCount <= kFullUnrollTrips &&
+        static_cast<size_t>(loop.tripCount) * bodySize <= kUnrollBudget) {
+        std::vector<IRInstruction> rewritten(code.begin(), code.begin() + loop.header);
+        for (long n = 0; n < loop.tripCount; ++n) {
+            std::string suffix = ".u" + std::to_string(nameCounter++);
+            auto body = copyWithFreshLabels(code, loop.exitTest + 1, loop.latch, suffix, done);
+            rewritten.insert(rewritten.end(), body.begin(), body.end());
+        }
+        rewritten.insert(rewritten.end(), code.begin() + loop.latch + 1, code.end());
+        code = std::move(rewritten);
+        return true;
+    }
+
+    // Partial unroll: run k iterations per test while iv + (k - 1) * step still passes it,
+    // then let the original loop finish the remainder
+    bool monotonic = (loop.step > 0 && (loop.compare == IROpCode::LT || loop.compare == IROpCode::LE)) ||
+                     (loop.step < 0 && (loop.compare == IROpCode::GT || loop.compare == IROpCode::GE));
+    if (!monotonic || !loop.boundInvariant) return false;
+    if (loop.tripCount >= 0 && loop.tripCount < 2 * kPartialUnrollFactor) return false;
+    if (static_cast<size_t>(kPartialUnrollFactor - 1) * bodySize > kUnrollBudget) return false;
+
+    std::string unrolledLabel = loop.headerLabel + ".u" + std::to_string(nameCounter++);
+    std::string remainderLabel = unrolledLabel + ".rest";
+    done.insert(unrolledLabel);
+
+    std::vector<IRInstruction> unrolled;
+    IRInstruction header(IROpCode::LABEL);
+    header.label = unrolledLabel;
+    unrolled.push_back(header);
+
+    // Recompute the bound with fresh temps
+    int nextTemp = nextTempId(func);
+    std::unordered_map<int, IRValue> renamed;
+    auto rename = [&](IRValue value) {
+        if (value.type != IRValue::Type::TEMP) return value;
+        auto it = renamed.find(value.id);
+        return it != renamed.end() ? it->second : value;
+    };
+    for (size_t i = loop.header + 1; i < loop.exitTest; ++i) {
+        if (writes(code[i], code[loop.exitTest].operands[0])) continue;  // Replaced by the test below
+        IRInstruction copy = code[i];
+        for (auto& operand : copy.operands) operand = rename(operand);
+        renamed[copy.result.id] = makeTemp(nextTemp++);
+        copy.result = renamed[copy.result.id];
+        unrolled.push_back(copy);
+    }
+    IRValue offset = makeTemp(nextTemp++);
+    IRValue last = makeTemp(nextTemp++);
+    IRValue passes = makeTemp(nextTemp++);
+    unrolled.push_back(makeLoadInt((kPartialUnrollFactor - 1) * loop.step, offset));
+    IRInstruction add(IROpCode::ADD);
+    add.operands = {loop.inductionVar, offset};
+    add.result = last;
+    unrolled.push_back(add);
+    IRInstruction compare(loop.compare);
+    compare.operands = {last, rename(loop.bound)};
+    compare.result = passes;
+    unrolled.push_back(compare);
+    IRInstruction test(IROpCode::JZ);
+    test.operands = {passes};
+    test.label = remainderLabel;
+    unrolled.push_back(test);
+
+    for (long n = 0; n < kPartialUnrollFactor; ++n) {
+        std::string suffix = ".u" + std::to_string(nameCounter++);
+        auto body = copyWithFreshLabels(code, loop.exitTest + 1, loop.latch, suffix, done);
+        unrolled.insert(unrolled.end(), body.begin(), body.end());
+    }
+    IRInstruction back(IROpCode::JMP);
+    back.label = unrolledLabel;
+    unrolled.push_back(back);
+    IRInstruction remainder(IROpCode::LABEL);
+    remainder.label = remainderLabel;
+    unrolled.push_back(remainder);
+
+    code.insert(code.begin() + loop.header, unrolled.begin(), unrolled.end());
+    return true;
+}
+
+void IROptimizer::foldConstants(IRFunction& func) {
+    auto& code = func.instructions;
+
+    // Values are only tracked within straight-line code: any jump target resets them
+    std::set<std::string> targets;
+    for (const auto& instr : code) {
+        for (const auto& target : branchTargets(instr)) targets.insert(target);
+    }
+
+    std::unordered_map<std::string, long> known;  // Keyed by IRValue::toString()
+    auto lookup = [&](const IRValue& value, long& out) {
+        auto it = known.find(value.toString());
+        if (it == known.end()) return false;
+        out = it->second;
+        return true;
+    };
+
+    for (auto& instr : code) {
+        long a = 0, b = 0, result = 0;
+        switch (instr.opcode) {
+            case IROpCode::LABEL:
+                if (targets.count(instr.label)) known.clear();
+                continue;
+            case IROpCode::JMP:
+            case IROpCode::RET:
+                known.clear();
+                continue;
+            case IROpCode::JZ:
+            case IROpCode::JNZ:
+                if (lookup(instr.operands[0], a)) {
+                    bool taken = (a == 0) == (instr.opcode == IROpCode::JZ);
+                    instr.opcode = taken ? IROpCode::JMP : IROpCode::NOP;
+                    instr.operands.clear();
+                    if (taken) known.clear();
+                }
+                continue;
+            case IROpCode::JUMP_TABLE:
+            case IROpCode::SWITCH:
+                if (lookup(instr.operands[0], a)) {
+                    for (const auto& c : instr.cases) {
+                        if (c.first == a) instr.label = c.second;
+                    }
+                    instr.opcode = IROpCode::JMP;
+                    instr.operands.clear();
+                    instr.cases.clear();
+                }
+                known.clear();
+                continue;
+            case IROpCode::LOAD_INT:
+                known[instr.result.toString()] = std::stol(instr.operands[0].name);
+                continue;
+            case IROpCode::STORE:
+                if (lookup(instr.operands[0], a)) {
+                    known[instr.result.toString()] = a;
+                } else {
+                    known.erase(instr.result.toString());
+                }
+                continue;
+            default:
+                break;
+        }
+
+        bool folded = false;
+        if (instr.operands.size() == 2 && lookup(instr.operands[0], a) && lookup(instr.operands[1], b)) {
+            folded = evaluateConstant(instr.opcode, a, b, result);
+        } else if (instr.operands.size() == 1 &&
+                   (instr.opcode == IROpCode::NEG || instr.opcode == IROpCode::NOT) &&
+                   lookup(instr.operands[0], a)) {
+            folded = evaluateConstant(instr.opcode, a, 0, result);
+        }
+
+        if (folded) {
+            instr = makeLoadInt(result, instr.result);
+            known[instr.result.toString()] = result;
+        } else if (writesResult(instr)) {
+            known.erase(instr.result.toString());
+        }
+    }
+
+    // Drop folded-away branches, code after unconditional jumps, and loads nothing reads
+    targets.clear();
+    for (const auto& instr : code) {
+        for (const auto& target : branchTargets(instr)) targets.insert(target);
+    }
+    std::vector<IRInstruction> live;
+    live.reserve(code.size());
+    bool reachable = true;
+    for (auto& instr : code) {
+        if (instr.opcode == IROpCode::LABEL && targets.count(instr.label)) reachable = true;
+        if (!reachable || instr.opcode == IROpCode::NOP) continue;
+        if (instr.opcode == IROpCode::JMP || instr.opcode == IROpCode::RET) reachable = false;
+        live.push_back(std::move(instr));
+    }
+    code = std::move(live);
+
+    bool changed = true;
+    while (changed) {
+        changed = false;
+        std::set<int> used;
+        for (const auto& instr : code) {
+            for (const auto& operand : instr.operands) {
+                if (operand.type == IRValue::Type::TEMP) used.insert(operand.id);
+            }
+            if (!writesResult(instr) && instr.result.type == IRValue::Type::TEMP) used.insert(instr.result.id);
+        }
+        auto dead = [&](const IRInstruction& instr) {
+            bool load = instr.opcode == IROpCode::LOAD_INT || instr.opcode == IROpCode::LOAD_FLOAT ||
+                        instr.opcode == IROpCode::LOAD_STRING || instr.opcode == IROpCode::STORE;
+            return load && instr.result.type == IRValue::Type::TEMP && !used.count(instr.result.id);
+        };
+        auto end = std::remove_if(code.begin(), code.end(), dead);
+        if (end != code.end()) {
+            code.erase(end, code.end());
+            changed = true;
+        }
+    }
+}
+
+void IROptimizer::optimizeLoops(IRFunction& func) {
+    // Transform one loop at a time; indices shift after every rewrite
+    std::set<std::string> done;
+    while (true) {
+        auto loops = findLoops(func);
+        const LoopInfo* next = nullptr;
+        for (const auto& loop : loops) {
+            if (!done.count(loop.headerLabel)) {
+                next = &loop;
+                break;
+            }
+        }
+        if (!next) break;
+
+        std::string header = next->headerLabel;
+        done.insert(header);
+        if (!next->singleEntry) continue;
+
+        if (strengthReduce(func, *next)) {
+            for (const auto& loop : findLoops(func)) {
+                if (loop.headerLabel == header) {
+                    rotateLoop(func, loop);
+                    break;
+                }
+            }
+        } else {
+            rotateLoop(func, *next);
+        }
+    }
+}
+
+void IROptimizer::eliminateBoundsChecks(IRFunction& func) {
+    auto& code = func.instructions;
+    for (const auto& loop : findLoops(func)) {
+        // 0 <= start, step > 0 and iv < bound at the test: iv stays in range until it is stepped
+        if (!loop.singleEntry || !loop.hasInduction || !loop.hasStart) continue;
+        if (loop.start < 0 || loop.step <= 0) continue;
+
+        size_t first = loop.rotated ? loop.header + 1 : loop.exitTest + 1;
+        for (size_t i = first; i < loop.incrementIndex; ++i) {
+            auto& instr = code[i];
+            if (instr.opcode != IROpCode::LOAD_INDEX && instr.opcode != IROpCode::STORE_INDEX) continue;
+            if (!sameValue(instr.operands[1], loop.inductionVar)) continue;
+            if (!boundedByLength(code, loop, instr.operands[0])) continue;
+            instr.opcode = instr.opcode == IROpCode::LOAD_INDEX ? IROpCode::LOAD_INDEX_UNCHECKED
+                                                                : IROpCode::STORE_INDEX_UNCHECKED;
+        }
+    }
+}
+
+void IROptimizer::simplifyControlFlow(IRFunction& func) {
+    auto& code = func.instructions;
+    bool changed = true;
+    while (changed) {
+        changed = threadJumps(code);
+        changed |= removeDeadBlocks(code);
+        changed |= invertBranches(code);
+        changed |= chainBlocks(code);
+        if (!changed && profile) changed = placeColdBlocks(func);
+    }
+}
+
+bool IROptimizer::placeColdBlocks(IRFunction& func) {
+    auto& code = func.instructions;
+    for (size_t i = 0; i + 1 < code.size(); ++i) {
+        const auto& branch = code[i];
+        if ((branch.opcode != IROpCode::JZ && branch.opcode != IROpCode::JNZ) || !branch.site) continue;
+        const ProfileCounts* counts = profile->find(branch.site);
+        if (!counts || counts->executed == 0) continue;
+
+        // How often the branch falls through to the next block
+        uint64_t falseCount = counts->executed - counts->trueCount;
+        uint64_t fallThrough = branch.opcode == IROpCode::JZ ? counts->trueCount : falseCount;
+        if (fallThrough * kColdRatio >= counts->executed) continue;
+
+        // The fall-through must be one straight-line block directly followed by the target,
+        // either ending in a terminator or running into the target
+        size_t end = i + 1;
+        while (end < code.size() && code[end].opcode != IROpCode::LABEL && !isTerminator(code[end].opcode)) end++;
+        size_t after = end < code.size() && isTerminator(code[end].opcode) ? end + 1 : end;
+        if (after == i + 1 || after >= code.size()) continue;
+        if (code[after].opcode != IROpCode::LABEL || code[after].label != branch.label) continue;
+
+        // JZ c, A; cold; A: hot  ==>  JNZ c, Cold; A: hot ... Cold: cold; JMP A
+        std::string coldLabel = branch.label + ".cold" + std::to_string(nameCounter++);
+        std::vector<IRInstruction> cold;
+        IRInstruction label(IROpCode::LABEL);
+        label.label = coldLabel;
+        cold.push_back(label);
+        cold.insert(cold.end(), code.begin() + i + 1, code.begin() + after);
+        if (!isTerminator(cold.back().opcode)) {
+            IRInstruction back(IROpCode::JMP);
+            back.label = branch.label;
+            cold.push_back(back);
+        }
+
+        code[i].opcode = branch.opcode == IROpCode::JZ ? IROpCode::JNZ : IROpCode::JZ;
+        code[i].label = coldLabel;
+        code.erase(code.begin() + i + 1, code.begin() + after);
+        if (!isTerminator(code.back().opcode)) {
+            code.push_back(IRInstruction(IROpCode::RET));  // Keep the hot path from running into cold code
+        }
+        code.insert(code.end(), cold.begin(), cold.end());
+        return true;
+    }
+    return false;
+}
+
+void IROptimizer::eliminateTailCalls(IRFunction& func) {
+    auto& code = func.instructions;
+    std::unordered_map<std::string, const IRFunction*> byName;
+    for (const auto& f : program.functions) byName[f.name] = &f;
+
+    std::string entryLabel = "L_entry." + func.name;
+    bool selfCall = false;
+    int nextTemp = nextTempId(func);
+    std::vector<IRValue> locals = freshLocals(func);
+
+    std::vector<IRInstruction> rewritten;
+    rewritten.reserve(code.size());
+    for (size_t i = 0; i < code.size(); ++i) {
+        const auto& instr = code[i];
+        auto callee = instr.opcode == IROpCode::CALL ? byName.find(instr.label) : byName.end();
+        bool tail = callee != byName.end() && i + 1 < code.size() &&
+                    code[i + 1].opcode == IROpCode::RET && code[i + 1].operands.size() == 1 &&
+                    sameValue(code[i + 1].operands[0], instr.result) &&
+                    instr.operands.size() == callee->second->parameters.size();
+        if (!tail) {
+            rewritten.push_back(instr);
+            continue;
+        }
+
+        if (callee->second == &func) {
+            // Parameters are assigned in parallel: locals are read into temps before any store
+            std::vector<IRValue> args;
+            for (const auto& arg : instr.operands) {
+                if (arg.type != IRValue::Type::LOCAL) {
+                    args.push_back(arg);
+                    continue;
+                }
+                IRInstruction copy(IROpCode::STORE);
+                copy.operands.push_back(arg);
+                copy.result = makeTemp(nextTemp++);
+                rewritten.push_back(copy);
+                args.push_back(copy.result);
+            }
+            for (size_t p = 0; p < args.size(); ++p) {
+                IRInstruction bind(IROpCode::STORE);
+                bind.operands.push_back(args[p]);
+                bind.result = IRValue(IRValue::Type::LOCAL, func.parameters[p].second);
+                rewritten.push_back(bind);
+            }
+            // As a real call would, the next iteration starts with the other locals unset
+            resetLocals(rewritten, locals, makeTemp(nextTemp++));
+            IRInstruction jump(IROpCode::JMP);
+            jump.label = entryLabel;
+            rewritten.push_back(jump);
+            selfCall = true;
+        } else {
+            IRInstruction call = instr;
+            call.opcode = IROpCode::TAIL_CALL;
+            call.result = IRValue();
+            rewritten.push_back(call);
+        }
+        i++;  // The RET is subsumed
+    }
+
+    if (selfCall) {
+        IRInstruction entry(IROpCode::LABEL);
+        entry.label = entryLabel;
+        rewritten.insert(rewritten.begin(), entry);
+    }
+    code = std::move(rewritten);
+}
+
+void IROptimizer::allocateRegisters(IRFunction& func) {
+    auto& code = func.instructions;
+    size_t tempCount = static_cast<size_t>(nextTempId(func));
+    if (tempCount == 0) return;
+
+    // Basic blocks: labels start one, branches and returns end one
+    std::vector<size_t> starts;
+    for (size_t i = 0; i < code.size(); ++i) {
+        if (i == 0 || code[i].opcode == IROpCode::LABEL || endsBlock(code[i - 1].opcode)) starts.push_back(i);
+    }
+    size_t blockCount = starts.size();
+    auto blockEnd = [&](size_t b) { return b + 1 < blockCount ? starts[b + 1] : code.size(); };
+
+    std::unordered_map<std::string, size_t> labelBlock;
+    for (size_t b = 0; b < blockCount; ++b) {
+        if (code[starts[b]].opcode == IROpCode::LABEL) labelBlock[code[starts[b]].label] = b;
+    }
+
+    std::vector<std::vector<size_t>> successors(blockCount);
+    std::vector<std::vector<bool>> use(blockCount, std::vector<bool>(tempCount, false));
+    std::vector<std::vector<bool>> def(blockCount, std::vector<bool>(tempCount, false));
+    for (size_t b = 0; b < blockCount; ++b) {
+        for (size_t i = starts[b]; i < blockEnd(b); ++i) {
+            const auto& instr = code[i];
+            for (const auto& operand : instr.operands) {
+                if (operand.type == IRValue::Type::TEMP && operand.id >= 0 && !def[b][operand.id]) {
+                    use[b][operand.id] = true;
+                }
+            }
+            if (instr.result.type == IRValue::Type::TEMP && instr.result.id >= 0) {
+                // STORE_INDEX updates its result in place, which reads it
+                if (writesResult(instr)) {
+                    def[b][instr.result.id] = true;
+                } else if (!def[b][instr.result.id]) {
+                    use[b][instr.result.id] = true;
+                }
+            }
+        }
+
+        const auto& last = code[blockEnd(b) - 1];
+        for (const auto& label : branchTargets(last)) {
+            auto target = labelBlock.find(label);
+            if (target != labelBlock.end()) successors[b].push_back(target->second);
+        }
+        if (!isTerminator(last.opcode) && b + 1 < blockCount) successors[b].push_back(b + 1);
+    }
+
+    // Backward dataflow to a fixed point: in = use | (out - def)
+    std::vector<std::vector<bool>> liveIn(blockCount, std::vector<bool>(tempCount, false));
+    std::vector<std::vector<bool>> liveOut = liveIn;
+    bool changed = true;
+    while (changed) {
+        changed = false;
+        for (size_t b = blockCount; b-- > 0;) {
+            for (size_t succ : successors[b]) {
+                for (size_t t = 0; t < tempCount; ++t) {
+                    if (liveIn[succ][t] && !liveOut[b][t]) liveOut[b][t] = true;
+                }
+            }
+            for (size_t t = 0; t < tempCount; ++t) {
+                bool live = use[b][t] || (liveOut[b][t] && !def[b][t]);
+                if (live && !liveIn[b][t]) {
+                    liveIn[b][t] = true;
+                    changed = true;
+                }
+            }
+        }
+    }
+
+    // Live intervals over instruction order; holes are filled in, which is conservative
+    std::vector<long> first(tempCount, -1), last(tempCount, -1);
+    auto extend = [&](int t, size_t index) {
+        long i = static_cast<long>(index);
+        if (first[t] < 0 || i < first[t]) first[t] = i;
+        if (i > last[t]) last[t] = i;
+    };
+    for (size_t b = 0; b < blockCount; ++b) {
+        for (size_t t = 0; t < tempCount; ++t) {
+            if (liveIn[b][t]) extend(t, starts[b]);
+            if (liveOut[b][t]) extend(t, blockEnd(b) - 1);
+        }
+        for (size_t i = starts[b]; i < blockEnd(b); ++i) {
+            for (const auto& operand : code[i].operands) {
+                if (operand.type == IRValue::Type::TEMP && operand.id >= 0) extend(operand.id, i);
+            }
+            if (code[i].result.type == IRValue::Type::TEMP && code[i].result.id >= 0) extend(code[i].result.id, i);
+        }
+    }
+
+    std::vector<int> order;
+    for (size_t t = 0; t < tempCount; ++t) {
+        if (first[t] >= 0) order.push_back(static_cast<int>(t));
+    }
+    std::sort(order.begin(), order.end(), [&](int a, int b) { return first[a] < first[b]; });
+
+    // A register frees up only after its interval ends, so no instruction's result
+    // shares a register with one of its own operands
+    std::vector<int> assignment(tempCount, -1);
+    std::multimap<long, int> active;  // Interval end -> register
+    std::set<int> freeRegisters;
+    int registerCount = 0;
+    for (int t : order) {
+        while (!active.empty() && active.begin()->first < first[t]) {
+            freeRegisters.insert(active.begin()->second);
+            active.erase(active.begin());
+        }
+        int reg;
+        if (freeRegisters.empty()) {
+            reg = registerCount++;
+        } else {
+            reg = *freeRegisters.begin();
+            freeRegisters.erase(freeRegisters.begin());
+        }
+        assignment[t] = reg;
+        active.emplace(last[t], reg);
+    }
+
+    for (auto& instr : code) {
+        for (auto& operand : instr.operands) {
+            if (operand.type == IRValue::Type::TEMP && operand.id >= 0) operand = makeTemp(assignment[operand.id]);
+        }
+        if (instr.result.type == IRValue::Type::TEMP && instr.result.id >= 0) {
+            instr.result = makeTemp(assignment[instr.result.id]);
+        }
+    }
+}
+
+void IROptimizer::specializeTypes(IRFunction& func) {
+    if (!profile) return;
+    for (auto& instr : func.instructions) {
+        if (!instr.site) continue;
+        IROpCode specialized;
+        switch (instr.opcode) {
+            case IROpCode::ADD: specialized = IROpCode::ADD_INT; break;
+            case IROpCode::SUB: specialized = IROpCode::SUB_INT; break;
+            case IROpCode::MUL: specialized = IROpCode::MUL_INT; break;
+            case IROpCode::EQ: specialized = IROpCode::EQ_INT; break;
+            case IROpCode::NE: specialized = IROpCode::NE_INT; break;
+            case IROpCode::LT: specialized = IROpCode::LT_INT; break;
+            case IROpCode::GT: specialized = IROpCode::GT_INT; break;
+            case IROpCode::LE: specialized = IROpCode::LE_INT; break;
+            case IROpCode::GE: specialized = IROpCode::GE_INT; break;
+            default: continue;
+        }
+        const ProfileCounts* counts = profile->find(instr.site);
+        if (counts && counts->executed > 0 && counts->types == PROFILE_INT) instr.opcode = specialized;
+    }
+}
+
+bool IROptimizer::strengthReduce(IRFunction& func, const LoopInfo& loop) {
+    if (!loop.hasInduction) return false;
+    auto& code = func.instructions;
+    auto constants = constantTemps(code);
+    const IRValue& iv = loop.inductionVar;
+
+    // Find MULs of the induction variable by a constant
+    struct Reduction {
+        IRValue derived;     // Local holding iv * factor
+        IRValue stepTemp;    // Temp holding step * factor
+        long factor;
+    };
+    std::vector<Reduction> reductions;
+    std::unordered_map<size_t, size_t> mulSites;   // instruction index -> reduction
+    for (size_t i = loop.header + 1; i < loop.latch; ++i) {
+        const auto& instr = code[i];
+        if (instr.opcode != IROpCode::MUL || instr.result.type != IRValue::Type::TEMP) continue;
+        long factor;
+        if (sameValue(instr.operands[0], iv) && lookupConstant(constants, instr.operands[1], factor)) {
+        } else if (sameValue(instr.operands[1], iv) && lookupConstant(constants, instr.operands[0], factor)) {
+        } else {
+            continue;
+        }
+        size_t which = reductions.size();
+        for (size_t r = 0; r < reductions.size(); ++r) {
+            if (reductions[r].factor == factor) which = r;
+        }
+        if (which == reductions.size()) {
+            Reduction reduction;
+            reduction.derived = IRValue(IRValue::Type::LOCAL, iv.name + ".sr" + std::to_string(nameCounter++));
+            reduction.factor = factor;
+            reductions.push_back(reduction);
+        }
+        mulSites[i] = which;
+    }
+    if (reductions.empty()) return false;
+
+    int tempId = nextTempId(func);
+    for (auto& reduction : reductions) {
+        reduction.stepTemp = makeTemp(tempId++);
+    }
+
+    // A product used only between the MUL and the step can read the derived local directly
+    std::unordered_map<int, IRValue> substitutions;
+    std::set<size_t> removed;
+    for (const auto& site : mulSites) {
+        const IRValue& product = code[site.first].result;
+        bool local = true;
+        for (size_t i = 0; i < code.size() && local; ++i) {
+            if (i == site.first) continue;
+            if (writes(code[i], product)) local = false;
+            if (reads(code[i], product) && (i < site.first || i >= loop.incrementIndex)) local = false;
+        }
+        if (local) {
+            substitutions[product.id] = reductions[site.second].derived;
+            removed.insert(site.first);
+        }
+    }
+
+    std::vector<IRInstruction> rewritten;
+    rewritten.reserve(code.size() + reductions.size() * 4);
+    for (size_t i = 0; i < code.size(); ++i) {
+        if (i == loop.header) {
+            // Preheader: derived = iv * factor, stepTemp = step * factor
+            for (const auto& reduction : reductions) {
+                IRValue factorTemp = makeTemp(tempId++);
+                rewritten.push_back(makeLoadInt(reduction.factor, factorTemp));
+                IRInstruction init(IROpCode::MUL);
+                init.operands.push_back(iv);
+                init.operands.push_back(factorTemp);
+                init.result = reduction.derived;
+                rewritten.push_back(init);
+                rewritten.push_back(makeLoadInt(loop.step * reduction.factor, reduction.stepTemp));
+            }
+        }
+
+        if (removed.count(i)) continue;
+        auto site = mulSites.find(i);
+        if (site != mulSites.end()) {
+            // Product still needed elsewhere: copy instead of multiplying
+            IRInstruction copy(IROpCode::STORE);
+            copy.operands.push_back(reductions[site->second].derived);
+            copy.result = code[i].result;
+            rewritten.push_back(copy);
+        } else {
+            IRInstruction instr = code[i];
+            for (auto& operand : instr.operands) {
+                if (operand.type != IRValue::Type::TEMP) continue;
+                auto sub = substitutions.find(operand.id);
+                if (sub != substitutions.end()) operand = sub->second;
+            }
+            rewritten.push_back(instr);
+        }
+
+        if (i == loop.incrementIndex) {
+            // Keep derived == iv * factor in step with the induction variable
+            for (const auto& reduction : reductions) {
+                IRInstruction bump(IROpCode::ADD);
+                bump.operands.push_back(reduction.derived);
+                bump.operands.push_back(reduction.stepTemp);
+                bump.result = reduction.derived;
+                rewritten.push_back(bump);
+            }
+        }
+    }
+
+    // Drop factor loads that no longer feed anything
+    std::set<int> usedTemps;
+    for (const auto& instr : rewritten) {
+        for (const auto& operand : instr.operands) {
+            if (operand.type == IRValue::Type::TEMP) usedTemps.insert(operand.id);
+        }
+    }
+    code.clear();
+    for (auto& instr : rewritten) {
+        if (instr.opcode == IROpCode::LOAD_INT && instr.result.type == IRValue::Type::TEMP &&
+            !usedTemps.count(instr.result.id)) {
+            continue;
+        }
+        code.push_back(std::move(instr));
+    }
+    return true;
+}
+
+bool IROptimizer::rotateLoop(IRFunction& func, const LoopInfo& loop) {
+    if (loop.rotated || !loop.singleEntry) return false;
+    auto& code = func.instructions;
+
+    // while (c) body  ==>  if (c) do body while (c)
+    std::vector<IRInstruction> rewritten(code.begin(), code.begin() + loop.header);
+    for (size_t i = loop.header + 1; i <= loop.exitTest; ++i) {
+        rewritten.push_back(code[i]);       // Guard
+    }
+    rewritten.push_back(code[loop.header]);
+    for (size_t i = loop.exitTest + 1; i < loop.latch; ++i) {
+        rewritten.push_back(code[i]);       // Body
+    }
+
+    // Latch: re-evaluate only the parts of the test the body can change
+    std::vector<IRValue> recomputed;
+    for (size_t i = loop.header + 1; i < loop.exitTest; ++i) {
+        const auto& instr = code[i];
+        bool invariant = isPure(instr.opcode) && writesResult(instr) && !reads(instr, instr.result) &&
+                         !writtenIn(code, instr.result, loop.exitTest + 1, loop.latch);
+        for (const auto& operand : instr.operands) {
+            if (!invariant) break;
+            if (writtenIn(code, operand, loop.exitTest + 1, loop.latch)) invariant = false;
+            for (const auto& value : recomputed) {
+                if (sameValue(value, operand)) invariant = false;
+            }
+        }
+        if (invariant) continue;
+        if (writesResult(instr)) recomputed.push_back(instr.result);
+        rewritten.push_back(instr);
+    }
+    IRInstruction latch(IROpCode::JNZ);
+    latch.operands = code[loop.exitTest].operands;
+    latch.label = loop.headerLabel;
+    rewritten.push_back(latch);
+
+    rewritten.insert(rewritten.end(), code.begin() + loop.latch + 1, code.end());
+    code = rewritten;
+    return true;
+}
@@ -60,11 +60,24 @@ ProgramPtr Parser::parse() {
     while (!check(TokenType::END_OF_FILE)) {
         while (check(TokenType::NEWLINE)) advance();
         if (check(TokenType::END_OF_FILE)) break;
-        program->functions.push_back(parseFunction());
+        if (check(TokenType::IMPORT)) {
+            program->imports.push_back(parseImport());
+        } else {
+            program->functions.push_back(parseFunction());
+        }
     }
     return program;
 }
 
+std::string Parser::parseImport() {
+    consume(TokenType::IMPORT, "Expected 'import'");
+    if (!check(TokenType::STRING)) throw std::runtime_error("Expected module path after 'import'");
+    std::string path = currentToken().value;
+    advance();
+    consume(TokenType::SEMICOLON, "Expected ';' after import");
+    return path;
+}
+
 FunctionDeclPtr Parser::parseFunction() {
     std::string returnType = "void";
     // Handle optional return type. Disambiguate IDENTIFIER: if the current token
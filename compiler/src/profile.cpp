@@ -0,0 +1,81 @@
+#include "profile.h"
+#include <fstream>
+#include <sstream>
+#include <stdexcept>
+
+uint64_t hashText(const std::string& text) {
+    uint64_t hash = 14695981039346656037ULL;
+    for (unsigned char c : text) {
+        hash ^= c;
+        hash *= 1099511628211ULL;
+    }
+    return hash;
+}
+
+void Profile::recordBranch(uint64_t site, bool condition) {
+    auto& entry = counts[site];
+    entry.executed++;
+    if (condition) entry.trueCount++;
+}
+
+void Profile::recordCall(uint64_t site) {
+    counts[site].executed++;
+}
+
+void Profile::recordTypes(uint64_t site, uint32_t types) {
+    auto& entry = counts[site];
+    entry.executed++;
+    entry.types |= types;
+}
+
+const ProfileCounts* Profile::find(uint64_t site) const {
+    auto it = counts.find(site);
+    return it == counts.end() ? nullptr : &it->second;
+}
+
+void Profile::save(const std::string& path, uint64_t sourceHash) const {
+    std::ofstream out(path);
+    if (!out) {
+        throw std::runtime_error("Could not write profile: " + path);
+    }
+    out << "zpp-profile 1\n";
+    out << "source " << std::hex << sourceHash << std::dec << "\n";
+    for (const auto& entry : counts) {
+        out << std::hex << entry.first << std::dec << " " << entry.second.executed << " "
+            << entry.second.trueCount << " " << entry.second.types << "\n";
+    }
+}
+
+Profile Profile::load(const std::string& path, uint64_t sourceHash) {
+    std::ifstream in(path);
+    if (!in) {
+        throw std::runtime_error("Could not open profile: " + path);
+    }
+
+    std::string magic, keyword;
+    int version = 0;
+    uint64_t recordedHash = 0;
+    in >> magic >> version >> keyword >> std::hex >> recordedHash >> std::dec;
+    if (!in || magic != "zpp-profile" || version != 1 || keyword != "source") {
+        throw std::runtime_error("Malformed profile: " + path);
+    }
+    if (recordedHash != sourceHash) {
+        throw std::runtime_error("Profile was recorded from different source: " + path);
+    }
+
+    Profile profile;
+    std::string line;
+    std::getline(in, line);
+    while (std::getline(in, line)) {
+        if (line.empty()) continue;
+        std::istringstream fields(line);
+        uint64_t site = 0;
+        ProfileCounts entry;
+        fields >> std::hex >> site >> std::dec >> entry.executed >> entry.trueCount >> entry.types;
+        if (!fields) {
+            throw std::runtime_error("Malformed profile record: " + line);
+        }
+        profile.counts[site] = entry;
+    }
+    return profile;
+}
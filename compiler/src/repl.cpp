@@ -0,0 +1,152 @@
+#include "repl.h"
+#include "builtins.h"
+#include "lexer.h"
+#include "parser.h"
+#include <stdexcept>
+
+namespace {
+
+// Name of the function each entry's statements are compiled into; no identifier the lexer reads can clash
+const char* const kEntryFunction = "<entry>";
+
+bool isOpening(TokenType type) {
+    return type == TokenType::LPAREN || type == TokenType::LBRACE || type == TokenType::LBRACKET;
+}
+
+bool isClosing(TokenType type) {
+    return type == TokenType::RPAREN || type == TokenType::RBRACE || type == TokenType::RBRACKET;
+}
+
+// closing: Index of the bracket that closes the one at open, or tokens.size() if it is never closed
+size_t closing(const std::vector<Token>& tokens, size_t open) {
+    int depth = 0;
+    for (size_t i = open; i < tokens.size(); ++i) {
+        if (isOpening(tokens[i].type)) depth++;
+        else if (isClosing(tokens[i].type) && --depth == 0) return i;
+    }
+    return tokens.size();
+}
+
+// functionEnd: One past the closing brace when a function declaration starts at i, otherwise i
+// Declarations look like [type] name(...) { ... }; no statement has a brace straight after a call.
+size_t functionEnd(const std::vector<Token>& tokens, size_t i) {
+    size_t name = i;
+    bool typed = tokens[i].type == TokenType::INT || tokens[i].type == TokenType::FLOAT_KW ||
+                 tokens[i].type == TokenType::BOOL || tokens[i].type == TokenType::VOID ||
+                 tokens[i].type == TokenType::IDENTIFIER;
+    if (typed && i + 1 < tokens.size() && tokens[i + 1].type == TokenType::IDENTIFIER) name = i + 1;
+    if (tokens[name].type != TokenType::IDENTIFIER || name + 1 >= tokens.size() ||
+        tokens[name + 1].type != TokenType::LPAREN) {
+        return i;
+    }
+    size_t params = closing(tokens, name + 1);
+    if (params + 1 >= tokens.size() || tokens[params + 1].type != TokenType::LBRACE) return i;
+    size_t body = closing(tokens, params + 1);
+    return body < tokens.size() ? body + 1 : i;
+}
+
+} // namespace
+
+ReplSession::ReplSession(const Engine& engine, std::istream& in, std::ostream& out, std::ostream& err)
+    : engine(engine), out(out), instance(engine.compileProgram(std::make_shared<Program>()), in, out, err) {}
+
+bool ReplSession::complete(const std::string& text) {
+    int depth = 0;
+    TokenType last = TokenType::SEMICOLON;
+    for (const Token& token : Lexer(text).tokenize()) {
+        if (token.type == TokenType::NEWLINE || token.type == TokenType::END_OF_FILE) continue;
+        if (isOpening(token.type)) depth++;
+        if (isClosing(token.type)) depth--;
+        last = token.type;
+    }
+    return depth <= 0 && (last == TokenType::SEMICOLON || last == TokenType::RBRACE);
+}
+
+void ReplSession::submit(const std::string& source) {
+    // Function declarations are kept as written; everything else becomes the body of the entry function
+    std::vector<Token> tokens = Lexer(source).tokenize();
+    std::vector<Token> program;
+    std::vector<Token> body;
+    int depth = 0;
+    for (size_t i = 0; i < tokens.size() && tokens[i].type != TokenType::END_OF_FILE;) {
+        size_t end = depth == 0 ? functionEnd(tokens, i) : i;
+        if (end > i) {
+            program.insert(program.end(), tokens.begin() + i, tokens.begin() + end);
+            i = end;
+            continue;
+        }
+        if (tokens[i].type == TokenType::IMPORT) {
+            throw std::runtime_error("import is only available in script files");
+        }
+        if (isOpening(tokens[i].type)) depth++;
+        if (isClosing(tokens[i].type)) depth--;
+        body.push_back(tokens[i++]);
+    }
+    int line = tokens.empty() ? 1 : tokens.back().line;
+    program.emplace_back(TokenType::VOID, "void", line, 1);
+    program.emplace_back(TokenType::IDENTIFIER, kEntryFunction, line, 1);
+    program.emplace_back(TokenType::LPAREN, "(", line, 1);
+    program.emplace_back(TokenType::RPAREN, ")", line, 1);
+    program.emplace_back(TokenType::LBRACE, "{", line, 1);
+    program.insert(program.end(), body.begin(), body.end());
+    program.emplace_back(TokenType::RBRACE, "}", line, 1);
+    program.emplace_back(TokenType::END_OF_FILE, "", line, 1);
+
+    Parser parser(program);
+    ProgramPtr ast = parser.parse();
+    FunctionDeclPtr entry = ast->functions.back();
+
+    // A trailing expression with a value is returned, so it can be shown
+    bool echo = false;
+    auto block = std::static_pointer_cast<BlockStatement>(entry->body);
+    if (!block->statements.empty()) {
+        auto last = std::dynamic_pointer_cast<ExpressionStatement>(block->statements.back());
+        ExpressionPtr expr = last ? last->expression : nullptr;
+        echo = expr && !std::dynamic_pointer_cast<Assignment>(expr) &&
+               !std::dynamic_pointer_cast<ArrayElementAssignment>(expr);
+        if (auto call = std::dynamic_pointer_cast<FunctionCall>(expr)) {
+            const Builtin* builtin = findBuiltin(call->name);
+            auto declared = returnTypes.find(call->name);
+            std::string type = builtin ? builtin->returnType : declared != returnTypes.end() ? declared->second : "void";
+            echo = type != "void";
+        }
+        if (echo) {
+            block->statements.back() = std::make_shared<ReturnStatement>(expr);
+            entry->returnType = "any";
+        }
+    }
+
+    // Not inlined: any function may be redefined by a later entry, and its callers must see that
+    ModulePtr module = engine.compileProgram(ast, false);
+    instance.load(module);
+    for (const auto& func : ast->functions) {
+        if (func != entry) returnTypes[func->name] = func->returnType;
+    }
+
+    Value result = instance.callInScope(kEntryFunction, scope);
+    if (echo && !instance.halted()) {
+        writeValue(out, result);
+        out << std::endl;
+    }
+}
+
+void runRepl(const Engine& engine, std::istream& in, std::ostream& out, std::ostream& err) {
+    ReplSession session(engine, in, out, err);
+    std::string entry;
+    std::string line;
+    while (!session.halted()) {
+        out << (entry.empty() ? "zpp> " : "...> ") << std::flush;
+        if (!std::getline(in, line)) break;
+        if (entry.empty() && line == ":quit") break;
+        if (entry.empty() && line.find_first_not_of(" \t") == std::string::npos) continue;
+        entry += line + "\n";
+        if (!ReplSession::complete(entry)) continue;
+        try {
+            session.submit(entry);
+        } catch (const std::exception& e) {
+            err << "Error: " << e.what() << std::endl;
+        }
+        entry.clear();
+    }
+    out << std::endl;
+}
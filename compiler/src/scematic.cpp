@@ -1,8 +1,7 @@
 #include "scematic.h"
+#include "builtins.h"
 #include <iostream>
 
-bool SemanticAnalyzer::errors = false;
-
 // Scope implementation
 void Scope::declare(const std::string& name, const Symbol& symbol) {
     if (symbols.find(name) != symbols.end()) {
@@ -35,7 +34,7 @@ Symbol* Scope::lookupLocal(const std::string& name) {
 // SemanticAnalyzer implementation
 SemanticAnalyzer::SemanticAnalyzer(const ProgramPtr& ast)
     : ast(ast), currentScope(nullptr), globalScope(nullptr), 
-      currentFunctionReturnType("void") {}
+      currentFunctionReturnType("void"), errors(false) {}
 
 void SemanticAnalyzer::analyze() {
     globalScope = new Scope();
@@ -83,8 +82,14 @@ void SemanticAnalyzer::analyzeFunction(const FunctionDeclPtr& func) {
         }
     }
     
-    // Analyze function body
-    analyzeStatement(func->body);
+    // Analyze function body; its outermost block shares the parameters' scope
+    if (auto body = std::dynamic_pointer_cast<BlockStatement>(func->body)) {
+        for (const auto& stmt : body->statements) {
+            analyzeStatement(stmt);
+        }
+    } else {
+        analyzeStatement(func->body);
+    }
     
     exitScope();
 }
@@ -112,9 +117,12 @@ void SemanticAnalyzer::analyzeStatement(const StatementPtr& stmt) {
 void SemanticAnalyzer::analyzeBlockStatement(const std::shared_ptr<BlockStatement>& block) {
     if (!block) return;
     
+    // Variables declared in a block go out of scope at its closing brace
+    enterScope();
     for (const auto& stmt : block->statements) {
         analyzeStatement(stmt);
     }
+    exitScope();
 }
 
 void SemanticAnalyzer::analyzeReturnStatement(const std::shared_ptr<ReturnStatement>& ret) {
@@ -322,18 +330,26 @@ std::string SemanticAnalyzer::analyzeIdentifier(const std::shared_ptr<Identifier
 std::string SemanticAnalyzer::analyzeFunctionCall(const std::shared_ptr<FunctionCall>& call) {
     if (!call) return "void";
 
-    if (call->name == "len") {
-        if (call->arguments.size() != 1) {
-            reportError("len expects exactly one argument");
-            return "int";
+    // Builtins are checked against their registry signature
+    if (const Builtin* builtin = findBuiltin(call->name)) {
+        const auto& parameters = builtin->parameterTypes;
+        if (call->arguments.size() != parameters.size()) {
+            reportError(call->name + " expects " + std::to_string(parameters.size()) + " argument(s), got " +
+                        std::to_string(call->arguments.size()));
+            return builtin->returnType;
         }
 
-        std::string argType = analyzeExpression(call->arguments[0]);
-        if (argType.rfind("array<", 0) != 0) {
-            reportError("len can only be used on arrays, got " + argType);
+        for (size_t i = 0; i < parameters.size(); ++i) {
+            std::string argType = analyzeExpression(call->arguments[i]);
+            bool accepted = parameters[i] == "array" ? argType.rfind("array<", 0) == 0
+                                                     : isCompatibleType(argType, parameters[i]);
+            if (!accepted) {
+                reportError(call->name + " argument " + std::to_string(i + 1) + " expects " + parameters[i] +
+                            ", got " + argType);
+            }
         }
 
-        return "int";
+        return builtin->returnType;
     }
     
     Symbol* symbol = currentScope->lookup(call->name);
@@ -442,7 +458,7 @@ void SemanticAnalyzer::reportError(const std::string& message) {
     errors = true;
 }
 
-bool SemanticAnalyzer::hasErrors() {
+bool SemanticAnalyzer::hasErrors() const {
     return errors;
 }
 
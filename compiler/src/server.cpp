@@ -0,0 +1,416 @@
+#include "server.h"
+#include <algorithm>
+#include <cerrno>
+#include <chrono>
+#include <csignal>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <stdexcept>
+#include <vector>
+#include <fcntl.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+// Wire format, client to server: a uint32 payload size sent together with the client's stdin,
+// stdout and stderr as SCM_RIGHTS, then the payload: cwd and each argument, NUL-terminated.
+// Server to client: the int32 exit status once the job has finished.
+
+namespace {
+
+int childSignal[2] = {-1, -1};  // Self-pipe: SIGCHLD wakes the accept loop
+
+void onChild(int) {
+    int saved = errno;
+    char byte = 0;
+    (void)!write(childSignal[1], &byte, 1);
+    errno = saved;
+}
+
+sockaddr_un socketAddress(const std::string& path) {
+    sockaddr_un address;
+    std::memset(&address, 0, sizeof(address));
+    address.sun_family = AF_UNIX;
+    if (path.size() >= sizeof(address.sun_path)) {
+        throw std::runtime_error("Socket path is too long: " + path);
+    }
+    std::memcpy(address.sun_path, path.c_str(), path.size() + 1);
+    return address;
+}
+
+// connectTo(): Connected socket, or -1 if nothing listens at the path
+int connectTo(const std::string& path) {
+    sockaddr_un address = socketAddress(path);
+    int fd = socket(AF_UNIX, SOCK_STREAM, 0);
+    if (fd < 0) return -1;
+    if (connect(fd, reinterpret_cast<sockaddr*>(&address), sizeof(address)) != 0) {
+        close(fd);
+        return -1;
+    }
+    return fd;
+}
+
+bool writeAll(int fd, const void* data, size_t size) {
+    const char* p = static_cast<const char*>(data);
+    while (size > 0) {
+        ssize_t n = write(fd, p, size);
+        if (n < 0 && errno == EINTR) continue;
+        if (n <= 0) return false;
+        p += n;
+        size -= static_cast<size_t>(n);
+    }
+    return true;
+}
+
+bool readAll(int fd, void* data, size_t size) {
+    char* p = static_cast<char*>(data);
+    while (size > 0) {
+        ssize_t n = read(fd, p, size);
+        if (n < 0 && errno == EINTR) continue;
+        if (n <= 0) return false;
+        p += n;
+        size -= static_cast<size_t>(n);
+    }
+    return true;
+}
+
+// Connection: A client whose request is still arriving
+// The socket is non-blocking and read whenever poll finds it readable, so a client that connects and
+// stalls holds up nobody else. One that hasn't sent its whole request by its deadline is dropped.
+class Connection {
+public:
+    enum Progress { kWaiting, kReady, kFailed };
+
+    static constexpr std::chrono::seconds kRequestTimeout{10};
+
+    explicit Connection(int client)
+        : client(client), deadline(std::chrono::steady_clock::now() + kRequestTimeout) {
+        fcntl(client, F_SETFL, fcntl(client, F_GETFL) | O_NONBLOCK);
+    }
+
+    int socket() const { return client; }
+    std::chrono::steady_clock::time_point expires() const { return deadline; }
+    const ServerRequest& request() const { return received; }
+
+    // read(): Take whatever has arrived; kFailed if the client sent something malformed or hung up
+    // Once kReady, request() holds the command and the client's streams, and the socket blocks again.
+    Progress read() {
+        if (!hasStreams) {
+            Progress header = readHeader();
+            if (header != kReady) return header;
+        }
+        while (filled < payload.size()) {
+            ssize_t n = ::read(client, &payload[filled], payload.size() - filled);
+            if (n < 0 && errno == EINTR) continue;
+            if (n < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) return kWaiting;
+            if (n <= 0) return kFailed;
+            filled += static_cast<size_t>(n);
+        }
+        if (payload.empty() || payload.back() != '\0') return kFailed;
+
+        size_t start = 0;
+        for (size_t end = payload.find('\0'); end != std::string::npos; end = payload.find('\0', start)) {
+            std::string field = payload.substr(start, end - start);
+            if (start == 0) {
+                received.cwd = field;
+            } else {
+                received.args.push_back(field);
+            }
+            start = end + 1;
+        }
+        fcntl(client, F_SETFL, fcntl(client, F_GETFL) & ~O_NONBLOCK);
+        return kReady;
+    }
+
+    // closeStreams(): Close the client's stdin, stdout and stderr, if they have arrived
+    void closeStreams() {
+        if (!hasStreams) return;
+        close(received.input);
+        close(received.output);
+        close(received.error);
+        hasStreams = false;
+    }
+
+    // drop(): Close everything the connection holds
+    void drop() {
+        closeStreams();
+        close(client);
+    }
+
+private:
+    static const uint32_t kMaxPayload = 1 << 20;
+
+    int client;
+    std::chrono::steady_clock::time_point deadline;
+    ServerRequest received;
+    bool hasStreams = false;
+    std::string payload;
+    size_t filled = 0;
+
+    // readHeader(): The payload size, which arrives in one message along with the three streams
+    Progress readHeader() {
+        uint32_t size = 0;
+        char control[CMSG_SPACE(3 * sizeof(int))];
+        iovec io{&size, sizeof(size)};
+        msghdr message;
+        std::memset(&message, 0, sizeof(message));
+        message.msg_iov = &io;
+        message.msg_iovlen = 1;
+        message.msg_control = control;
+        message.msg_controllen = sizeof(control);
+
+        ssize_t n;
+        do {
+            n = recvmsg(client, &message, 0);
+        } while (n < 0 && errno == EINTR);
+        if (n < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) return kWaiting;
+        if (n <= 0) return kFailed;
+
+        // Whatever descriptors came are closed unless they are exactly the three expected
+        std::vector<int> fds;
+        for (cmsghdr* header = CMSG_FIRSTHDR(&message); header; header = CMSG_NXTHDR(&message, header)) {
+            if (header->cmsg_level != SOL_SOCKET || header->cmsg_type != SCM_RIGHTS) continue;
+            size_t count = (header->cmsg_len - CMSG_LEN(0)) / sizeof(int);
+            for (size_t i = 0; i < count; ++i) {
+                int fd;
+                std::memcpy(&fd, CMSG_DATA(header) + i * sizeof(int), sizeof(fd));
+                fds.push_back(fd);
+            }
+        }
+        if (n != static_cast<ssize_t>(sizeof(size)) || fds.size() != 3 || (message.msg_flags & MSG_CTRUNC) ||
+            size > kMaxPayload) {
+            for (int fd : fds) close(fd);
+            return kFailed;
+        }
+        received.input = fds[0];
+        received.output = fds[1];
+        received.error = fds[2];
+        hasStreams = true;
+        payload.assign(size, '\0');
+        return kReady;
+    }
+};
+
+constexpr std::chrono::seconds Connection::kRequestTimeout;
+
+int exitStatus(int status) {
+    if (WIFEXITED(status)) return WEXITSTATUS(status);
+    if (WIFSIGNALED(status)) return 128 + WTERMSIG(status);
+    return 1;
+}
+
+} // namespace
+
+std::string defaultSocketPath() {
+    const char* explicitPath = std::getenv("ZPP_SOCKET");
+    if (explicitPath && *explicitPath) return explicitPath;
+    const char* runtime = std::getenv("XDG_RUNTIME_DIR");
+    if (runtime && *runtime) return std::string(runtime) + "/zpp.sock";
+    return "/tmp/zpp-" + std::to_string(getuid()) + ".sock";
+}
+
+void serve(const std::string& socketPath, const RequestHandler& handler) {
+    int existing = connectTo(socketPath);
+    if (existing >= 0) {
+        close(existing);
+        throw std::runtime_error("A server is already listening on " + socketPath);
+    }
+    unlink(socketPath.c_str());  // Left behind by a server that did not shut down cleanly
+
+    sockaddr_un address = socketAddress(socketPath);
+    int listener = socket(AF_UNIX, SOCK_STREAM, 0);
+    if (listener < 0 || bind(listener, reinterpret_cast<sockaddr*>(&address), sizeof(address)) != 0 ||
+        listen(listener, 64) != 0) {
+        throw std::runtime_error("Could not listen on " + socketPath + ": " + std::strerror(errno));
+    }
+
+    if (pipe(childSignal) != 0) {
+        throw std::runtime_error(std::string("Could not create pipe: ") + std::strerror(errno));
+    }
+    fcntl(childSignal[0], F_SETFL, O_NONBLOCK);
+    fcntl(childSignal[1], F_SETFL, O_NONBLOCK);
+    struct sigaction action;
+    std::memset(&action, 0, sizeof(action));
+    action.sa_handler = onChild;
+    action.sa_flags = SA_RESTART | SA_NOCLDSTOP;
+    sigaction(SIGCHLD, &action, nullptr);
+    signal(SIGPIPE, SIG_IGN);  // A vanished client must not take the server down
+
+    // Job: A forked child running one request, and the client waiting for its status
+    struct Job {
+        pid_t pid;
+        int client;
+        bool cancelled;  // Client hung up and the child was sent SIGTERM
+    };
+    std::vector<Job> jobs;
+    std::vector<Connection> connections;  // Accepted, with the request still arriving
+
+    while (true) {
+        std::vector<pollfd> watched = {{listener, POLLIN, 0}, {childSignal[0], POLLIN, 0}};
+        for (const auto& job : jobs) {
+            if (!job.cancelled) watched.push_back({job.client, POLLIN, 0});
+        }
+        size_t firstConnection = watched.size();
+        int timeout = -1;
+        auto now = std::chrono::steady_clock::now();
+        for (const auto& connection : connections) {
+            watched.push_back({connection.socket(), POLLIN, 0});
+            auto left = std::chrono::duration_cast<std::chrono::milliseconds>(connection.expires() - now).count();
+            int wait = static_cast<int>(std::max<long long>(left, 0)) + 1;
+            if (timeout < 0 || wait < timeout) timeout = wait;
+        }
+        if (poll(watched.data(), watched.size(), timeout) < 0) {
+            if (errno == EINTR) continue;
+            throw std::runtime_error(std::string("poll failed: ") + std::strerror(errno));
+        }
+
+        // Finished jobs: report the status and hang up
+        if (watched[1].revents) {
+            char drain[64];
+            while (read(childSignal[0], drain, sizeof(drain)) > 0) {}
+            int status;
+            pid_t pid;
+            while ((pid = waitpid(-1, &status, WNOHANG)) > 0) {
+                for (size_t j = 0; j < jobs.size(); ++j) {
+                    if (jobs[j].pid != pid) continue;
+                    int32_t code = exitStatus(status);
+                    writeAll(jobs[j].client, &code, sizeof(code));
+                    close(jobs[j].client);
+                    jobs.erase(jobs.begin() + static_cast<long>(j));
+                    break;
+                }
+            }
+        }
+
+        // Clients only send once, so anything readable afterwards is a hang-up: stop their job
+        for (size_t w = 2; w < firstConnection; ++w) {
+            if (!watched[w].revents) continue;
+            for (auto& job : jobs) {
+                if (job.client != watched[w].fd) continue;
+                kill(job.pid, SIGTERM);
+                job.cancelled = true;
+            }
+        }
+
+        // Read the requests that have arrived; those still incomplete past their deadline are dropped
+        std::vector<Connection> arrived;
+        std::vector<Connection> waiting;
+        now = std::chrono::steady_clock::now();
+        for (size_t c = 0; c < connections.size(); ++c) {
+            Connection& connection = connections[c];
+            Connection::Progress progress = Connection::kWaiting;
+            if (watched[firstConnection + c].revents) progress = connection.read();
+            if (progress == Connection::kWaiting && now >= connection.expires()) progress = Connection::kFailed;
+            if (progress == Connection::kReady) {
+                arrived.push_back(connection);
+            } else if (progress == Connection::kWaiting) {
+                waiting.push_back(connection);
+            } else {
+                connection.drop();
+            }
+        }
+        connections = waiting;
+
+        if (watched[0].revents & POLLIN) {
+            int client = accept(listener, nullptr, nullptr);
+            if (client >= 0) connections.emplace_back(client);
+        }
+
+        for (size_t r = 0; r < arrived.size(); ++r) {
+            const ServerRequest& request = arrived[r].request();
+            int client = arrived[r].socket();
+            std::function<int()> work;
+            try {
+                work = handler(request);
+            } catch (const std::exception& e) {
+                std::string message = e.what();
+                work = [message]() {
+                    std::cerr << "Error: " << message << std::endl;
+                    return 1;
+                };
+            }
+
+            std::cout.flush();
+            std::cerr.flush();
+            pid_t pid = fork();
+            if (pid == 0) {
+                signal(SIGCHLD, SIG_DFL);
+                signal(SIGPIPE, SIG_DFL);
+                close(listener);
+                close(childSignal[0]);
+                close(childSignal[1]);
+                for (const auto& job : jobs) close(job.client);
+                for (auto& connection : connections) connection.drop();
+                for (size_t other = r + 1; other < arrived.size(); ++other) arrived[other].drop();
+                close(client);
+                dup2(request.input, STDIN_FILENO);
+                dup2(request.output, STDOUT_FILENO);
+                dup2(request.error, STDERR_FILENO);
+                close(request.input);
+                close(request.output);
+                close(request.error);
+                int status = 1;
+                if (chdir(request.cwd.c_str()) != 0) {
+                    std::cerr << "Error: Could not enter " << request.cwd << std::endl;
+                } else {
+                    status = work();
+                }
+                std::cout.flush();
+                std::cerr.flush();
+                _exit(status);
+            }
+            arrived[r].closeStreams();
+            if (pid < 0) {
+                int32_t code = 1;
+                writeAll(client, &code, sizeof(code));
+                close(client);
+                continue;
+            }
+            jobs.push_back({pid, client, false});
+        }
+    }
+}
+
+int forward(const std::string& socketPath, const std::vector<std::string>& args) {
+    int server = connectTo(socketPath);
+    if (server < 0) return -1;
+
+    char cwd[4096];
+    if (!getcwd(cwd, sizeof(cwd))) {
+        close(server);
+        throw std::runtime_error("Could not determine the working directory");
+    }
+    std::string payload = std::string(cwd) + '\0';
+    for (const auto& arg : args) payload += arg + '\0';
+
+    uint32_t size = static_cast<uint32_t>(payload.size());
+    int fds[3] = {STDIN_FILENO, STDOUT_FILENO, STDERR_FILENO};
+    char control[CMSG_SPACE(sizeof(fds))];
+    std::memset(control, 0, sizeof(control));
+    iovec io{&size, sizeof(size)};
+    msghdr message;
+    std::memset(&message, 0, sizeof(message));
+    message.msg_iov = &io;
+    message.msg_iovlen = 1;
+    message.msg_control = control;
+    message.msg_controllen = sizeof(control);
+    cmsghdr* header = CMSG_FIRSTHDR(&message);
+    header->cmsg_level = SOL_SOCKET;
+    header->cmsg_type = SCM_RIGHTS;
+    header->cmsg_len = CMSG_LEN(sizeof(fds));
+    std::memcpy(CMSG_DATA(header), fds, sizeof(fds));
+
+    int32_t status = 0;
+    bool sent = sendmsg(server, &message, 0) == static_cast<ssize_t>(sizeof(size)) &&
+                writeAll(server, payload.data(), payload.size());
+    bool answered = sent && readAll(server, &status, sizeof(status));
+    close(server);
+    if (!answered) {
+        throw std::runtime_error("Lost the connection to the server at " + socketPath);
+    }
+    return status;
+}
@@ -0,0 +1,327 @@
+#include "snapshot.h"
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <stdexcept>
+#include <unordered_map>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace fs = std::filesystem;
+
+namespace {
+
+// Bumped whenever the layout below changes
+const uint32_t kFormatVersion = 1;
+const char kMagic[4] = {'Z', 'P', 'P', 'S'};
+
+// Layout: header, array table, frames, then the data section holding array contents and string bytes.
+// Every value is a fixed-size Record. Strings point into the data section; arrays point to their entry
+// in the array table, so the graph is rebuilt by relocating indices to arrays rather than by walking
+// nested encodings, and aliasing and cycles survive.
+struct Header {
+    char magic[4];
+    uint32_t version;
+    uint64_t program;
+    uint32_t arrays;
+    uint32_t frames;
+    uint64_t dataSize;
+};
+
+enum Tag : uint8_t { kInt, kDouble, kString, kBool, kArray, kNoArray };
+
+struct Record {
+    uint8_t tag;
+    uint8_t padding[3];
+    uint32_t size;   // Bytes, for strings
+    uint64_t bits;   // The value, a data section offset for strings, or an array table index
+};
+
+// Arrays holding only ints, the usual lookup table, are stored as packed 32-bit values
+enum ArrayKind : uint32_t { kRecords, kInts };
+
+struct ArrayEntry {
+    uint32_t kind;
+    uint32_t count;
+    uint64_t offset;  // Into the data section
+};
+
+template <typename T>
+void put(std::string& out, const T& value) {
+    out.append(reinterpret_cast<const char*>(&value), sizeof(T));
+}
+
+void putString(std::string& out, const std::string& text) {
+    put(out, static_cast<uint32_t>(text.size()));
+    out.append(text);
+}
+
+// Encoder: Lays out a snapshot's values, numbering each array the first time it is reached
+class Encoder {
+public:
+    std::string data;
+    std::string table;
+
+    Record record(const Value& v) {
+        Record r = {};
+        if (const int* i = std::get_if<int>(&v)) {
+            r.tag = kInt;
+            r.bits = static_cast<uint64_t>(static_cast<int64_t>(*i));
+        } else if (const double* d = std::get_if<double>(&v)) {
+            r.tag = kDouble;
+            std::memcpy(&r.bits, d, sizeof(*d));
+        } else if (const bool* b = std::get_if<bool>(&v)) {
+            r.tag = kBool;
+            r.bits = *b;
+        } else if (const std::string* s = std::get_if<std::string>(&v)) {
+            r.tag = kString;
+            r.size = static_cast<uint32_t>(s->size());
+            r.bits = data.size();
+            data.append(*s);
+        } else if (const ArrayRef& array = std::get<ArrayRef>(v)) {
+            r.tag = kArray;
+            auto found = index.emplace(array.get(), static_cast<uint64_t>(arrays.size()));
+            if (found.second) arrays.push_back(array.get());
+            r.bits = found.first->second;
+        } else {
+            r.tag = kNoArray;
+        }
+        return r;
+    }
+
+    // encodeArrays(): Write every array reached so far, and the ones they reach in turn
+    void encodeArrays() {
+        for (size_t i = 0; i < arrays.size(); ++i) {
+            const std::vector<Value>& elements = arrays[i]->elements;
+            bool ints = true;
+            for (const auto& element : elements) ints = ints && std::holds_alternative<int>(element);
+            ArrayEntry entry = {ints ? kInts : kRecords, static_cast<uint32_t>(elements.size()), 0};
+            if (ints) {
+                entry.offset = data.size();
+                for (const auto& element : elements) put(data, static_cast<int32_t>(std::get<int>(element)));
+            } else {
+                // Strings inside go to the data section first, so the records are laid out separately
+                std::string records;
+                for (const auto& element : elements) put(records, record(element));
+                entry.offset = data.size();
+                data += records;
+            }
+            put(table, entry);
+        }
+    }
+
+    uint32_t arrayCount() const { return static_cast<uint32_t>(arrays.size()); }
+
+private:
+    std::vector<const ArrayValue*> arrays;
+    std::unordered_map<const ArrayValue*, uint64_t> index;
+};
+
+// Cursor: Bounds-checked reads from a mapped snapshot
+class Cursor {
+public:
+    Cursor(const char* data, size_t size) : data(data), size(size), pos(0) {}
+
+    template <typename T>
+    T get() {
+        T value;
+        std::memcpy(&value, take(sizeof(T)), sizeof(T));
+        return value;
+    }
+    std::string str() {
+        uint32_t n = get<uint32_t>();
+        return std::string(take(n), n);
+    }
+    // take(): The next n bytes, in place
+    const char* take(size_t n) {
+        if (n > size - pos) throw std::runtime_error("Truncated snapshot");
+        const char* at = data + pos;
+        pos += n;
+        return at;
+    }
+    size_t remaining() const { return size - pos; }
+
+private:
+    const char* data;
+    size_t size;
+    size_t pos;
+};
+
+// Decoder: Rebuilds values once every array in the table exists, so references can point anywhere
+class Decoder {
+public:
+    Decoder(const char* data, uint64_t size, std::vector<ArrayRef> arrays)
+        : data(data), size(size), arrays(std::move(arrays)) {}
+
+    Value value(const Record& r) const {
+        switch (r.tag) {
+            case kInt: return static_cast<int>(static_cast<int64_t>(r.bits));
+            case kDouble: {
+                double d;
+                std::memcpy(&d, &r.bits, sizeof(d));
+                return d;
+            }
+            case kBool: return r.bits != 0;
+            case kString: return std::string(bytes(r.bits, r.size), r.size);
+            case kArray:
+                if (r.bits >= arrays.size()) throw std::runtime_error("Bad array reference in snapshot");
+                return arrays[r.bits];
+            case kNoArray: return ArrayRef();
+        }
+        throw std::runtime_error("Bad value in snapshot");
+    }
+
+    void fill(const ArrayEntry& entry, ArrayValue& array) const {
+        size_t width = entry.kind == kInts ? sizeof(int32_t) : sizeof(Record);
+        const char* at = bytes(entry.offset, static_cast<uint64_t>(entry.count) * width);
+        for (uint32_t i = 0; i < entry.count; ++i, at += width) {
+            if (entry.kind == kInts) {
+                int32_t v;
+                std::memcpy(&v, at, sizeof(v));
+                array.elements.emplace_back(static_cast<int>(v));
+            } else {
+                Record r;
+                std::memcpy(&r, at, sizeof(r));
+                array.elements.push_back(value(r));
+            }
+        }
+    }
+
+    const std::vector<ArrayRef>& all() const { return arrays; }
+
+private:
+    const char* data;
+    uint64_t size;
+    std::vector<ArrayRef> arrays;
+
+    const char* bytes(uint64_t offset, uint64_t n) const {
+        if (offset > size || n > size - offset) throw std::runtime_error("Truncated snapshot");
+        return data + offset;
+    }
+};
+
+// decode: Parse a mapped snapshot; false if it belongs to another program or format version
+bool decode(const char* mapped, size_t length, uint64_t program, ArrayHeap& heap, Snapshot& snapshot) {
+    Cursor in(mapped, length);
+    Header header = in.get<Header>();
+    if (std::memcmp(header.magic, kMagic, sizeof(kMagic)) != 0 || header.version != kFormatVersion ||
+        header.program != program || header.dataSize > length) {
+        return false;
+    }
+    const char* data = mapped + length - header.dataSize;
+
+    Cursor table(in.take(static_cast<size_t>(header.arrays) * sizeof(ArrayEntry)),
+                 static_cast<size_t>(header.arrays) * sizeof(ArrayEntry));
+    std::vector<ArrayEntry> entries(header.arrays);
+    std::vector<ArrayRef> arrays;
+    arrays.reserve(header.arrays);
+    for (auto& entry : entries) {
+        entry = table.get<ArrayEntry>();
+        size_t width = entry.kind == kInts ? sizeof(int32_t) : sizeof(Record);
+        if ((entry.kind != kRecords && entry.kind != kInts) || entry.count > header.dataSize / width) {
+            throw std::runtime_error("Bad array in snapshot");
+        }
+        arrays.push_back(heap.allocate(entry.count));
+    }
+    Decoder decoder(data, header.dataSize, std::move(arrays));
+    for (size_t i = 0; i < entries.size(); ++i) {
+        decoder.fill(entries[i], *decoder.all()[i]);
+    }
+
+    snapshot.program = header.program;
+    snapshot.frames.resize(header.frames);
+    for (auto& frame : snapshot.frames) {
+        frame.function = in.str();
+        frame.ip = in.get<uint64_t>();
+        frame.resultSlot.type = static_cast<IRValue::Type>(in.get<uint8_t>());
+        frame.resultSlot.name = in.str();
+        frame.resultSlot.id = in.get<int32_t>();
+        frame.registers.resize(in.get<uint32_t>());
+        for (auto& reg : frame.registers) reg = decoder.value(in.get<Record>());
+        for (uint32_t n = in.get<uint32_t>(); n > 0; --n) {
+            std::string name = in.str();
+            frame.locals[name] = decoder.value(in.get<Record>());
+        }
+    }
+    if (in.remaining() != header.dataSize) throw std::runtime_error("Malformed snapshot");
+    return true;
+}
+
+} // namespace
+
+void saveSnapshot(const std::string& path, const Snapshot& snapshot) {
+    Encoder encoder;
+    std::string frames;
+    for (const auto& frame : snapshot.frames) {
+        putString(frames, frame.function);
+        put(frames, frame.ip);
+        put(frames, static_cast<uint8_t>(frame.resultSlot.type));
+        putString(frames, frame.resultSlot.name);
+        put(frames, static_cast<int32_t>(frame.resultSlot.id));
+        put(frames, static_cast<uint32_t>(frame.registers.size()));
+        for (const auto& reg : frame.registers) put(frames, encoder.record(reg));
+        put(frames, static_cast<uint32_t>(frame.locals.size()));
+        for (const auto& local : frame.locals) {
+            putString(frames, local.first);
+            put(frames, encoder.record(local.second));
+        }
+    }
+    encoder.encodeArrays();
+
+    Header header = {};
+    std::memcpy(header.magic, kMagic, sizeof(kMagic));
+    header.version = kFormatVersion;
+    header.program = snapshot.program;
+    header.arrays = encoder.arrayCount();
+    header.frames = static_cast<uint32_t>(snapshot.frames.size());
+    header.dataSize = encoder.data.size();
+
+    std::string temp = path + ".tmp." + std::to_string(getpid());
+    {
+        std::ofstream out(temp, std::ios::binary);
+        out.write(reinterpret_cast<const char*>(&header), sizeof(header));
+        out << encoder.table << frames << encoder.data;
+        if (!out) {
+            out.close();
+            std::error_code ec;
+            fs::remove(temp, ec);
+            throw std::runtime_error("Could not write snapshot " + path);
+        }
+    }
+    std::error_code ec;
+    fs::rename(temp, path, ec);
+    if (ec) {
+        fs::remove(temp, ec);
+        throw std::runtime_error("Could not write snapshot " + path);
+    }
+}
+
+bool loadSnapshot(const std::string& path, uint64_t program, ArrayHeap& heap, Snapshot& snapshot) {
+    int fd = ::open(path.c_str(), O_RDONLY);
+    if (fd < 0) return false;
+
+    struct stat info;
+    if (fstat(fd, &info) != 0 || info.st_size < static_cast<off_t>(sizeof(Header))) {
+        ::close(fd);
+        return false;
+    }
+    size_t size = static_cast<size_t>(info.st_size);
+    void* mapped = mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+    ::close(fd);
+    if (mapped == MAP_FAILED) return false;
+
+    bool loaded = false;
+    try {
+        Snapshot result;
+        if (decode(static_cast<const char*>(mapped), size, program, heap, result)) {
+            snapshot = std::move(result);
+            loaded = true;
+        }
+    } catch (const std::exception&) {
+        // Damaged snapshot: the caller starts from the beginning instead
+    }
+    munmap(mapped, size);
+    return loaded;
+}
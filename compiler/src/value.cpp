@@ -0,0 +1,94 @@
+#include "value.h"
+#include <stdexcept>
+
+int valueToInt(const Value& v) {
+    if (std::holds_alternative<int>(v)) return std::get<int>(v);
+    if (std::holds_alternative<double>(v)) return static_cast<int>(std::get<double>(v));
+    if (std::holds_alternative<std::string>(v)) return std::stoi(std::get<std::string>(v));
+    if (std::holds_alternative<bool>(v)) return std::get<bool>(v) ? 1 : 0;
+    throw std::runtime_error("Cannot convert value to int");
+}
+
+// valueToBool: Truth value used by conditional jumps and logical operators
+bool valueToBool(const Value& v) {
+    if (std::holds_alternative<int>(v)) return std::get<int>(v) != 0;
+    if (std::holds_alternative<double>(v)) return std::get<double>(v) != 0.0;
+    if (std::holds_alternative<bool>(v)) return std::get<bool>(v);
+    if (std::holds_alternative<std::string>(v)) return !std::get<std::string>(v).empty();
+    return static_cast<bool>(std::get<ArrayRef>(v));
+}
+
+// valueToString: Textual form used by CONCAT
+std::string valueToString(const Value& v) {
+    if (std::holds_alternative<int>(v)) return std::to_string(std::get<int>(v));
+    if (std::holds_alternative<double>(v)) return std::to_string(std::get<double>(v));
+    if (std::holds_alternative<bool>(v)) return std::get<bool>(v) ? "true" : "false";
+    if (std::holds_alternative<std::string>(v)) return std::get<std::string>(v);
+    const auto& arr = std::get<ArrayRef>(v);
+    return "[array size=" + std::to_string(arr ? arr->elements.size() : 0) + "]";
+}
+
+void appendValue(std::string& out, const Value& v) {
+    if (const auto* s = std::get_if<std::string>(&v)) out += *s;
+    else out += valueToString(v);
+}
+
+void writeValue(std::ostream& out, const Value& v) {
+    if (std::holds_alternative<int>(v)) out << std::get<int>(v);
+    else if (std::holds_alternative<double>(v)) out << std::get<double>(v);
+    else if (std::holds_alternative<bool>(v)) out << (std::get<bool>(v) ? "true" : "false");
+    else if (std::holds_alternative<std::string>(v)) out << std::get<std::string>(v);
+    else {
+        const auto& arr = std::get<ArrayRef>(v);
+        out << "[array size=" << (arr ? arr->elements.size() : 0) << "]";
+    }
+}
+
+ArrayRef makeArray(std::vector<Value> elements) {
+    ArrayRef array(new ArrayValue());
+    array->elements = std::move(elements);
+    return array;
+}
+
+ArrayRef ArrayHeap::allocate(size_t size) {
+    ArrayValue* array;
+    counters.arrays++;
+    if (!pool.empty()) {
+        array = pool.back();
+        pool.pop_back();
+        counters.arraysReused++;
+    } else {
+        array = new ArrayValue();
+        array->heap = this;
+        counters.allocations++;
+        counters.allocatedBytes += sizeof(ArrayValue);
+    }
+    if (array->elements.capacity() < size) {
+        array->elements.reserve(size);
+        counters.allocations++;
+        counters.allocatedBytes += size * sizeof(Value);
+    }
+    counters.liveArrays++;
+    return ArrayRef(array);
+}
+
+void ArrayHeap::recycle(ArrayValue* array) {
+    // Elements go first: arrays inside this one come back here too, while it still counts as live
+    array->elements.clear();
+    counters.liveArrays--;
+    if (!released && pool.size() < kPoolSize && array->elements.capacity() <= kPooledCapacity) {
+        pool.push_back(array);
+        return;
+    }
+    delete array;
+    if (released && counters.liveArrays == 0) delete this;
+}
+
+void ArrayHeap::release() {
+    for (ArrayValue* array : pool) delete array;
+    pool.clear();
+    released = true;
+    if (counters.liveArrays == 0) delete this;
+}
+
+ArrayHeap::~ArrayHeap() = default;
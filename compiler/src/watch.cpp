@@ -0,0 +1,92 @@
+#include "watch.h"
+#include <cerrno>
+#include <cstring>
+#include <filesystem>
+#include <stdexcept>
+#include <poll.h>
+#include <sys/inotify.h>
+#include <unistd.h>
+
+namespace fs = std::filesystem;
+
+FileWatcher::FileWatcher(std::function<void()> onChange) : onChange(std::move(onChange)) {
+    inotifyFd = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+    if (inotifyFd < 0) {
+        throw std::runtime_error(std::string("Could not watch files: ") + std::strerror(errno));
+    }
+    if (pipe(stopPipe) != 0) {
+        ::close(inotifyFd);
+        throw std::runtime_error(std::string("Could not create pipe: ") + std::strerror(errno));
+    }
+    thread = std::thread([this]() { loop(); });
+}
+
+FileWatcher::~FileWatcher() {
+    char stop = 0;
+    (void)!write(stopPipe[1], &stop, 1);
+    thread.join();
+    ::close(stopPipe[0]);
+    ::close(stopPipe[1]);
+    ::close(inotifyFd);
+}
+
+void FileWatcher::watch(const std::vector<std::string>& paths) {
+    std::lock_guard<std::mutex> guard(lock);
+    files.clear();
+    std::set<std::string> wanted;
+    for (const auto& path : paths) {
+        std::error_code ec;
+        fs::path absolute = fs::weakly_canonical(fs::absolute(path), ec);
+        if (ec) continue;
+        files.insert(absolute.string());
+        wanted.insert(absolute.parent_path().string());
+    }
+    for (auto it = directories.begin(); it != directories.end();) {
+        if (wanted.erase(it->second)) {
+            ++it;
+        } else {
+            inotify_rm_watch(inotifyFd, it->first);
+            it = directories.erase(it);
+        }
+    }
+    for (const auto& directory : wanted) {
+        int wd = inotify_add_watch(inotifyFd, directory.c_str(), IN_CLOSE_WRITE | IN_MOVED_TO);
+        if (wd >= 0) directories[wd] = directory;
+    }
+}
+
+bool FileWatcher::readChanges() {
+    alignas(inotify_event) char buffer[4096];
+    bool changed = false;
+    ssize_t n;
+    while ((n = read(inotifyFd, buffer, sizeof(buffer))) > 0) {
+        std::lock_guard<std::mutex> guard(lock);
+        for (char* p = buffer; p < buffer + n;) {
+            auto* event = reinterpret_cast<inotify_event*>(p);
+            auto directory = directories.find(event->wd);
+            if (event->len > 0 && directory != directories.end() &&
+                files.count(directory->second + "/" + event->name)) {
+                changed = true;
+            }
+            p += sizeof(inotify_event) + event->len;
+        }
+    }
+    return changed;
+}
+
+void FileWatcher::loop() {
+    pollfd fds[2] = {{inotifyFd, POLLIN, 0}, {stopPipe[0], POLLIN, 0}};
+    bool pending = false;
+    while (true) {
+        // While changes are pending, wait only until they have settled
+        int ready = poll(fds, 2, pending ? kSettleMs : -1);
+        if (ready < 0 && errno != EINTR) return;
+        if (fds[1].revents) return;
+        if (ready > 0 && (fds[0].revents & POLLIN)) {
+            pending |= readChanges();
+        } else if (ready == 0 && pending) {
+            pending = false;
+            onChange();
+        }
+    }
+}
@@ -0,0 +1,98 @@
+#include <cassert>
+#include <chrono>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <mutex>
+#include <set>
+#include <sstream>
+#include <thread>
+#include "../include/batch.h"
+
+namespace fs = std::filesystem;
+
+void testFindScripts() {
+    std::cout << "Testing script discovery..." << std::endl;
+
+    fs::path dir = fs::temp_directory_path() / "zpp_batch_test";
+    fs::remove_all(dir);
+    fs::create_directories(dir / "nested");
+    std::ofstream(dir / "b.zpp") << "int main() { }";
+    std::ofstream(dir / "a.zpp") << "int main() { }";
+    std::ofstream(dir / "nested" / "c.zpp") << "int main() { }";
+    std::ofstream(dir / "notes.txt") << "not a script";
+
+    auto scripts = findScripts(dir.string());
+    assert(scripts.size() == 3);
+    assert(fs::path(scripts[0]).filename() == "a.zpp");
+    assert(fs::path(scripts[1]).filename() == "b.zpp");
+    assert(fs::path(scripts[2]).filename() == "c.zpp");
+
+    bool threw = false;
+    try {
+        findScripts((dir / "missing").string());
+    } catch (const std::runtime_error&) {
+        threw = true;
+    }
+    assert(threw);
+
+    fs::remove_all(dir);
+    std::cout << "✓ Script discovery test passed" << std::endl;
+}
+
+void testRunBatch() {
+    std::cout << "Testing batch runs..." << std::endl;
+
+    std::vector<std::string> scripts;
+    for (int i = 0; i < 40; ++i) scripts.push_back("script" + std::to_string(i));
+
+    std::mutex lock;
+    std::set<std::thread::id> workers;
+    auto run = [&](const std::string& path, std::ostream& out) {
+        {
+            std::lock_guard<std::mutex> guard(lock);
+            workers.insert(std::this_thread::get_id());
+        }
+        // The first script is slow; the other workers steal what it would have run
+        if (path == "script0") std::this_thread::sleep_for(std::chrono::milliseconds(50));
+        if (path == "script7") throw std::runtime_error("broken");
+        out << "ran " << path;
+        return path == "script9" ? 3 : 0;
+    };
+    auto results = runBatch(scripts, run, 4);
+
+    assert(results.size() == scripts.size());
+    for (size_t i = 0; i < scripts.size(); ++i) {
+        assert(results[i].path == scripts[i]);
+        assert(results[i].seconds >= 0);
+    }
+    assert(results[1].status == 0 && results[1].output == "ran script1");
+    assert(results[7].status == 1 && results[7].output == "Error: broken\n");
+    assert(results[9].status == 3);
+    assert(results[0].seconds >= 0.04);
+    assert(workers.size() > 1);
+
+    std::ostringstream report;
+    assert(reportBatch(results, report) == 2);
+    assert(report.str().find("FAIL") != std::string::npos);
+    assert(report.str().find("    Error: broken") != std::string::npos);
+    assert(report.str().find("38 passed, 2 failed") != std::string::npos);
+
+    std::cout << "✓ Batch run test passed" << std::endl;
+}
+
+int main() {
+    std::cout << "=== BATCH TESTS ===" << std::endl << std::endl;
+
+    try {
+        testFindScripts();
+        testRunBatch();
+
+        std::cout << "\n=== ALL TESTS PASSED ===" << std::endl;
+        return 0;
+    } catch (const std::exception& e) {
+        std::cerr << "\n!!! TEST FAILED !!!" << std::endl;
+        std::cerr << "Error: " << e.what() << std::endl;
+        return 1;
+    }
+}
@@ -0,0 +1,253 @@
+#include <cassert>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include "../include/lexer.h"
+#include "../include/parser.h"
+#include "../include/ir.h"
+#include "../include/optimizer.h"
+#include "../include/cache.h"
+#include "../include/incremental.h"
+#include "../include/modules.h"
+
+namespace fs = std::filesystem;
+
+IRProgram compile(const std::string& source) {
+    Lexer lexer(source);
+    auto tokens = lexer.tokenize();
+    Parser parser(tokens);
+    auto ast = parser.parse();
+
+    IRGenerator irGen(ast);
+    auto ir = irGen.generate();
+    IROptimizer optimizer(ir);
+    optimizer.optimize();
+    return ir;
+}
+
+// Everything the interpreter reads from an instruction
+void assertSameIR(const IRProgram& a, const IRProgram& b) {
+    assert(a.functions.size() == b.functions.size());
+    assert(a.globalVariables == b.globalVariables);
+    for (size_t f = 0; f < a.functions.size(); ++f) {
+        const auto& x = a.functions[f];
+        const auto& y = b.functions[f];
+        assert(x.name == y.name && x.returnType == y.returnType && x.parameters == y.parameters);
+        assert(x.instructions.size() == y.instructions.size());
+        for (size_t i = 0; i < x.instructions.size(); ++i) {
+            const auto& p = x.instructions[i];
+            const auto& q = y.instructions[i];
+            assert(p.toString() == q.toString());
+            assert(p.label == q.label && p.prompt == q.prompt && p.cases == q.cases);
+            assert(p.site == q.site && p.native == q.native);
+        }
+    }
+}
+
+const char* kSource = R"(
+    int pick(int x) {
+        if (x == 1) {
+            return 10;
+        } elif (x == 2) {
+            return 20;
+        } elif (x == 3) {
+            return 30;
+        } elif (x == 4) {
+            return 40;
+        }
+        return input("? ");
+    }
+    int main() {
+        let arr: int = [1, 2, 3];
+        print(pick(len(arr)), "done");
+        quit();
+    }
+)";
+
+void testSerializationRoundTrip() {
+    std::cout << "Testing IR serialization round trip..." << std::endl;
+
+    auto ir = compile(kSource);
+    std::string data = serializeIR(ir);
+    auto restored = deserializeIR(data.data(), data.size());
+    assertSameIR(ir, restored);
+
+    // Truncated data is rejected rather than half-loaded
+    bool rejected = false;
+    try {
+        deserializeIR(data.data(), data.size() / 2);
+    } catch (const std::runtime_error&) {
+        rejected = true;
+    }
+    assert(rejected);
+
+    std::cout << "✓ Serialization round trip test passed" << std::endl;
+}
+
+void testCacheHitsAndMisses() {
+    std::cout << "Testing compile cache hits and misses..." << std::endl;
+
+    fs::path dir = fs::temp_directory_path() / "zpp_cache_test";
+    fs::remove_all(dir);
+    CompileCache cache(dir.string());
+
+    auto ir = compile(kSource);
+    std::string key = CompileCache::key(kSource, "");
+    assert(key != CompileCache::key(kSource, "profile-use 1"));
+    assert(key != CompileCache::key(std::string(kSource) + " ", ""));
+
+    IRProgram loaded;
+    assert(!cache.load(key, loaded));
+    cache.store(key, ir);
+    assert(cache.load(key, loaded));
+    assertSameIR(ir, loaded);
+
+    // A damaged entry is a miss and is removed
+    for (const auto& entry : fs::directory_iterator(dir)) {
+        std::ofstream(entry.path(), std::ios::binary) << "ZPPC garbage";
+    }
+    assert(!cache.load(key, loaded));
+    assert(fs::is_empty(dir));
+
+    fs::remove_all(dir);
+    std::cout << "✓ Cache hit and miss test passed" << std::endl;
+}
+
+void testCacheEviction() {
+    std::cout << "Testing compile cache eviction..." << std::endl;
+
+    fs::path dir = fs::temp_directory_path() / "zpp_cache_evict_test";
+    fs::remove_all(dir);
+
+    auto ir = compile(kSource);
+    uint64_t entrySize = serializeIR(ir).size() + 4;
+    CompileCache cache(dir.string(), entrySize * 2);
+
+    cache.store("a", ir);
+    cache.store("b", ir);
+    fs::last_write_time(dir / "a.zppc", fs::file_time_type::clock::now() - std::chrono::hours(2));
+    fs::last_write_time(dir / "b.zppc", fs::file_time_type::clock::now() - std::chrono::hours(1));
+
+    // Loading a refreshes it, so b is the least recently used when c arrives
+    IRProgram loaded;
+    assert(cache.load("a", loaded));
+    cache.store("c", ir);
+    assert(fs::exists(dir / "a.zppc"));
+    assert(!fs::exists(dir / "b.zppc"));
+    assert(fs::exists(dir / "c.zppc"));
+
+    fs::remove_all(dir);
+    std::cout << "✓ Cache eviction test passed" << std::endl;
+}
+
+void testIncrementalCompile() {
+    std::cout << "Testing incremental compilation..." << std::endl;
+
+    fs::path dir = fs::temp_directory_path() / "zpp_incremental_test";
+    fs::remove_all(dir);
+    CompileCache cache(dir.string());
+
+    std::string source = R"(
+        int sq(int a) { return a * a; }
+        int twice(int a) { return sq(a) + sq(a); }
+        int other(int n) { return n - 1; }
+        int main() {
+            print(twice(3), other(2));
+        }
+    )";
+
+    Lexer lexer(source);
+    std::vector<FunctionUnit> units;
+    assert(splitFunctions(lexer.tokenize(), units));
+    assert(units.size() == 4 && units[1].name == "twice");
+    assert((units[1].callees == std::vector<std::string>{"sq", "sq"}));
+
+    IncrementalCompiler compiler(cache, "");
+    auto first = compiler.compile(source);
+    assert(compiler.compiledCount() == 4 && compiler.reusedCount() == 0);
+    assertSameIR(first, compile(source));
+
+    auto second = compiler.compile(source);
+    assert(compiler.compiledCount() == 0 && compiler.reusedCount() == 4);
+    assertSameIR(first, second);
+
+    // Editing sq recompiles it and everything that may have inlined it
+    std::string edited = source;
+    edited.replace(edited.find("a * a"), 5, "a + a");
+    auto third = compiler.compile(edited);
+    assert(compiler.compiledCount() == 3 && compiler.reusedCount() == 1);
+    assert(third.functions[2].name == "other");
+    assertSameIR(third, compile(edited));
+
+    fs::remove_all(dir);
+    std::cout << "✓ Incremental compilation test passed" << std::endl;
+}
+
+void writeFile(const fs::path& path, const std::string& text) {
+    fs::create_directories(path.parent_path());
+    std::ofstream(path) << text;
+}
+
+void testModules() {
+    std::cout << "Testing multi-file modules..." << std::endl;
+
+    fs::path dir = fs::temp_directory_path() / "zpp_modules_test";
+    fs::remove_all(dir);
+    std::string entry = "import \"lib/sq.zpp\";\nimport \"twice.zpp\";\nint main() { print(twice(3)); }\n";
+    writeFile(dir / "main.zpp", entry);
+    writeFile(dir / "lib/sq.zpp", "import \"../twice.zpp\";\nint sq(int a) { return a * a; }\n");
+    writeFile(dir / "twice.zpp", "import \"lib/sq.zpp\";\nint twice(int a) { return sq(a) + sq(a); }\n");
+
+    // Imports resolve against the importing file; the cycle loads each file once
+    auto modules = loadModules((dir / "main.zpp").string(), entry);
+    assert(modules.size() == 3);
+    assert(fs::path(modules[1].path).filename() == "sq.zpp");
+    assert((modules[0].imports == std::vector<size_t>{1, 2}));
+    assert((modules[1].imports == std::vector<size_t>{2}));
+    assert((modules[2].imports == std::vector<size_t>{1}));
+
+    // Each module keeps its own functions; calls between modules stay calls
+    CompileCache cache((dir / "cache").string());
+    auto serial = compileModules(modules, nullptr, "", nullptr, nullptr, 1);
+    auto parallel = compileModules(modules, &cache, "", nullptr, nullptr, 3);
+    assertSameIR(serial, parallel);
+    assert(serial.functions.size() == 3);
+    assert(serial.functions[1].name == "sq" && serial.functions[2].name == "twice");
+    bool calls = false;
+    for (const auto& instr : serial.functions[2].instructions) {
+        if (instr.opcode == IROpCode::CALL && instr.label == "sq") calls = true;
+    }
+    assert(calls);
+
+    // A function defined in two modules is an error
+    writeFile(dir / "twice.zpp", "int twice(int a) { return a; }\nint main() { }\n");
+    bool threw = false;
+    try {
+        compileModules(loadModules((dir / "main.zpp").string(), entry), nullptr, "");
+    } catch (const std::runtime_error& e) {
+        threw = std::string(e.what()).find("'main' is defined in both") != std::string::npos;
+    }
+    assert(threw);
+
+    fs::remove_all(dir);
+    std::cout << "✓ Multi-file module test passed" << std::endl;
+}
+
+int main() {
+    std::cout << "=== CACHE TESTS ===" << std::endl << std::endl;
+
+    try {
+        testSerializationRoundTrip();
+        testCacheHitsAndMisses();
+        testCacheEviction();
+        testIncrementalCompile();
+        testModules();
+
+        std::cout << "\n=== ALL TESTS PASSED ===" << std::endl;
+        return 0;
+    } catch (const std::exception& e) {
+        std::cerr << "\n!!! TEST FAILED !!!" << std::endl;
+        std::cerr << "Error: " << e.what() << std::endl;
+        return 1;
+    }
+}
@@ -0,0 +1,424 @@
+#include <atomic>
+#include <cassert>
+#include <cstdlib>
+#include <iostream>
+#include <sstream>
+#include <thread>
+#include "../include/engine.h"
+
+EngineConfig uncached() {
+    EngineConfig config;
+    config.useCache = false;
+    return config;
+}
+
+void testRunInstance() {
+    std::cout << "Testing running an instance..." << std::endl;
+
+    Engine engine(uncached());
+    ModulePtr module = engine.compile(R"(
+        int main() {
+            string name = input("name? ");
+            print("hi ");
+            print(name);
+        }
+    )");
+    assert(module->hasFunction("main"));
+
+    std::istringstream in("zpp\n");
+    std::ostringstream out;
+    Instance instance(module, in, out);
+    instance.run();
+    assert(out.str() == "name? hi zpp");
+    assert(!instance.halted());
+
+    std::cout << "✓ Instance run test passed" << std::endl;
+}
+
+void testCallFunctions() {
+    std::cout << "Testing calling functions directly..." << std::endl;
+
+    Engine engine(uncached());
+    ModulePtr module = engine.compile(R"(
+        int fib(int n) {
+            if (n < 2) { return n; }
+            return fib(n - 1) + fib(n - 2);
+        }
+        string greet(string who) { return who; }
+        int stop() {
+            quit();
+            return 1;
+        }
+    )");
+
+    std::ostringstream out;
+    Instance instance(module, std::cin, out);
+    assert(std::get<int>(instance.call("fib", {Value(20)})) == 6765);
+    assert(std::get<std::string>(instance.call("greet", {Value(std::string("zpp"))})) == "zpp");
+
+    bool threw = false;
+    try {
+        instance.call("missing");
+    } catch (const std::runtime_error&) {
+        threw = true;
+    }
+    assert(threw);
+
+    // quit() ends the instance for good
+    instance.call("stop");
+    assert(instance.halted());
+    assert(std::get<int>(instance.call("fib", {Value(5)})) == 0);
+
+    std::cout << "✓ Function call test passed" << std::endl;
+}
+
+void testSharedModule() {
+    std::cout << "Testing one module shared by concurrent instances..." << std::endl;
+
+    Engine engine(uncached());
+    ModulePtr module = engine.compile(R"(
+        int sum(int n) {
+            int total = 0;
+            for (int i = 1; i <= n; i = i + 1) { total = total + i; }
+            return total;
+        }
+        int main() {
+            string n = input("");
+            print(sum(n * 1));
+        }
+    )");
+
+    const int kThreads = 8;
+    std::vector<std::string> outputs(kThreads);
+    std::vector<std::thread> threads;
+    for (int t = 0; t < kThreads; ++t) {
+        threads.emplace_back([&, t]() {
+            std::istringstream in(std::to_string(100 * (t + 1)) + "\n");
+            std::ostringstream out;
+            for (int run = 0; run < 20; ++run) {
+                in.clear();
+                in.seekg(0);
+                Instance instance(module, in, out);
+                instance.run();
+            }
+            outputs[t] = out.str();
+        });
+    }
+    for (auto& thread : threads) thread.join();
+
+    for (int t = 0; t < kThreads; ++t) {
+        int n = 100 * (t + 1);
+        std::string expected;
+        for (int run = 0; run < 20; ++run) expected += std::to_string(n * (n + 1) / 2);
+        assert(outputs[t] == expected);
+    }
+
+    std::cout << "✓ Shared module test passed" << std::endl;
+}
+
+void testMemoryCache() {
+    std::cout << "Testing the engine's module cache..." << std::endl;
+
+    EngineConfig config = uncached();
+    config.memoryCacheEntries = 2;
+    Engine engine(config);
+    std::string a = "int main() { print(1); }";
+    std::string b = "int main() { print(2); }";
+    std::string c = "int main() { print(3); }";
+
+    ModulePtr first = engine.compile(a);
+    assert(engine.compile(a) == first);
+    engine.compile(b);
+    engine.compile(c);  // Evicts a, the least recently used
+    assert(engine.compile(a) != first);
+
+    Engine uncachedEngine(uncached());
+    assert(uncachedEngine.compile(a) != uncachedEngine.compile(a));
+
+    std::cout << "✓ Module cache test passed" << std::endl;
+}
+
+double mix(double a, double b, double t) { return a + (b - a) * t; }
+int textLength(const std::string& text) { return static_cast<int>(text.size()); }
+std::string repeat(std::string text, int times) {
+    std::string out;
+    for (int i = 0; i < times; ++i) out += text;
+    return out;
+}
+bool isEven(int n) { return n % 2 == 0; }
+int arraySum(ArrayRef array) {
+    int total = 0;
+    for (const auto& element : array->elements) total += valueToInt(element);
+    return total;
+}
+int callCount = 0;
+void countCall() { callCount++; }
+void shout(Instance& instance, const std::string& text) { instance.output() << text << "!"; }
+
+void testBoundNatives() {
+    std::cout << "Testing bound native functions..." << std::endl;
+
+    Engine engine(uncached());
+    engine.bind("mix", &mix);
+    engine.bind("textLength", &textLength);
+    engine.bind("repeat", &repeat);
+    engine.bind("isEven", &isEven);
+    engine.bind("arraySum", &arraySum);
+    engine.bind("countCall", &countCall);
+    engine.bind("shout", &shout);
+
+    ModulePtr module = engine.compile(R"(
+        int main() {
+            print(mix(1.0, 3.0, 0.25));
+            print(" ");
+            print(textLength("four"));
+            print(" ");
+            print(repeat("ab", 3));
+            print(" ");
+            print(isEven(10));
+            print(" ");
+            print(arraySum([1, 2, 3, 4]));
+            print(" ");
+            print(mix(0, 10, 1));
+            for (int i = 0; i < 5; i = i + 1) { countCall(); }
+            shout("done");
+        }
+    )");
+    std::ostringstream out;
+    Instance instance(module, std::cin, out);
+    instance.run();
+    assert(out.str() == "1.5 4 ababab true 10 10done!");
+    assert(callCount == 5);
+
+    std::cout << "✓ Bound native test passed" << std::endl;
+}
+
+void testBindErrors() {
+    std::cout << "Testing bind errors..." << std::endl;
+
+    Engine engine(uncached());
+    engine.bind("isEven", &isEven);
+
+    bool threw = false;
+    try {
+        engine.bind("isEven", &isEven);
+    } catch (const std::runtime_error&) {
+        threw = true;
+    }
+    assert(threw);
+
+    threw = false;
+    try {
+        engine.bind("len", &textLength);
+    } catch (const std::runtime_error&) {
+        threw = true;
+    }
+    assert(threw);
+
+    threw = false;
+    try {
+        engine.compile("int main() { print(isEven(1, 2)); }");
+    } catch (const std::runtime_error& e) {
+        threw = std::string(e.what()) == "isEven expects 1 argument(s), got 2";
+    }
+    assert(threw);
+
+    // Modules compiled before a bind keep calling what they were compiled against
+    ModulePtr before = engine.compile("int main() { print(isEven(3)); }");
+    engine.bind("textLength", &textLength);
+    std::ostringstream out;
+    Instance(before, std::cin, out).run();
+    assert(out.str() == "false");
+
+    std::cout << "✓ Bind error test passed" << std::endl;
+}
+
+void testMemoryStats() {
+    std::cout << "Testing memory statistics..." << std::endl;
+
+    Engine engine(uncached());
+    ModulePtr module = engine.compile(R"(
+        int total() {
+            int sum = 0;
+            for (int i = 0; i < 100; i = i + 1) {
+                int row = [i, i, i];
+                sum = sum + row[0] + row[2];
+            }
+            return sum;
+        }
+        string digits() {
+            string s = "";
+            for (int i = 0; i < 50; i = i + 1) { s = (s, i % 10); }
+            return s;
+        }
+        int makeArray() { return [7, 8, 9]; }
+    )");
+
+    std::ostringstream out;
+    Instance instance(module, std::cin, out);
+    assert(std::get<int>(instance.call("total")) == 9900);
+    const MemoryStats& stats = instance.memoryStats();
+    assert(stats.arrays == 100);
+    assert(stats.arraysReused == 98);  // row still holds the last array while the next is made
+    assert(stats.liveArrays == 0);
+
+    std::string text = std::get<std::string>(instance.call("digits"));
+    assert(text.size() == 50 && text.substr(0, 12) == "012345678901");
+    assert(stats.strings == 50);
+    assert(stats.stringsReused > 0);
+    assert(stats.allocations < stats.arrays + stats.strings);
+
+    // Arrays handed out stay valid after their instance is gone
+    Value kept;
+    {
+        Instance scoped(module, std::cin, out);
+        kept = scoped.call("makeArray");
+    }
+    const ArrayRef& array = std::get<ArrayRef>(kept);
+    assert(array->elements.size() == 3 && std::get<int>(array->elements[2]) == 9);
+
+    std::cout << "✓ Memory stats test passed" << std::endl;
+}
+
+void testStringAppend() {
+    std::cout << "Testing appending to strings..." << std::endl;
+
+    Engine engine(uncached());
+    ModulePtr module = engine.compile(R"(
+        string build(int n) {
+            string s = "";
+            for (int i = 0; i < n; i = i + 1) { s = (s, "x=", i, ";"); }
+            return s;
+        }
+        string tricky() {
+            string s = "ab";
+            s = (s, s, "|");
+            int x = 1;
+            s = (s, x, x = 5, x);
+            return s;
+        }
+    )");
+
+    std::ostringstream out;
+    Instance instance(module, std::cin, out);
+    assert(std::get<std::string>(instance.call("build", {Value(3)})) == "x=0;x=1;x=2;");
+
+    // Appends land in place, so the buffer grows a handful of times rather than once per append
+    uint64_t before = instance.memoryStats().allocations;
+    std::string text = std::get<std::string>(instance.call("build", {Value(2000)}));
+    assert(text.size() == 2000 * 3 + 10 + 90 * 2 + 900 * 3 + 1000 * 4);
+    assert(instance.memoryStats().allocations - before < 40);
+
+    // Parts that read or write the string itself see it as it was before the statement
+    assert(std::get<std::string>(instance.call("tricky")) == "abab|155");
+
+    std::cout << "✓ String append test passed" << std::endl;
+}
+
+void testExecutionLimits() {
+    std::cout << "Testing execution limits..." << std::endl;
+
+    Engine engine(uncached());
+    ModulePtr module = engine.compile(R"(
+        int spin() {
+            int i = 0;
+            while (true) { i = i + 1; }
+            return i;
+        }
+        int dive(int n) { return dive(n + 1) + 1; }
+        int count(int n) {
+            int total = 0;
+            for (int i = 0; i < n; i = i + 1) { total = total + 1; }
+            return total;
+        }
+    )");
+    std::ostringstream out;
+    Instance instance(module, std::cin, out);
+
+    auto interrupted = [&](const std::string& function, const std::string& message) {
+        try {
+            instance.call(function, {Value(0)});
+        } catch (const ScriptInterrupted& e) {
+            return std::string(e.what()).find(message) != std::string::npos;
+        }
+        return false;
+    };
+
+    instance.setInstructionLimit(100000);
+    assert(interrupted("spin", "limit of 100000 instructions"));
+    assert(interrupted("dive", "limit of 100000 instructions"));
+    assert(std::get<int>(instance.call("count", {Value(1000)})) == 1000);  // Each run gets the full budget
+
+    instance.setInstructionLimit(0);
+    instance.setTimeLimit(std::chrono::milliseconds(50));
+    auto start = std::chrono::steady_clock::now();
+    assert(interrupted("spin", "time limit of 50 ms"));
+    assert(std::chrono::steady_clock::now() - start < std::chrono::seconds(5));
+
+    // interrupt() from another thread
+    instance.setTimeLimit(std::chrono::milliseconds(0));
+    std::atomic<bool> done(false);
+    std::thread stopper([&]() {
+        while (!done) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(10));
+            instance.interrupt();
+        }
+    });
+    assert(interrupted("spin", "interrupted"));
+    done = true;
+    stopper.join();
+    assert(std::get<int>(instance.call("count", {Value(10)})) == 10);
+
+    std::cout << "✓ Execution limit test passed" << std::endl;
+}
+
+void testMissingGraphicsPlugin() {
+    std::cout << "Testing scripts without the graphics plugin..." << std::endl;
+
+    // The plugin is only looked for when a window opens; without it, drawing does nothing
+    setenv("ZPP_GRAPHICS_PLUGIN", "/nonexistent/libzpp_graphics.so", 1);
+    Engine engine(uncached());
+    ModulePtr module = engine.compile(R"(
+        int main() {
+            print("start ");
+            screen(64, 48, "test");
+            drawRect(1, 1, 5, 5, 255, 0, 0, 1);
+            display();
+            print(isKeyDown("a"));
+        }
+    )");
+    std::ostringstream out;
+    std::ostringstream err;
+    Instance instance(module, std::cin, out, err);
+    instance.run();
+    assert(out.str() == "start 0");
+    assert(err.str().find("Graphics plugin unavailable") != std::string::npos);
+    assert(instance.window() == nullptr);
+    unsetenv("ZPP_GRAPHICS_PLUGIN");
+
+    std::cout << "✓ Missing graphics plugin test passed" << std::endl;
+}
+
+int main() {
+    std::cout << "=== ENGINE TESTS ===" << std::endl << std::endl;
+
+    try {
+        testRunInstance();
+        testCallFunctions();
+        testSharedModule();
+        testMemoryCache();
+        testBoundNatives();
+        testBindErrors();
+        testMemoryStats();
+        testStringAppend();
+        testExecutionLimits();
+        testMissingGraphicsPlugin();
+
+        std::cout << "\n=== ALL TESTS PASSED ===" << std::endl;
+        return 0;
+    } catch (const std::exception& e) {
+        std::cerr << "\n!!! TEST FAILED !!!" << std::endl;
+        std::cerr << "Error: " << e.what() << std::endl;
+        return 1;
+    }
+}
@@ -3,6 +3,7 @@
 #include "../include/lexer.h"
 #include "../include/parser.h"
 #include "../include/ir.h"
+#include "../include/builtins.h"
 
 void testBasicIRGeneration() {
     std::cout << "Testing basic IR generation..." << std::endl;
@@ -134,6 +135,97 @@ void testIfStatement() {
     std::cout << "✓ If statement test passed" << std::endl;
 }
 
+void testIfWithoutElse() {
+    std::cout << "Testing if statement without else in IR..." << std::endl;
+    
+    std::string source = R"(
+        int main() {
+            int x = 5;
+            if (x > 0) {
+                x = 1;
+            }
+            return x;
+        }
+    )";
+    
+    Lexer lexer(source);
+    auto tokens = lexer.tokenize();
+    Parser parser(tokens);
+    auto ast = parser.parse();
+    
+    IRGenerator irGen(ast);
+    auto ir = irGen.generate();
+    
+    // A single branch over the then block: no else label, no jump to the end
+    int jumps = 0;
+    int labels = 0;
+    for (const auto& instr : ir.functions[0].instructions) {
+        if (instr.opcode == IROpCode::JMP) jumps++;
+        if (instr.opcode == IROpCode::LABEL) labels++;
+    }
+    assert(jumps == 0);
+    assert(labels == 1);
+    
+    std::cout << "✓ If without else test passed" << std::endl;
+}
+
+void testElifChainDispatch() {
+    std::cout << "Testing elif chain lowering to jump tables..." << std::endl;
+    
+    std::string source = R"(
+        int dense(int s) {
+            if (s == 0) { return 10; } elif (s == 1) { return 11; } elif (s == 3) { return 13; } elif (s == 4) { return 14; } else { return 0; }
+        }
+        int sparse(int s) {
+            if (s == 5) { return 1; } elif (s == 900) { return 2; } elif (-40 == s) { return 3; } elif (s == 70000) { return 4; }
+            return 0;
+        }
+        int shortChain(int s) {
+            if (s == 0) { return 1; } elif (s == 1) { return 2; } else { return 3; }
+        }
+    )";
+    
+    Lexer lexer(source);
+    auto tokens = lexer.tokenize();
+    Parser parser(tokens);
+    auto ast = parser.parse();
+    
+    IRGenerator irGen(ast);
+    auto ir = irGen.generate();
+    
+    auto findDispatch = [](const IRFunction& func) -> const IRInstruction* {
+        for (const auto& instr : func.instructions) {
+            if (instr.opcode == IROpCode::JUMP_TABLE || instr.opcode == IROpCode::SWITCH) return &instr;
+            assert(instr.opcode != IROpCode::EQ);
+        }
+        return nullptr;
+    };
+    
+    // Dense values index a table; the hole at 2 goes to the else branch
+    const IRInstruction* table = findDispatch(ir.functions[0]);
+    assert(table && table->opcode == IROpCode::JUMP_TABLE);
+    assert(table->cases.size() == 5);
+    assert(table->cases.front().first == 0);
+    assert(table->cases[2].second == table->label);
+    
+    // Sparse values are searched in sorted order
+    const IRInstruction* search = findDispatch(ir.functions[1]);
+    assert(search && search->opcode == IROpCode::SWITCH);
+    assert(search->cases.size() == 4);
+    assert(search->cases.front().first == -40);
+    assert(search->cases.back().first == 70000);
+    
+    // Short chains keep their compares
+    bool hasEq = false;
+    for (const auto& instr : ir.functions[2].instructions) {
+        assert(instr.opcode != IROpCode::JUMP_TABLE && instr.opcode != IROpCode::SWITCH);
+        if (instr.opcode == IROpCode::EQ) hasEq = true;
+    }
+    assert(hasEq);
+    
+    std::cout << "✓ Elif chain dispatch test passed" << std::endl;
+}
+
 void testWhileLoop() {
     std::cout << "Testing while loop in IR..." << std::endl;
     
@@ -388,6 +480,104 @@ void testArrayLenIR() {
     std::cout << "✓ Array len IR test passed" << std::endl;
 }
 
+void testBuiltinCalls() {
+    std::cout << "Testing builtin call resolution..." << std::endl;
+
+    std::string source = R"(
+        int main() {
+            updateInput();
+            int k = isKeyDown("a");
+            clearScreen(0, 0, 0);
+            quit();
+            return k;
+        }
+    )";
+
+    Lexer lexer(source);
+    auto tokens = lexer.tokenize();
+    Parser parser(tokens);
+    auto ast = parser.parse();
+
+    IRGenerator irGen(ast);
+    auto ir = irGen.generate();
+
+    // Natives carry their registry id; builtins with an opcode use it directly
+    std::vector<int> natives;
+    bool hasClear = false;
+    for (const auto& instr : ir.functions[0].instructions) {
+        assert(instr.opcode != IROpCode::CALL);
+        if (instr.opcode == IROpCode::CALL_NATIVE) natives.push_back(instr.native);
+        if (instr.opcode == IROpCode::CLEAR_SCREEN) hasClear = instr.operands.size() == 3;
+    }
+    assert((natives == std::vector<int>{NATIVE_UPDATE_INPUT, NATIVE_IS_KEY_DOWN, NATIVE_QUIT}));
+    assert(hasClear);
+    assert(nativeBuiltin(NATIVE_IS_KEY_DOWN).name == "isKeyDown");
+    assert(findBuiltin("main") == nullptr);
+
+    // Arity is checked when the call is lowered
+    Lexer badLexer("int main() { drawPixel(1, 2); }");
+    auto badTokens = badLexer.tokenize();
+    Parser badParser(badTokens);
+    auto badAst = badParser.parse();
+    IRGenerator badGen(badAst);
+    bool rejected = false;
+    try {
+        badGen.generate();
+    } catch (const std::runtime_error&) {
+        rejected = true;
+    }
+    assert(rejected);
+
+    std::cout << "✓ Builtin call test passed" << std::endl;
+}
+
+void testShortCircuitLogical() {
+    std::cout << "Testing short-circuit logical operators in IR..." << std::endl;
+    
+    std::string source = R"(
+        int main() {
+            int a = 0;
+            int b = 5;
+            if (a == 1 || b > 0) {
+                return 1;
+            }
+            int c = a == 0 && b > 0;
+            return c;
+        }
+    )";
+    
+    Lexer lexer(source);
+    auto tokens = lexer.tokenize();
+    Parser parser(tokens);
+    auto ast = parser.parse();
+    
+    IRGenerator irGen(ast);
+    auto ir = irGen.generate();
+    
+    const auto& instrs = ir.functions[0].instructions;
+    
+    // || branches over its right operand instead of concatenating
+    bool hasJnz = false;
+    for (const auto& instr : instrs) {
+        assert(instr.opcode != IROpCode::CONCAT);
+        assert(instr.opcode != IROpCode::AND && instr.opcode != IROpCode::OR);
+        if (instr.opcode == IROpCode::JNZ) hasJnz = true;
+    }
+    assert(hasJnz);
+    
+    // The right-hand comparison of && comes after a conditional jump
+    size_t firstJump = instrs.size();
+    size_t lastGt = 0;
+    for (size_t i = 0; i < instrs.size(); ++i) {
+        if (instrs[i].opcode == IROpCode::STORE && instrs[i].result.name == "c") break;
+        if (instrs[i].opcode == IROpCode::JZ && firstJump == instrs.size()) firstJump = i;
+        if (instrs[i].opcode == IROpCode::GT) lastGt = i;
+    }
+    assert(firstJump < lastGt);
+    
+    std::cout << "✓ Short-circuit logical operators test passed" << std::endl;
+}
+
 int main() {
     std::cout << "=== IR GENERATOR TESTS ===" << std::endl << std::endl;
     
@@ -396,11 +586,15 @@ int main() {
         testBinaryOperations();
         testVariableDeclaration();
         testIfStatement();
+        testIfWithoutElse();
+        testElifChainDispatch();
         testWhileLoop();
         testForLoop();
         testFunctionCall();
         testArrayLenIR();
+        testBuiltinCalls();
         testUnaryOperations();
+        testShortCircuitLogical();
         testIRInstructionToString();
         testComplexExpression();
         testMultipleFunctions();
@@ -0,0 +1,694 @@
+#include <cassert>
+#include <cstdio>
+#include <stdexcept>
+#include <iostream>
+#include <sstream>
+#include <set>
+#include "../include/lexer.h"
+#include "../include/parser.h"
+#include "../include/ir.h"
+#include "../include/optimizer.h"
+#include "../include/engine.h"
+#include "../include/profile.h"
+
+IRProgram lower(const std::string& source) {
+    Lexer lexer(source);
+    auto tokens = lexer.tokenize();
+    Parser parser(tokens);
+    auto ast = parser.parse();
+
+    IRGenerator irGen(ast);
+    return irGen.generate();
+}
+
+// run: Output of the program's main, interpreted as given
+std::string run(IRProgram ir) {
+    std::ostringstream out;
+    Instance(std::make_shared<Module>(std::move(ir)), std::cin, out).run();
+    return out.str();
+}
+
+// optimizedMatchesRaw: Does optimizing the program leave its output unchanged?
+bool optimizedMatchesRaw(const std::string& source, const std::string& expected) {
+    IRProgram ir = lower(source);
+    IRProgram optimized = ir;
+    IROptimizer(optimized).optimize();
+    return run(ir) == expected && run(optimized) == expected;
+}
+
+int countOpcode(const IRFunction& func, IROpCode opcode) {
+    int count = 0;
+    for (const auto& instr : func.instructions) {
+        if (instr.opcode == opcode) count++;
+    }
+    return count;
+}
+
+void testLoopTripCount() {
+    std::cout << "Testing loop trip count analysis..." << std::endl;
+
+    auto ir = lower(R"(
+        int main() {
+            int sum = 0;
+            for (let i: int = 2; i < 12; i = i + 3) {
+                sum = sum + i;
+            }
+            return sum;
+        }
+    )");
+
+    auto loops = findLoops(ir.functions[0]);
+    assert(loops.size() == 1);
+    assert(loops[0].hasInduction);
+    assert(loops[0].inductionVar.name == "i");
+    assert(loops[0].step == 3);
+    assert(loops[0].hasStart && loops[0].start == 2);
+    assert(loops[0].tripCount == 4);
+
+    std::cout << "✓ Loop trip count test passed" << std::endl;
+}
+
+void testUnknownTripCount() {
+    std::cout << "Testing loop with runtime bound..." << std::endl;
+
+    auto ir = lower(R"(
+        int main(int n) {
+            int i = 0;
+            while (i < n) {
+                i = i + 1;
+            }
+            return i;
+        }
+    )");
+
+    auto loops = findLoops(ir.functions[0]);
+    assert(loops.size() == 1);
+    assert(loops[0].hasInduction);
+    assert(loops[0].boundInvariant);
+    assert(loops[0].tripCount == -1);
+
+    std::cout << "✓ Runtime bound test passed" << std::endl;
+}
+
+void testStrengthReduction() {
+    std::cout << "Testing strength reduction of induction variable products..." << std::endl;
+
+    auto ir = lower(R"(
+        int main() {
+            let tiles: int = [0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0];
+            for (let i: int = 0; i < 3; i = i + 1) {
+                tiles[i * 4] = 1;
+            }
+            return 0;
+        }
+    )");
+
+    // Run the loop passes alone; the full pipeline would unroll this loop
+    IROptimizer optimizer(ir);
+    optimizer.optimizeLoops(ir.functions[0]);
+
+    auto loops = findLoops(ir.functions[0]);
+    assert(loops.size() == 1);
+
+    // No multiplication left inside the loop body
+    for (size_t i = loops[0].header; i <= loops[0].latch; ++i) {
+        assert(ir.functions[0].instructions[i].opcode != IROpCode::MUL);
+    }
+
+    std::cout << "✓ Strength reduction test passed" << std::endl;
+}
+
+void testLoopRotation() {
+    std::cout << "Testing loop rotation to a single compare-and-branch..." << std::endl;
+
+    auto ir = lower(R"(
+        int main() {
+            int sum = 0;
+            for (let i: int = 0; i < 10; i = i + 1) {
+                sum = sum + i;
+            }
+            return sum;
+        }
+    )");
+
+    // Analyze before register allocation merges the constant temps
+    IROptimizer optimizer(ir);
+    optimizer.optimizeLoops(ir.functions[0]);
+
+    const auto& func = ir.functions[0];
+    auto loops = findLoops(func);
+    assert(loops.size() == 1);
+    assert(loops[0].rotated);
+    assert(loops[0].tripCount == 10);
+
+    // Guard JZ plus latch JNZ; no unconditional back edge
+    assert(countOpcode(func, IROpCode::JMP) == 0);
+    assert(countOpcode(func, IROpCode::JNZ) == 1);
+
+    // The constant bound is not reloaded on every iteration
+    for (size_t i = loops[0].header; i <= loops[0].latch; ++i) {
+        assert(func.instructions[i].opcode != IROpCode::LOAD_INT ||
+               func.instructions[i].operands[0].name != "10");
+    }
+
+    std::cout << "✓ Loop rotation test passed" << std::endl;
+}
+
+void testBoundsCheckElimination() {
+    std::cout << "Testing bounds check elimination..." << std::endl;
+
+    auto ir = lower(R"(
+        int main() {
+            let arr: int = [1, 2, 3, 4];
+            int sum = 0;
+            for (let i: int = 0; i < len(arr); i = i + 1) {
+                sum = sum + arr[i];
+                arr[i] = 0;
+                sum = sum + arr[i + 1];
+            }
+            return sum;
+        }
+    )");
+
+    IROptimizer optimizer(ir);
+    optimizer.eliminateBoundsChecks(ir.functions[0]);
+
+    const auto& func = ir.functions[0];
+    assert(countOpcode(func, IROpCode::LOAD_INDEX_UNCHECKED) == 1);
+    assert(countOpcode(func, IROpCode::STORE_INDEX_UNCHECKED) == 1);
+
+    // arr[i + 1] can run past the end and keeps its check
+    assert(countOpcode(func, IROpCode::LOAD_INDEX) == 1);
+
+    std::cout << "✓ Bounds check elimination test passed" << std::endl;
+}
+
+void testBoundsCheckKeptForUnknownStart() {
+    std::cout << "Testing bounds check kept when the range is unproven..." << std::endl;
+
+    auto ir = lower(R"(
+        int main(int k) {
+            let arr: int = [1, 2, 3, 4];
+            int sum = 0;
+            for (let i: int = k; i < len(arr); i = i + 1) {
+                sum = sum + arr[i];
+            }
+            for (let j: int = 0; j < 8; j = j + 1) {
+                sum = sum + arr[j];
+            }
+            return sum;
+        }
+    )");
+
+    IROptimizer optimizer(ir);
+    optimizer.optimize();
+
+    assert(countOpcode(ir.functions[0], IROpCode::LOAD_INDEX_UNCHECKED) == 0);
+
+    std::cout << "✓ Unproven range test passed" << std::endl;
+}
+
+void testBoundsCheckKeptForUnprovenArray() {
+    std::cout << "Testing bounds check kept when the array's length is unproven..." << std::endl;
+
+    // The array literal is stored in the preheader: its length is known
+    auto known = lower(R"(
+        int main() {
+            let arr: int = [1, 2, 3, 4];
+            int sum = 0;
+            for (let i: int = 0; i < 4; i = i + 1) { sum = sum + arr[i]; }
+            return sum;
+        }
+    )");
+    IROptimizer(known).eliminateBoundsChecks(known.functions[0]);
+    assert(countOpcode(known.functions[0], IROpCode::LOAD_INDEX_UNCHECKED) == 1);
+
+    // A parameter, whatever is stored to it after the loop
+    auto parameter = lower(R"(
+        int f(int a, int n) {
+            if (n > 0) { return f(a, n - 1); }
+            let s: int = 0;
+            for (let i: int = 0; i < 4; i = i + 1) { s = s + a[i]; }
+            a = [1, 2, 3, 4];
+            return s;
+        }
+        int g(int a, int n) {
+            for (let i: int = 0; i < n; i = i + 1) { a[i] = 0; }
+            n = len(a);
+            return n;
+        }
+    )");
+    IROptimizer(parameter).optimize();
+    for (const auto& func : parameter.functions) {
+        assert(countOpcode(func, IROpCode::LOAD_INDEX_UNCHECKED) == 0);
+        assert(countOpcode(func, IROpCode::STORE_INDEX_UNCHECKED) == 0);
+    }
+
+    // A REPL entry, where a holds a session variable until the store after the loop
+    auto entry = lower(R"(
+        void entry() {
+            let t: int = 0;
+            for (let k: int = 0; k < 4; k = k + 1) { t = t + a[k]; }
+            a = [1, 2, 3, 4];
+        }
+    )");
+    IROptimizer(entry).optimize();
+    assert(countOpcode(entry.functions[0], IROpCode::LOAD_INDEX_UNCHECKED) == 0);
+
+    std::cout << "✓ Unproven array test passed" << std::endl;
+}
+
+void testInlining() {
+    std::cout << "Testing inlining of small functions..." << std::endl;
+
+    auto ir = lower(R"(
+        int add(int a, int b) {
+            return a + b;
+        }
+        int fact(int n) {
+            if (n < 2) { return 1; }
+            return n * fact(n - 1);
+        }
+        int main() {
+            let x: int = add(3, 4);
+            return x + fact(5);
+        }
+    )");
+
+    IROptimizer optimizer(ir);
+    optimizer.optimize();
+
+    const auto& main = ir.functions[2];
+    assert(main.name == "main");
+
+    // add() is gone, recursive fact() stays a call
+    assert(countOpcode(main, IROpCode::CALL) == 1);
+    for (const auto& instr : main.instructions) {
+        if (instr.opcode == IROpCode::CALL) assert(instr.label == "fact");
+    }
+
+    // 3 + 4 folds once the body is inlined
+    bool folded = false;
+    for (const auto& instr : main.instructions) {
+        if (instr.opcode == IROpCode::LOAD_INT && instr.operands[0].name == "7") folded = true;
+        assert(instr.opcode != IROpCode::ADD || instr.operands[0].name != "l_add.i0.a");
+    }
+    assert(folded);
+
+    std::cout << "✓ Inlining test passed" << std::endl;
+}
+
+void testInlinedLocalsStartUnset() {
+    std::cout << "Testing inlined calls start with fresh locals..." << std::endl;
+
+    // c is only assigned for large n: every other call must read it as unset, as a real call does
+    assert(optimizedMatchesRaw(R"(
+        int pick(int n) { int c; if (n > 100) { c = 7; } return c; }
+        int main() {
+            for (int i = 0; i < 3; i = i + 1) {
+                int v = 5;
+                if (i == 0) { v = 150; }
+                print(pick(v));
+            }
+        }
+    )", "700"));
+
+    std::cout << "✓ Inlined locals test passed" << std::endl;
+}
+
+void testConstantFolding() {
+    std::cout << "Testing constant folding of branches..." << std::endl;
+
+    auto ir = lower(R"(
+        int main() {
+            let x: int = 2 * 3;
+            if (x > 10) {
+                print(1);
+            }
+            let y: int = 1 / 0;
+            return y;
+        }
+    )");
+
+    IROptimizer optimizer(ir);
+    optimizer.foldConstants(ir.functions[0]);
+
+    const auto& func = ir.functions[0];
+    assert(countOpcode(func, IROpCode::MUL) == 0);
+    assert(countOpcode(func, IROpCode::JZ) == 0);
+    assert(countOpcode(func, IROpCode::PRINT) == 0);
+
+    // Division by zero is left for the VM to report
+    assert(countOpcode(func, IROpCode::DIV) == 1);
+
+    std::cout << "✓ Constant folding test passed" << std::endl;
+}
+
+void testTailCallElimination() {
+    std::cout << "Testing tail call elimination..." << std::endl;
+
+    auto ir = lower(R"(
+        int sumTo(int n, int acc) {
+            if (n == 0) { return acc; }
+            return sumTo(n - 1, acc + n);
+        }
+        int isEven(int n) {
+            if (n == 0) { return 1; }
+            return isOdd(n - 1);
+        }
+        int isOdd(int n) {
+            if (n == 0) { return 0; }
+            return isEven(n - 1);
+        }
+        int fib(int n) {
+            if (n < 2) { return n; }
+            return fib(n - 1) + fib(n - 2);
+        }
+    )");
+
+    IROptimizer optimizer(ir);
+    for (auto& func : ir.functions) optimizer.eliminateTailCalls(func);
+
+    // Self recursion becomes a jump back to the entry
+    const auto& sumTo = ir.functions[0];
+    assert(countOpcode(sumTo, IROpCode::CALL) == 0);
+    assert(countOpcode(sumTo, IROpCode::TAIL_CALL) == 0);
+    assert(sumTo.instructions[0].opcode == IROpCode::LABEL);
+    assert(sumTo.instructions.back().opcode == IROpCode::JMP);
+    assert(sumTo.instructions.back().label == sumTo.instructions[0].label);
+
+    // Mutual recursion reuses the frame
+    assert(countOpcode(ir.functions[1], IROpCode::TAIL_CALL) == 1);
+    assert(countOpcode(ir.functions[2], IROpCode::TAIL_CALL) == 1);
+
+    // fib's calls feed an ADD and are not in tail position
+    assert(countOpcode(ir.functions[3], IROpCode::CALL) == 2);
+    assert(countOpcode(ir.functions[3], IROpCode::TAIL_CALL) == 0);
+
+    std::cout << "✓ Tail call elimination test passed" << std::endl;
+}
+
+void testTailCallLocalsStartUnset() {
+    std::cout << "Testing tail calls start with fresh locals..." << std::endl;
+
+    // b is only assigned on the first call; the calls after it must read it as unset
+    assert(optimizedMatchesRaw(R"(
+        int walk(int n, int acc) {
+            int b;
+            if (n == 5) { b = 100; }
+            if (n == 0) { return acc; }
+            return walk(n - 1, acc + b);
+        }
+        int main() { print(walk(5, 0)); }
+    )", "100"));
+
+    std::cout << "✓ Tail call locals test passed" << std::endl;
+}
+
+void testRegisterAllocation() {
+    std::cout << "Testing register allocation of temps..." << std::endl;
+
+    auto ir = lower(R"(
+        int main() {
+            let a: int = 1 + 2 * 3;
+            let b: int = a * 4 - 5;
+            let c: int = (a + b) * (a - b);
+            print(a);
+            print(b);
+            print(c);
+            int sum = 0;
+            for (let i: int = 0; i < 10; i = i + 1) {
+                sum = sum + i * 2;
+            }
+            print(sum);
+            return 0;
+        }
+    )");
+
+    IROptimizer optimizer(ir);
+    auto& func = ir.functions[0];
+    optimizer.optimizeLoops(func);
+    auto before = findLoops(func);
+    assert(before.size() == 1);
+    IRValue bound = before[0].bound;
+    size_t bodyStart = before[0].header;
+    size_t bodyEnd = before[0].latch;
+
+    optimizer.allocateRegisters(func);
+
+    std::set<int> registers;
+    for (const auto& instr : func.instructions) {
+        if (instr.result.type == IRValue::Type::TEMP && instr.result.id >= 0) registers.insert(instr.result.id);
+    }
+    assert(registers.size() < 8);
+    assert(*registers.rbegin() == static_cast<int>(registers.size()) - 1);
+
+    // The loop bound is loaded before the loop and stays live across it
+    int boundRegister = -1;
+    for (size_t i = 0; i < bodyStart; ++i) {
+        const auto& instr = func.instructions[i];
+        if (instr.opcode == IROpCode::LOAD_INT && instr.operands[0].name == "10") boundRegister = instr.result.id;
+    }
+    assert(bound.type == IRValue::Type::TEMP && boundRegister >= 0);
+    for (size_t i = bodyStart; i <= bodyEnd; ++i) {
+        const auto& instr = func.instructions[i];
+        assert(instr.result.type != IRValue::Type::TEMP || instr.result.id != boundRegister);
+    }
+
+    std::cout << "✓ Register allocation test passed" << std::endl;
+}
+
+void testJumpThreading() {
+    std::cout << "Testing jump threading and block layout..." << std::endl;
+
+    auto ir = lower(R"(
+        int main(int x) {
+            int r = 0;
+            if (x < 0) {
+                r = 1;
+            } elif (x < 10) {
+                if (x < 5) {
+                    r = 2;
+                } else {
+                    r = 3;
+                }
+            } else {
+                r = 4;
+            }
+            return r;
+        }
+    )");
+
+    IROptimizer optimizer(ir);
+    auto& func = ir.functions[0];
+    optimizer.simplifyControlFlow(func);
+
+    std::set<std::string> targets;
+    for (const auto& instr : func.instructions) {
+        if (instr.opcode == IROpCode::JMP || instr.opcode == IROpCode::JZ || instr.opcode == IROpCode::JNZ) {
+            targets.insert(instr.label);
+        }
+    }
+    for (size_t i = 0; i < func.instructions.size(); ++i) {
+        const auto& instr = func.instructions[i];
+        if (instr.opcode != IROpCode::LABEL) continue;
+
+        // Every remaining label is a jump target, and none of them just jumps on
+        assert(targets.count(instr.label));
+        assert(i + 1 < func.instructions.size());
+        assert(func.instructions[i + 1].opcode != IROpCode::JMP);
+        assert(func.instructions[i + 1].opcode != IROpCode::LABEL);
+    }
+
+    // Nested arms return straight out instead of jumping to a shared return
+    assert(countOpcode(func, IROpCode::RET) > 1);
+
+    std::cout << "✓ Jump threading test passed" << std::endl;
+}
+
+void testLoopUnrolling() {
+    std::cout << "Testing loop unrolling..." << std::endl;
+
+    auto ir = lower(R"(
+        int main(int n) {
+            let arr: int = [0, 0, 0, 0, 0, 0, 0, 0];
+            for (let i: int = 0; i < 4; i = i + 1) {
+                arr[i * 2 + 1] = 1;
+            }
+            int sum = 0;
+            for (let j: int = 0; j < n; j = j + 1) {
+                sum = sum + j;
+            }
+            return sum;
+        }
+    )");
+
+    IROptimizer optimizer(ir);
+    auto& func = ir.functions[0];
+    optimizer.unrollLoops(func);
+
+    // The 4-trip loop is gone; the runtime-bound loop gains an unrolled copy before its remainder
+    auto loops = findLoops(func);
+    assert(loops.size() == 2);
+    for (const auto& loop : loops) assert(loop.inductionVar.name != "i");
+    assert(countOpcode(func, IROpCode::STORE_INDEX) == 4);
+    int stepsOfJ = 0;
+    for (const auto& instr : func.instructions) {
+        if (instr.opcode == IROpCode::STORE && instr.result.name == "j") stepsOfJ++;
+    }
+    assert(stepsOfJ == 1 + 4 + 1);  // Initialization, unrolled copies, remainder
+
+    // Per-iteration indices fold to constants
+    optimizer.foldConstants(func);
+    assert(countOpcode(func, IROpCode::MUL) == 0);
+
+    std::cout << "✓ Loop unrolling test passed" << std::endl;
+}
+
+void testProfileRoundTrip() {
+    std::cout << "Testing profile save and load..." << std::endl;
+
+    Profile profile;
+    profile.recordBranch(0x1234, true);
+    profile.recordBranch(0x1234, false);
+    profile.recordBranch(0x1234, true);
+    profile.recordTypes(0xabcdef0123456789ULL, PROFILE_INT);
+    profile.recordTypes(0xabcdef0123456789ULL, PROFILE_DOUBLE);
+
+    std::string path = "optimizer_test.prof";
+    uint64_t hash = hashText("int main() {}");
+    profile.save(path, hash);
+
+    Profile loaded = Profile::load(path, hash);
+    const ProfileCounts* branch = loaded.find(0x1234);
+    assert(branch && branch->executed == 3 && branch->trueCount == 2);
+    const ProfileCounts* types = loaded.find(0xabcdef0123456789ULL);
+    assert(types && types->types == (PROFILE_INT | PROFILE_DOUBLE));
+    assert(!loaded.find(0x999));
+
+    // A profile recorded from other source is rejected
+    bool rejected = false;
+    try {
+        Profile::load(path, hashText("int main() { print(1); }"));
+    } catch (const std::runtime_error&) {
+        rejected = true;
+    }
+    assert(rejected);
+    std::remove(path.c_str());
+
+    std::cout << "✓ Profile round trip test passed" << std::endl;
+}
+
+void testProfileGuidedOptimization() {
+    std::cout << "Testing profile-guided optimization..." << std::endl;
+
+    auto ir = lower(R"(
+        int main(int n) {
+            int s = 0;
+            if (n == 7) {
+                print(n);
+            }
+            s = s + n;
+            return s;
+        }
+    )");
+    auto& func = ir.functions[0];
+
+    // Profile: the print never ran and every operand was an int
+    Profile profile;
+    for (const auto& instr : func.instructions) {
+        if (instr.opcode == IROpCode::JZ) {
+            for (int i = 0; i < 100; ++i) profile.recordBranch(instr.site, false);
+        } else if (instr.opcode == IROpCode::ADD || instr.opcode == IROpCode::EQ) {
+            profile.recordTypes(instr.site, PROFILE_INT);
+        }
+    }
+
+    IROptimizer optimizer(ir, &profile);
+    optimizer.simplifyControlFlow(func);
+    optimizer.specializeTypes(func);
+
+    // The print moved behind the return and jumps back into the hot path
+    size_t ret = 0, print = 0;
+    for (size_t i = 0; i < func.instructions.size(); ++i) {
+        if (func.instructions[i].opcode == IROpCode::RET) ret = i;
+        if (func.instructions[i].opcode == IROpCode::PRINT) print = i;
+    }
+    assert(print > ret);
+    assert(func.instructions.back().opcode == IROpCode::JMP);
+
+    assert(countOpcode(func, IROpCode::ADD) == 0 && countOpcode(func, IROpCode::ADD_INT) == 1);
+    assert(countOpcode(func, IROpCode::EQ) == 0 && countOpcode(func, IROpCode::EQ_INT) == 1);
+
+    std::cout << "✓ Profile-guided optimization test passed" << std::endl;
+}
+
+void testProfiledInliningKeepsHotCalls() {
+    std::cout << "Testing profiled inlining of calls inlined while recording..." << std::endl;
+
+    // Too big to inline at every site, so only its single call site lets it inline
+    const char* source = R"(
+        int mix(int x) {
+            int a = x * 3 + 1;
+            int b = a * a - x;
+            int c = b % 7 + a % 5;
+            if (c > 4) { c = c - 4; } else { c = c + x % 3; }
+            int d = a + b * c - x * 2;
+            if (d % 2 == 0) { d = d / 2; }
+            return d % 1000 + c;
+        }
+        int main() {
+            int total = 0;
+            for (int i = 0; i < 5000; i = i + 1) { total = (total + mix(i)) % 100000; }
+            print(total);
+        }
+    )";
+
+    // Recorded from the optimized program, where mix() was inlined and never ran as a CALL
+    IRProgram recorded = lower(source);
+    IROptimizer(recorded).optimize();
+    assert(countOpcode(recorded.functions[1], IROpCode::CALL) == 0);
+    Profile profile;
+    std::ostringstream out;
+    Instance instance(std::make_shared<Module>(std::move(recorded)), std::cin, out);
+    instance.setProfile(&profile);
+    instance.run();
+
+    IRProgram ir = lower(source);
+    IROptimizer(ir, &profile).optimize();
+    assert(countOpcode(ir.functions[1], IROpCode::CALL) == 0);
+
+    std::cout << "✓ Profiled hot call inlining test passed" << std::endl;
+}
+
+int main() {
+    std::cout << "=== OPTIMIZER TESTS ===" << std::endl << std::endl;
+
+    try {
+        testLoopTripCount();
+        testUnknownTripCount();
+        testStrengthReduction();
+        testLoopRotation();
+        testBoundsCheckElimination();
+        testBoundsCheckKeptForUnknownStart();
+        testBoundsCheckKeptForUnprovenArray();
+        testLoopUnrolling();
+        testInlining();
+        testInlinedLocalsStartUnset();
+        testConstantFolding();
+        testTailCallElimination();
+        testTailCallLocalsStartUnset();
+        testJumpThreading();
+        testRegisterAllocation();
+        testProfileRoundTrip();
+        testProfileGuidedOptimization();
+        testProfiledInliningKeepsHotCalls();
+
+        std::cout << "\n=== ALL TESTS PASSED ===" << std::endl;
+        return 0;
+    } catch (const std::exception& e) {
+        std::cerr << "\n!!! TEST FAILED !!!" << std::endl;
+        std::cerr << "Error: " << e.what() << std::endl;
+        return 1;
+    }
+}
@@ -349,6 +349,31 @@ void testArrayLenProperty() {
     std::cout << "✓ Array len property test passed" << std::endl;
 }
 
+void testImport() {
+    std::cout << "Testing import declarations..." << std::endl;
+
+    Lexer lexer("import \"lib/math.zpp\"; int main() { return 0; } import \"util.zpp\";");
+    auto tokens = lexer.tokenize();
+    Parser parser(tokens);
+    auto program = parser.parse();
+
+    assert((program->imports == std::vector<std::string>{"lib/math.zpp", "util.zpp"}));
+    assert(program->functions.size() == 1);
+
+    bool threw = false;
+    try {
+        Lexer bad("import math; int main() { return 0; }");
+        auto badTokens = bad.tokenize();
+        Parser badParser(badTokens);
+        badParser.parse();
+    } catch (const std::runtime_error&) {
+        threw = true;
+    }
+    assert(threw);
+
+    std::cout << "✓ Import declaration test passed" << std::endl;
+}
+
 int main() {
     std::cout << "=== PARSER TESTS ===" << std::endl << std::endl;
     
@@ -371,6 +396,7 @@ int main() {
         testArrayLiteral();
         testArrayElementAssignment();
         testArrayLenProperty();
+        testImport();
         
         std::cout << "\n=== ALL TESTS PASSED ===" << std::endl;
         return 0;
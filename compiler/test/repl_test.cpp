@@ -0,0 +1,130 @@
+#include <cassert>
+#include <iostream>
+#include <sstream>
+#include "../include/repl.h"
+
+EngineConfig uncached() {
+    EngineConfig config;
+    config.useCache = false;
+    return config;
+}
+
+void testEntryCompleteness() {
+    std::cout << "Testing entry completeness..." << std::endl;
+
+    assert(ReplSession::complete("int x = 1;\n"));
+    assert(ReplSession::complete("int twice(int n) {\n return n * 2;\n}\n"));
+    assert(!ReplSession::complete("int twice(int n) {\n"));
+    assert(!ReplSession::complete("print(twice(\n"));
+    assert(!ReplSession::complete("int x = 1\n"));
+
+    std::cout << "✓ Entry completeness test passed" << std::endl;
+}
+
+void testPersistentState() {
+    std::cout << "Testing state kept between entries..." << std::endl;
+
+    Engine engine(uncached());
+    std::istringstream in;
+    std::ostringstream out;
+    ReplSession session(engine, in, out);
+
+    session.submit("int x = 20;");
+    session.submit("int twice(int n) { return n * 2; }");
+    session.submit("x = twice(x) + 2;");
+    session.submit("print(x);");
+    assert(out.str() == "42");
+    assert(std::get<int>(session.variables().at("x")) == 42);
+
+    // Functions see later redefinitions of the functions they call
+    session.submit("int quad(int n) { return twice(twice(n)); }");
+    session.submit("int twice(int n) { return n + n + 1; }");
+    out.str("");
+    session.submit("quad(1);");
+    assert(out.str() == "7\n");
+
+    // Including callers compiled in the same entry as the function they call
+    session.submit("int f(int a) { return a + 1; } int g(int a) { return f(a) * 10; }");
+    session.submit("int f(int a) { return a + 2; }");
+    out.str("");
+    session.submit("f(1);");
+    session.submit("g(1);");
+    assert(out.str() == "3\n30\n");
+
+    // Trailing expressions with a value are shown; assignments and void calls aren't
+    out.str("");
+    session.submit("x + 1;");
+    session.submit("x = 5;");
+    session.submit("void noop() { }");
+    session.submit("noop();");
+    assert(out.str() == "43\n");
+
+    std::cout << "✓ Persistent state test passed" << std::endl;
+}
+
+void testErrorsKeepSession() {
+    std::cout << "Testing errors inside a session..." << std::endl;
+
+    Engine engine(uncached());
+    std::istringstream in;
+    std::ostringstream out;
+    ReplSession session(engine, in, out);
+    session.submit("int total = 3;");
+
+    bool threw = false;
+    try {
+        session.submit("int arr = [1, 2]; total = 10; arr[5];");
+    } catch (const std::runtime_error&) {
+        threw = true;
+    }
+    assert(threw);
+    assert(std::get<int>(session.variables().at("total")) == 10);  // Variables set before the error stay
+
+    threw = false;
+    try {
+        session.submit("int broken( {");
+    } catch (const std::runtime_error&) {
+        threw = true;
+    }
+    assert(threw);
+    session.submit("total;");
+    assert(out.str() == "10\n");
+
+    std::cout << "✓ Session error test passed" << std::endl;
+}
+
+void testRunRepl() {
+    std::cout << "Testing the read-eval-print loop..." << std::endl;
+
+    Engine engine(uncached());
+    std::istringstream in("int fib(int n) {\n  if (n < 2) { return n; }\n  return fib(n - 1) + fib(n - 2);\n}\n"
+                          "fib(15);\nint broken = ;\nfib(10);\n:quit\nfib(5);\n");
+    std::ostringstream out;
+    std::ostringstream err;
+    runRepl(engine, in, out, err);
+    assert(out.str().find("610\n") != std::string::npos);
+    assert(out.str().find("55\n") != std::string::npos);
+    assert(out.str().find("...> ") != std::string::npos);
+    assert(out.str().find("\n5\n") == std::string::npos);  // Nothing runs after :quit
+    assert(err.str().find("Error: ") == 0);
+
+    std::cout << "✓ REPL loop test passed" << std::endl;
+}
+
+int main() {
+    std::cout << "=== REPL TESTS ===" << std::endl << std::endl;
+
+    try {
+        testEntryCompleteness();
+        testPersistentState();
+        testErrorsKeepSession();
+        testRunRepl();
+
+        std::cout << "\n=== ALL TESTS PASSED ===" << std::endl;
+        return 0;
+    } catch (const std::exception& e) {
+        std::cerr << "\n!!! TEST FAILED !!!" << std::endl;
+        std::cerr << "Error: " << e.what() << std::endl;
+        return 1;
+    }
+}
@@ -22,7 +22,7 @@ void testBasicVariableDeclaration() {
     SemanticAnalyzer analyzer(ast);
     analyzer.analyze();
     
-    assert(!SemanticAnalyzer::hasErrors());
+    assert(!analyzer.hasErrors());
     std::cout << "✓ Basic variable declaration test passed" << std::endl;
 }
 
@@ -43,7 +43,7 @@ void testUndefinedVariable() {
     SemanticAnalyzer analyzer(ast);
     analyzer.analyze();
     
-    assert(SemanticAnalyzer::hasErrors());
+    assert(analyzer.hasErrors());
     std::cout << "✓ Undefined variable error test passed" << std::endl;
 }
 
@@ -92,7 +92,7 @@ void testUndefinedFunction() {
     SemanticAnalyzer analyzer(ast);
     analyzer.analyze();
     
-    assert(SemanticAnalyzer::hasErrors());
+    assert(analyzer.hasErrors());
     std::cout << "✓ Undefined function error test passed" << std::endl;
 }
 
@@ -139,7 +139,7 @@ void testVariableScopeLocalVsGlobal() {
     SemanticAnalyzer analyzer(ast);
     analyzer.analyze();
     
-    assert(SemanticAnalyzer::hasErrors());
+    assert(analyzer.hasErrors());
     std::cout << "✓ Variable scope test passed" << std::endl;
 }
 
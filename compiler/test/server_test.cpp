@@ -0,0 +1,131 @@
+#include <cassert>
+#include <csignal>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <cstring>
+#include <fcntl.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <sys/wait.h>
+#include <unistd.h>
+#include "../include/server.h"
+
+namespace fs = std::filesystem;
+
+// forwardCapturingOutput: Forward a request with stdout redirected to a file, returning the status
+int forwardCapturingOutput(const std::string& socketPath, const std::vector<std::string>& args,
+                           const fs::path& outputPath, std::string& output) {
+    std::cout.flush();
+    int saved = dup(STDOUT_FILENO);
+    int file = open(outputPath.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    dup2(file, STDOUT_FILENO);
+    close(file);
+    int status = forward(socketPath, args);
+    dup2(saved, STDOUT_FILENO);
+    close(saved);
+
+    std::ifstream in(outputPath);
+    std::stringstream buffer;
+    buffer << in.rdbuf();
+    output = buffer.str();
+    return status;
+}
+
+// connectRaw: A connection to the server that sends nothing by itself
+int connectRaw(const std::string& socketPath) {
+    sockaddr_un address;
+    std::memset(&address, 0, sizeof(address));
+    address.sun_family = AF_UNIX;
+    std::strncpy(address.sun_path, socketPath.c_str(), sizeof(address.sun_path) - 1);
+    int fd = socket(AF_UNIX, SOCK_STREAM, 0);
+    assert(fd >= 0);
+    assert(connect(fd, reinterpret_cast<sockaddr*>(&address), sizeof(address)) == 0);
+    return fd;
+}
+
+void testForwardWithoutServer() {
+    std::cout << "Testing forward without a server..." << std::endl;
+
+    fs::path socketPath = fs::temp_directory_path() / "zpp_server_test_none.sock";
+    fs::remove(socketPath);
+    assert(forward(socketPath.string(), {"script.zpp"}) == -1);
+
+    std::cout << "✓ Forward without server test passed" << std::endl;
+}
+
+void testServeRequests() {
+    std::cout << "Testing requests served over the socket..." << std::endl;
+
+    fs::path dir = fs::temp_directory_path() / "zpp_server_test";
+    fs::remove_all(dir);
+    fs::create_directories(dir);
+    std::string socketPath = (dir / "zpp.sock").string();
+
+    pid_t server = fork();
+    if (server == 0) {
+        int prepared = 0;  // Lives in the server, so it counts across requests
+        serve(socketPath, [&](const ServerRequest& request) -> std::function<int()> {
+            if (request.args.empty()) throw std::runtime_error("no arguments");
+            prepared++;
+            return [request, prepared]() {
+                char cwd[4096];
+                std::cout << getcwd(cwd, sizeof(cwd)) << " " << prepared;
+                for (const auto& arg : request.args) std::cout << " " << arg;
+                return static_cast<int>(request.args.size());
+            };
+        });
+        _exit(1);
+    }
+
+    std::string output;
+    int status = -1;
+    for (int attempt = 0; attempt < 200 && status < 0; ++attempt) {
+        status = forwardCapturingOutput(socketPath, {"a", "b"}, dir / "out1", output);
+        if (status < 0) usleep(10000);
+    }
+    // The job ran with the client's working directory and wrote to the client's stdout
+    assert(status == 2);
+    assert(output == fs::current_path().string() + " 1 a b");
+
+    assert(forwardCapturingOutput(socketPath, {"c"}, dir / "out2", output) == 1);
+    assert(output == fs::current_path().string() + " 2 c");
+
+    // A request the handler rejects fails with status 1 instead of stopping the server
+    assert(forwardCapturingOutput(socketPath, {}, dir / "out3", output) == 1);
+    assert(forwardCapturingOutput(socketPath, {"d", "e", "f"}, dir / "out4", output) == 3);
+
+    // A client that connects and stalls, or sends a size without its streams, holds up nobody else
+    int idle = connectRaw(socketPath);
+    int partial = connectRaw(socketPath);
+    uint32_t size = 8;
+    assert(write(partial, &size, sizeof(size)) == static_cast<ssize_t>(sizeof(size)));
+    assert(forwardCapturingOutput(socketPath, {"g"}, dir / "out5", output) == 1);
+    assert(output == fs::current_path().string() + " 4 g");
+    char byte;
+    assert(read(partial, &byte, 1) == 0);  // Dropped for arriving without the streams
+    close(partial);
+    close(idle);
+
+    kill(server, SIGTERM);
+    waitpid(server, nullptr, 0);
+    fs::remove_all(dir);
+    std::cout << "✓ Served requests test passed" << std::endl;
+}
+
+int main() {
+    std::cout << "=== SERVER TESTS ===" << std::endl << std::endl;
+
+    try {
+        testForwardWithoutServer();
+        testServeRequests();
+
+        std::cout << "\n=== ALL TESTS PASSED ===" << std::endl;
+        return 0;
+    } catch (const std::exception& e) {
+        std::cerr << "\n!!! TEST FAILED !!!" << std::endl;
+        std::cerr << "Error: " << e.what() << std::endl;
+        return 1;
+    }
+}
@@ -0,0 +1,168 @@
+#include <cassert>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include "../include/engine.h"
+
+namespace fs = std::filesystem;
+
+EngineConfig uncached() {
+    EngineConfig config;
+    config.useCache = false;
+    return config;
+}
+
+// The snapshot is taken inside setup(), with main waiting on it and arrays shared between variables
+const char* kScript = R"(
+    int setup(int size) {
+        int table = [0, 0, 0, 0, 0, 0, 0, 0];
+        for (int i = 0; i < size; i = i + 1) { table[i] = i * i; }
+        int names = ["zero", "one"];
+        int both = [table, names, table, 2.5, true];
+        string label = "ready";
+        print("init ");
+        if (snapshot() == 1) { print("resumed "); }
+        print(label);
+        return both;
+    }
+    int main() {
+        int both = setup(8);
+        int first = both[0];
+        int third = both[2];
+        first[3] = 100;
+        int names = both[1];
+        print(" ");
+        print(third[3] + third[7]);
+        print(" ");
+        print(names[1]);
+        print(" ");
+        print(both[3]);
+        print(" ");
+        print(both[4]);
+    }
+)";
+
+fs::path snapshotDir() {
+    fs::path dir = fs::temp_directory_path() / "zpp_snapshot_test";
+    fs::remove_all(dir);
+    fs::create_directories(dir);
+    return dir;
+}
+
+void testSaveAndResume() {
+    std::cout << "Testing saving and resuming a run..." << std::endl;
+
+    fs::path path = snapshotDir() / "script.snap";
+    Engine engine(uncached());
+    ModulePtr module = engine.compile(kScript);
+
+    std::ostringstream first;
+    Instance saving(module, std::cin, first);
+    saving.setSnapshotFile(path.string());
+    saving.run();
+    assert(first.str() == "init ready 149 one 2.5 1");
+    assert(fs::exists(path));
+
+    // Resuming skips everything before snapshot(), and the arrays are still shared
+    std::ostringstream second;
+    Instance resumed(engine.compile(kScript), std::cin, second);
+    assert(resumed.restore(path.string()));
+    resumed.run();
+    assert(second.str() == "resumed ready 149 one 2.5 1");
+    assert(resumed.memoryStats().arrays == 3);
+
+    // Only the next run resumes
+    second.str("");
+    resumed.run();
+    assert(second.str() == "init ready 149 one 2.5 1");
+
+    // Without a snapshot file, snapshot() does nothing
+    std::ostringstream plain;
+    Instance(module, std::cin, plain).run();
+    assert(plain.str() == "init ready 149 one 2.5 1");
+
+    fs::remove_all(path.parent_path());
+    std::cout << "✓ Save and resume test passed" << std::endl;
+}
+
+void testRejectedSnapshots() {
+    std::cout << "Testing snapshots that can't be used..." << std::endl;
+
+    fs::path dir = snapshotDir();
+    fs::path path = dir / "script.snap";
+    Engine engine(uncached());
+    ModulePtr module = engine.compile(kScript);
+    std::ostringstream out;
+    Instance saving(module, std::cin, out);
+    saving.setSnapshotFile(path.string());
+    saving.run();
+
+    // Another program, even one that differs only by a constant
+    std::string edited = kScript;
+    edited.replace(edited.find("i * i"), 5, "i + i");
+    Instance other(engine.compile(edited), std::cin, out);
+    assert(!other.restore(path.string()));
+
+    Instance missing(module, std::cin, out);
+    assert(!missing.restore((dir / "missing.snap").string()));
+
+    // Damaged files are ignored rather than trusted
+    std::string bytes;
+    {
+        std::ifstream in(path, std::ios::binary);
+        bytes.assign(std::istreambuf_iterator<char>(in), std::istreambuf_iterator<char>());
+    }
+    fs::path truncated = dir / "truncated.snap";
+    std::ofstream(truncated, std::ios::binary).write(bytes.data(), bytes.size() / 2);
+    fs::path garbage = dir / "garbage.snap";
+    std::string noise(bytes.size(), '\x7f');
+    noise.replace(0, 32, bytes.substr(0, 32));  // A valid header over nonsense
+    std::ofstream(garbage, std::ios::binary) << noise;
+
+    std::ostringstream fresh;
+    Instance damaged(module, std::cin, fresh);
+    assert(!damaged.restore(truncated.string()));
+    assert(!damaged.restore(garbage.string()));
+    damaged.run();
+    assert(fresh.str() == "init ready 149 one 2.5 1");
+
+    fs::remove_all(dir);
+    std::cout << "✓ Rejected snapshot test passed" << std::endl;
+}
+
+void testSnapshotErrors() {
+    std::cout << "Testing snapshot errors..." << std::endl;
+
+    Engine engine(uncached());
+    std::ostringstream out;
+    ModulePtr module = engine.compile("int main() { snapshot(); }");
+    Instance unwritable(module, std::cin, out);
+    unwritable.setSnapshotFile("/nonexistent-dir/script.snap");
+    bool threw = false;
+    try {
+        unwritable.run();
+    } catch (const std::runtime_error& e) {
+        threw = std::string(e.what()).find("Could not write snapshot") != std::string::npos;
+    }
+    assert(threw);
+
+    std::cout << "✓ Snapshot error test passed" << std::endl;
+}
+
+int main() {
+    std::cout << "=== SNAPSHOT TESTS ===" << std::endl << std::endl;
+
+    try {
+        testSaveAndResume();
+        testRejectedSnapshots();
+        testSnapshotErrors();
+
+        std::cout << "\n=== ALL TESTS PASSED ===" << std::endl;
+        return 0;
+    } catch (const std::exception& e) {
+        std::cerr << "\n!!! TEST FAILED !!!" << std::endl;
+        std::cerr << "Error: " << e.what() << std::endl;
+        return 1;
+    }
+}
@@ -0,0 +1,154 @@
+#include <atomic>
+#include <cassert>
+#include <chrono>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <thread>
+#include "../include/engine.h"
+#include "../include/watch.h"
+
+namespace fs = std::filesystem;
+
+EngineConfig uncached() {
+    EngineConfig config;
+    config.useCache = false;
+    return config;
+}
+
+void writeFile(const fs::path& path, const std::string& text) {
+    std::ofstream(path) << text;
+}
+
+// waitFor: Poll until done() holds or two seconds pass
+template <typename Condition>
+bool waitFor(const Condition& done) {
+    for (int i = 0; i < 200 && !done(); ++i) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    }
+    return done();
+}
+
+void testFileWatcher() {
+    std::cout << "Testing file change notification..." << std::endl;
+
+    fs::path dir = fs::temp_directory_path() / "zpp_watch_test";
+    fs::remove_all(dir);
+    fs::create_directories(dir);
+    writeFile(dir / "game.zpp", "int main() { }\n");
+    writeFile(dir / "notes.txt", "");
+
+    std::atomic<int> changes(0);
+    FileWatcher watcher([&]() { changes++; });
+    watcher.watch({(dir / "game.zpp").string()});
+
+    writeFile(dir / "notes.txt", "unrelated");
+    std::this_thread::sleep_for(std::chrono::milliseconds(200));
+    assert(changes == 0);
+
+    // Several writes in a row are one change
+    writeFile(dir / "game.zpp", "int main() { print(1); }\n");
+    writeFile(dir / "game.zpp", "int main() { print(2); }\n");
+    assert(waitFor([&]() { return changes > 0; }));
+    std::this_thread::sleep_for(std::chrono::milliseconds(200));
+    assert(changes == 1);
+
+    // Saving by renaming a new file into place counts too
+    writeFile(dir / "game.zpp.tmp", "int main() { print(3); }\n");
+    fs::rename(dir / "game.zpp.tmp", dir / "game.zpp");
+    assert(waitFor([&]() { return changes == 2; }));
+
+    fs::remove_all(dir);
+    std::cout << "✓ File watcher test passed" << std::endl;
+}
+
+void testModuleFiles() {
+    std::cout << "Testing the source files of a module..." << std::endl;
+
+    fs::path dir = fs::temp_directory_path() / "zpp_watch_files_test";
+    fs::remove_all(dir);
+    fs::create_directories(dir);
+    writeFile(dir / "main.zpp", "import \"util.zpp\";\nint main() { print(half(8)); }\n");
+    writeFile(dir / "util.zpp", "int half(int n) { return n / 2; }\n");
+
+    Engine engine(uncached());
+    ModulePtr module = engine.compileFile((dir / "main.zpp").string());
+    assert(module->files().size() == 2);
+    assert(fs::path(module->files()[1]).filename() == "util.zpp");
+    assert(engine.compile("int main() { }")->files().empty());
+
+    fs::remove_all(dir);
+    std::cout << "✓ Module files test passed" << std::endl;
+}
+
+ModulePtr nextVersion;
+int frameCount() { return 6; }
+void swapVersion(Instance& instance) { instance.reload(nextVersion); }
+
+const char* kGame = R"(
+    int step(int n) { return n; }
+    int drawFrame(int total) {
+        display();
+        return total;
+    }
+    int main() {
+        int total = 0;
+        int frames = frameCount();
+        for (int frame = 0; frame < frames; frame = frame + 1) {
+            total = total + step(frame);
+            if (frame == 2) { swapVersion(); }
+            total = drawFrame(total);
+        }
+        print(total);
+    }
+)";
+
+void testReloadAtDisplay() {
+    std::cout << "Testing code reload at display()..." << std::endl;
+
+    Engine engine(uncached());
+    engine.bind("frameCount", &frameCount);
+    engine.bind("swapVersion", &swapVersion);
+    ModulePtr module = engine.compile(kGame);
+    std::string changed = kGame;
+    changed.replace(changed.find("return n;"), 9, "return n * 100;");
+    nextVersion = engine.compile(changed);
+
+    // Frames 0-2 run the first version and 3-5 the second; main's locals carry over
+    std::ostringstream out;
+    Instance instance(module, std::cin, out);
+    instance.setHeadless(true);
+    instance.run();
+    assert(out.str() == "1203");
+
+    // A function that no longer reaches the same display() finishes in its old code
+    changed = kGame;
+    changed.replace(changed.find("display();"), 10, "");
+    nextVersion = engine.compile(changed);
+    out.str("");
+    Instance stale(module, std::cin, out);
+    stale.setHeadless(true);
+    stale.run();
+    assert(out.str() == "15");
+
+    nextVersion = nullptr;
+    std::cout << "✓ Reload test passed" << std::endl;
+}
+
+int main() {
+    std::cout << "=== WATCH TESTS ===" << std::endl << std::endl;
+
+    try {
+        testFileWatcher();
+        testModuleFiles();
+        testReloadAtDisplay();
+
+        std::cout << "\n=== ALL TESTS PASSED ===" << std::endl;
+        return 0;
+    } catch (const std::exception& e) {
+        std::cerr << "\n!!! TEST FAILED !!!" << std::endl;
+        std::cerr << "Error: " << e.what() << std::endl;
+        return 1;
+    }
+}